@@ -0,0 +1,431 @@
+/*****************************************************************************************
+ *
+ *  @function 事件后端，将 XMNSocket 使用的 IO 多路复用机制（epoll 、io_uring）抽象为统一的接口。
+ *  @time   2020-04-12
+ *
+ *****************************************************************************************/
+#ifndef XMOON__INCLUDE_XMN_EVENT_BACKEND_H_
+#define XMOON__INCLUDE_XMN_EVENT_BACKEND_H_
+
+#include "base/noncopyable.h"
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <pthread.h>
+#include <stdint.h>
+
+#include <vector>
+
+struct XMNConnSockInfo;
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+/**
+ * 事件后端的类型。
+ * XMN_EVENT_BACKEND_EPOLL  epoll ，就绪通知，由 XMNSocket 自行调用 accept 、recv 。
+ * XMN_EVENT_BACKEND_URING  io_uring ，完成通知，accept 和 recv 由内核以 multishot 的方式完成。
+*/
+#define XMN_EVENT_BACKEND_EPOLL 0
+#define XMN_EVENT_BACKEND_URING 1
+
+/**
+ * @function    事件后端的接口。
+ *              事件统一以 epoll_event 的形式返回，data.ptr 指向对应的连接，
+ *              这样 EpollProcessEvents 对两种后端的事件分发方式保持一致。
+ * @time    2020-04-12
+*/
+class XMNEventBackend : public NonCopyable
+{
+public:
+    virtual ~XMNEventBackend(){};
+
+public:
+    /**
+     * @function    初始化事件后端，需要在 worker 进程中调用。
+     * @paras   none 。
+     * @ret  0   操作成功。
+     *          < 0 操作失败。
+     * @time    2020-04-12
+    */
+    virtual int Init() = 0;
+
+    /**
+     * @function    增加、删除、修改 fd 关注的事件，语义与 epoll_ctl 相同。
+     * @paras   kSockFd 被监控的 socket 。
+     *          kOption EPOLL_CTL_ADD 、EPOLL_CTL_MOD 、EPOLL_CTL_DEL 。
+     *          kEvents 修改之后完整的事件集合。
+     *          pconnsockinfo   该 socket 对应的连接。
+     * @ret  0   操作成功。
+     * @time    2020-04-12
+    */
+    virtual int Ctl(const int &kSockFd,
+                    const uint32_t &kOption,
+                    const uint32_t &kEvents,
+                    XMNConnSockInfo *pconnsockinfo) = 0;
+
+    /**
+     * @function    监控非 socket 的 fd（例如 timerfd ）的可读事件，事件以 EPOLLIN 返回。
+     *              该 fd 在事件后端释放之前一直被监控，由调用者负责读取和关闭。
+     * @paras   kFd 被监控的 fd 。
+     *          pconnsockinfo   该 fd 对应的连接，事件通过其 rhandler 分发。
+     * @ret  0   操作成功。
+     * @time    2020-04-19
+    */
+    virtual int AddReadableFd(const int &kFd, XMNConnSockInfo *pconnsockinfo) = 0;
+
+    /**
+     * @function    指定运行 Wait 的线程，默认为调用 Init 的线程。
+     * @paras   kThread 运行 Wait 的线程。
+     * @ret  none 。
+     * @time    2020-04-23
+    */
+    virtual void SetEventThread(const pthread_t &kThread){};
+
+    /**
+     * @function    等待事件。
+     * @paras   pevents 存放事件的数组。
+     *          kMaxEvents  pevents 的大小。
+     *          kTimer  超时时间，单位 ms ，-1 表示一直堵塞。
+     * @ret  >= 0    事件的数量。
+     *          -1  有错误发生，报错代码保存在 errno 中。
+     * @time    2020-04-12
+    */
+    virtual int Wait(struct epoll_event *pevents, const int &kMaxEvents, const int &kTimer) = 0;
+
+    /**
+     * @function    分发第 kIndex 个事件之前调用，将完成事件携带的结果交给对应的连接。
+     * @paras   kIndex  事件在 Wait 返回的数组中的下标。
+     * @ret  none 。
+     * @time    2020-04-12
+    */
+    virtual void PrepareEvent(const int &kIndex){};
+
+    /**
+     * @function    分发第 kIndex 个事件之后调用，回收该事件占用的资源。
+     * @paras   kIndex  事件在 Wait 返回的数组中的下标。
+     * @ret  none 。
+     * @time    2020-04-12
+    */
+    virtual void FinishEvent(const int &kIndex){};
+
+    /**
+     * @function    从监听 socket 上取出一个新连接，语义与 accept4 相同。
+     * @paras   plistenconnsockinfo 监听 socket 对应的连接。
+     *          paddr   存放 client 地址。
+     *          paddrlen    paddr 的长度。
+     *          kFlags  accept4 的 flags 。
+     * @ret  >= 0    新连接的 socket 。
+     *          -1  有错误发生，报错代码保存在 errno 中。
+     * @time    2020-04-12
+    */
+    virtual int Accept(XMNConnSockInfo *plistenconnsockinfo,
+                       struct sockaddr *paddr,
+                       socklen_t *paddrlen,
+                       const int &kFlags) = 0;
+
+    /**
+     * @function    从连接中接收数据，语义与 readv 相同，一次调用可以填满多段缓冲区。
+     * @paras   pconnsockinfo   待接收数据的连接。
+     *          piov    存放数据的缓冲区数组。
+     *          kIovCnt 缓冲区数组的元素个数。
+     * @ret  > 0 接收到的数据的字节数。
+     *          0   client 已经关闭。
+     *          -1  有错误发生，报错代码保存在 errno 中。
+     * @time    2020-04-12
+    */
+    virtual ssize_t Recv(XMNConnSockInfo *pconnsockinfo, const struct iovec *piov, const int &kIovCnt) = 0;
+
+    /**
+     * @function    向连接发送数据，语义与 writev 相同，对端关闭时不会产生 SIGPIPE 。
+     * @paras   pconnsockinfo   待发送数据的连接。
+     *          piov    待发送的数据的数组。
+     *          kIovCnt 数组的元素个数。
+     *          kFlags  sendmsg 的 flags 。
+     * @ret  >= 0    已发送的字节数。
+     *          -1  有错误发生，报错代码保存在 errno 中。
+     * @time    2020-04-12
+    */
+    virtual ssize_t Send(XMNConnSockInfo *pconnsockinfo, const struct iovec *piov, const int &kIovCnt, const int &kFlags) = 0;
+
+    /**
+     * @function    关闭连接的 socket ，关闭之前撤销该 socket 上所有未完成的请求。
+     *              可以在任意线程中调用。
+     * @paras   pconnsockinfo   待关闭的连接。
+     * @ret  0   操作成功。
+     * @time    2020-04-12
+    */
+    virtual int Close(XMNConnSockInfo *pconnsockinfo) = 0;
+
+    /**
+     * @function    返回事件后端的名称，用于日志。
+     * @paras   none 。
+     * @ret  事件后端的名称。
+     * @time    2020-04-12
+    */
+    virtual const char *Name() const = 0;
+};
+
+/**
+ * @function    基于 epoll 的事件后端。
+ * @time    2020-04-12
+*/
+class XMNEpollBackend : public XMNEventBackend
+{
+public:
+    XMNEpollBackend(const int &kMaxConnections);
+    virtual ~XMNEpollBackend();
+
+public:
+    virtual int Init();
+    virtual int Ctl(const int &kSockFd,
+                    const uint32_t &kOption,
+                    const uint32_t &kEvents,
+                    XMNConnSockInfo *pconnsockinfo);
+    virtual int AddReadableFd(const int &kFd, XMNConnSockInfo *pconnsockinfo);
+    virtual int Wait(struct epoll_event *pevents, const int &kMaxEvents, const int &kTimer);
+    virtual int Accept(XMNConnSockInfo *plistenconnsockinfo,
+                       struct sockaddr *paddr,
+                       socklen_t *paddrlen,
+                       const int &kFlags);
+    virtual ssize_t Recv(XMNConnSockInfo *pconnsockinfo, const struct iovec *piov, const int &kIovCnt);
+    virtual ssize_t Send(XMNConnSockInfo *pconnsockinfo, const struct iovec *piov, const int &kIovCnt, const int &kFlags);
+    virtual int Close(XMNConnSockInfo *pconnsockinfo);
+    virtual const char *Name() const
+    {
+        return "epoll";
+    }
+
+private:
+    /**
+     * epoll_create 的参数。
+    */
+    int maxconnections_;
+
+    /**
+     * epoll 对象的文件描述符。
+    */
+    int epoll_handle_;
+};
+
+/**
+ * @function    基于 io_uring 的事件后端，直接使用系统调用，不依赖 liburing 。
+ *              监听 socket 使用 multishot accept ，连接 socket 使用 multishot recv ，
+ *              收到的数据存放在向内核注册的 provided buffer ring 中，每收到一段数据不再需要一次 recv 系统调用。
+ *              EPOLLOUT 以及非 socket 的 fd 的可读事件通过 poll 请求实现。
+ *              事件线程提交的请求在下一次 Wait 时与等待合并为一次 io_uring_enter ，
+ *              其他线程（发送数据线程、业务线程）提交的请求立即提交，以免事件线程堵塞在等待中。
+ * @time    2020-04-12
+*/
+class XMNUringBackend : public XMNEventBackend
+{
+public:
+    XMNUringBackend(const unsigned &kEntries, const unsigned &kRecvBuffCount, const unsigned &kRecvBuffSize);
+    virtual ~XMNUringBackend();
+
+public:
+    virtual int Init();
+    virtual int Ctl(const int &kSockFd,
+                    const uint32_t &kOption,
+                    const uint32_t &kEvents,
+                    XMNConnSockInfo *pconnsockinfo);
+    virtual int AddReadableFd(const int &kFd, XMNConnSockInfo *pconnsockinfo);
+    virtual void SetEventThread(const pthread_t &kThread);
+    virtual int Wait(struct epoll_event *pevents, const int &kMaxEvents, const int &kTimer);
+    virtual void PrepareEvent(const int &kIndex);
+    virtual void FinishEvent(const int &kIndex);
+    virtual int Accept(XMNConnSockInfo *plistenconnsockinfo,
+                       struct sockaddr *paddr,
+                       socklen_t *paddrlen,
+                       const int &kFlags);
+    virtual ssize_t Recv(XMNConnSockInfo *pconnsockinfo, const struct iovec *piov, const int &kIovCnt);
+    virtual ssize_t Send(XMNConnSockInfo *pconnsockinfo, const struct iovec *piov, const int &kIovCnt, const int &kFlags);
+    virtual int Close(XMNConnSockInfo *pconnsockinfo);
+    virtual const char *Name() const
+    {
+        return "io_uring";
+    }
+
+private:
+    /**
+     * 完成事件的 user_data 由连接的句柄左移 3 位和请求类型组成，低 3 位用于存放请求类型。
+     * 连接槽表的大小不超过 XMN_CONN_SLOT_MAX ，左移之后句柄不会丢失信息。
+    */
+    enum RequestType
+    {
+        REQ_ACCEPT = 1,
+        REQ_RECV = 2,
+        REQ_POLLOUT = 3,
+        REQ_IGNORE = 4,
+        REQ_POLLIN = 5
+    };
+
+    /**
+     * XMNConnSockInfo::uringflags 的取值。
+     * FLAG_LISTEN  监听 socket 。
+     * FLAG_READ_ARMED  已经提交了 multishot accept 或者 multishot recv 。
+     * FLAG_POLLOUT_ARMED   已经提交了 POLLOUT 的 poll 请求。
+     * FLAG_REARM_QUEUED    已经放入 vrearmconnsockinfo_ 中。
+     * FLAG_POLLIN_ARMED    已经提交了 POLLIN 的 poll 请求，只用于 AddReadableFd 添加的 fd 。
+    */
+    enum ConnFlag
+    {
+        FLAG_LISTEN = 1,
+        FLAG_READ_ARMED = 2,
+        FLAG_POLLOUT_ARMED = 4,
+        FLAG_REARM_QUEUED = 8,
+        FLAG_POLLIN_ARMED = 16
+    };
+
+    /**
+     * 已经交付给 Wait 的调用者，尚未分发的完成事件的结果。
+    */
+    struct ReadyEvent
+    {
+        XMNConnSockInfo *pconnsockinfo;
+        int res;
+        int bid;
+        uint8_t type;
+    };
+
+private:
+    /**
+     * @function    取得一个空闲的 SQE ，SQ 已满时先提交已有的请求。
+     *              调用者需要持有 sq_mutex_ 。
+     * @paras   none 。
+     * @ret  非 nullptr  空闲的 SQE 。
+     * @time    2020-04-12
+    */
+    struct io_uring_sqe *GetSqe();
+
+    /**
+     * @function    将 SQ 中尚未提交的请求提交给内核。调用者需要持有 sq_mutex_ 。
+     * @paras   none 。
+     * @ret  >= 0    提交的请求的数量。
+     * @time    2020-04-12
+    */
+    int Submit();
+
+    /**
+     * @function    事件线程中请求延迟到下一次 Wait 一起提交，其他线程中请求立即提交。
+     *              调用者需要持有 sq_mutex_ 。
+     * @paras   none 。
+     * @ret  none 。
+     * @time    2020-04-12
+    */
+    void SubmitIfForeign();
+
+    /**
+     * @function    为连接提交 multishot accept 、multishot recv 、poll 请求。调用者需要持有 sq_mutex_ 。
+     * @paras   pconnsockinfo   对应的连接。
+     *          kSockFd 对应的 socket 。
+     * @ret  none 。
+     * @time    2020-04-12
+    */
+    void ArmAccept(XMNConnSockInfo *pconnsockinfo, const int &kSockFd);
+    void ArmRecv(XMNConnSockInfo *pconnsockinfo, const int &kSockFd);
+    void ArmPollOut(XMNConnSockInfo *pconnsockinfo, const int &kSockFd);
+    void ArmPollIn(XMNConnSockInfo *pconnsockinfo, const int &kSockFd);
+
+    /**
+     * @function    撤销请求。调用者需要持有 sq_mutex_ 。
+     * @paras   kUserData   待撤销的请求的 user_data 。
+     *          kSockFd 撤销该 socket 上所有的请求。
+     * @ret  none 。
+     * @time    2020-04-12
+    */
+    void CancelRequest(const uint64_t &kUserData);
+    void CancelFd(const int &kSockFd);
+
+    /**
+     * @function    组合请求的 user_data 。
+     * @paras   pconnsockinfo   请求对应的连接。
+     *          kType   请求的类型，取值为 RequestType 。
+     * @ret  请求的 user_data 。
+     * @time    2020-04-21
+    */
+    static uint64_t UserData(XMNConnSockInfo *pconnsockinfo, const uint8_t &kType);
+
+    /**
+     * @function    将接收数据的缓冲区归还给 provided buffer ring 。只在事件线程中调用。
+     * @paras   kBid    缓冲区的编号。
+     * @ret  none 。
+     * @time    2020-04-12
+    */
+    void RecycleRecvBuff(const int &kBid);
+
+    /**
+     * @function    重新提交已经终止的 multishot 请求（例如缓冲区耗尽时的 ENOBUFS）。
+     *              调用者需要持有 sq_mutex_ 。
+     * @paras   none 。
+     * @ret  none 。
+     * @time    2020-04-12
+    */
+    void RearmTerminated();
+
+private:
+    /**
+     * SQ 的大小、provided buffer ring 中缓冲区的数量和每个缓冲区的大小。
+    */
+    unsigned entries_;
+    unsigned recvbuffcount_;
+    unsigned recvbuffsize_;
+
+    /**
+     * io_uring 的文件描述符。
+    */
+    int ring_fd_;
+
+    /**
+     * 运行 Wait 的事件线程，用于判断请求是否需要立即提交。
+    */
+    pthread_t eventthread_;
+
+    /**
+     * 保护 SQ 以及连接上的 uring 标志位的互斥量。
+    */
+    pthread_mutex_t sq_mutex_;
+
+    /**
+     * SQ 、CQ 、SQE 数组的映射。
+    */
+    void *psqring_;
+    size_t sqringsize_;
+    void *pcqring_;
+    size_t cqringsize_;
+    struct io_uring_sqe *psqes_;
+    size_t sqessize_;
+
+    unsigned *psqhead_;
+    unsigned *psqtail_;
+    unsigned sqmask_;
+    unsigned *psqarray_;
+    unsigned sqlocaltail_;
+
+    unsigned *pcqhead_;
+    unsigned *pcqtail_;
+    unsigned cqmask_;
+    struct io_uring_cqe *pcqes_;
+
+    /**
+     * provided buffer ring 以及其中缓冲区的内存。
+    */
+    struct io_uring_buf_ring *pbufring_;
+    size_t bufringsize_;
+    char *precvbuffs_;
+    unsigned short bufringtail_;
+
+    /**
+     * Wait 交付的事件的结果，与 Wait 的 pevents 一一对应。
+    */
+    std::vector<ReadyEvent> vreadyevents_;
+
+    /**
+     * 等待重新提交 multishot 请求的连接。
+    */
+    std::vector<XMNConnSockInfo *> vrearmconnsockinfo_;
+};
+
+#endif
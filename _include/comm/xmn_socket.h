@@ -8,12 +8,18 @@
 #define XMOON__INCLUDE_XMN_SOCKET_H_
 
 #include "base/noncopyable.h"
+#include "base/singletonbase.h"
 #include "comm/xmn_socket_comm.h"
+#include "comm/xmn_event_backend.h"
+#include "xmn_ringbuffer.h"
+#include "xmn_timerwheel.h"
 
 #include <cstddef>
 #include <sys/epoll.h>
 #include <sys/socket.h>
 #include <semaphore.h>
+#include <pthread.h>
+#include <stdint.h>
 
 #include <atomic>
 #include <vector>
@@ -21,13 +27,33 @@
 #include <queue>
 #include <map>
 #include <memory>
+#include <string>
 
 using CXMNSocket = class XMNSocket;
 struct XMNConnSockInfo;
+struct XMNConnColdInfo;
+class XMNStreamWriter;
 using XMNEventHandler = void (CXMNSocket::*)(XMNConnSockInfo *pconnsockinfo);
 
 /**
- * 存放已经完成连接的 socket 的队列的大小。
+ * 连接句柄，高 32 位为连接在连接槽表中的下标，低 32 位为连接的代数。
+ * 代数从 1 开始，所以 0 不是有效的句柄。
+*/
+using XMNConnHandle = uint64_t;
+
+/**
+ * 连接槽表中槽的最大数量。
+ * io_uring 后端将句柄左移 3 位之后和请求的类型一起存放在 user_data 中，所以下标不能超过 29 位。
+*/
+#define XMN_CONN_SLOT_MAX ((size_t)1 << 29)
+
+/**
+ * cache line 的大小。
+*/
+#define XMN_CACHE_LINE_SIZE 64
+
+/**
+ * 存放已经完成连接的 socket 的队列的大小，socket 配置方案中没有指定 Backlog 时使用。
 */
 #define XMN_LISTEN_BACKLOG 511
 
@@ -35,30 +61,254 @@ using XMNEventHandler = void (CXMNSocket::*)(XMNConnSockInfo *pconnsockinfo);
  * 存放每次从 epoll_wait 的双向链表中取出的 epoll_event 的最大数量。
 */
 #define XMN_EPOLL_WAIT_MAX_EVENTS 512
+
+/**
+ * 每次从接收缓冲区中解析出的包，攒够该数量之后一次性交给线程池。
+*/
+#define XMN_RECV_BATCH_MAX_MSGS 64
+
+/**
+ * UDP 心跳一次 recvmmsg/sendmmsg 最多处理的数据报的数量，以及每个数据报的最大长度，超过该长度的数据报被丢弃。
+*/
+#define XMN_UDP_BATCH_MAX_MSGS 64
+#define XMN_UDP_DGRAM_MAX_LEN 64
+
+/**
+ * 大包的包体分块交给业务逻辑时每块的最大字节数，以及每个连接最多积压的未处理的块的数量。
+ * 积压超过该数量说明业务逻辑处理不过来，与待发送消息过多时一样断开连接，每个连接占用的内存不超过两者之积。
+*/
+#define XMN_STREAM_CHUNK_SIZE 8192
+#define XMN_STREAM_MAX_PENDING_CHUNKS 128
+
+/**
+ * 开启背压时，连接积压的块降到该数量及以下才恢复接收，IsRecvDrained 与 ProcessStreamChunks 共用。
+*/
+#define XMN_STREAM_RESUME_CHUNKS (XMN_STREAM_MAX_PENDING_CHUNKS / 4)
+
+/**
+ * 网络层投递给线程池的内部消息的类型。内部消息的包头中 pkglen 为 0 ，msgcode 为以下取值，
+ * client 发来的包的 pkglen 至少为包头的长度，不会与之混淆。
+ * XMN_INNER_MSG_STREAM_CHUNKS  按顺序处理连接积压的大包的包体块。
+ * XMN_INNER_MSG_WRITABLE   连接的待发送数据降到了低水位以下，继续执行流式发送。
+*/
+#define XMN_INNER_MSG_STREAM_CHUNKS 1
+#define XMN_INNER_MSG_WRITABLE 2
+
+/**
+ * 每个连接最多积压的待发送的消息的数量，超过时认为 client 只发送不接收，断开连接。
+*/
+#define XMN_SEND_MAX_PENDING_MSGS 400
+
+/**
+ * 一次 writev/sendmsg 最多组合的消息的数量。
+*/
+#define XMN_SEND_IOV_MAX 64
+
+/**
+ * 定时器时间轮的槽的数量以及每个槽代表的时间（ms），一圈为 51.2 s 。
+*/
+#define XMN_TIMER_WHEEL_SLOTS 512
+#define XMN_TIMER_WHEEL_TICK_MS 100
+
+/**
+ * accept 负载均衡的方式。
+ * XMN_ACCEPT_BALANCE_NONE  所有 worker 进程直接监听共享的 socket 。
+ * XMN_ACCEPT_BALANCE_EXCLUSIVE 以 EPOLLEXCLUSIVE 方式监听共享的 socket ，每次只唤醒一个 worker 进程。
+ * XMN_ACCEPT_BALANCE_MUTEX 通过进程间共享的 accept 互斥量，同一时刻只有一个 worker 进程监听共享的 socket 。
+*/
+#define XMN_ACCEPT_BALANCE_NONE 0
+#define XMN_ACCEPT_BALANCE_EXCLUSIVE 1
+#define XMN_ACCEPT_BALANCE_MUTEX 2
+
+/**
+ * 新连接分配给 reactor 线程的方式。
+ * XMN_REACTOR_DISPATCH_ROUNDROBIN  依次轮流分配。
+ * XMN_REACTOR_DISPATCH_LEASTCONN   分配给当前连接数量最少的 reactor 线程。
+*/
+#define XMN_REACTOR_DISPATCH_ROUNDROBIN 0
+#define XMN_REACTOR_DISPATCH_LEASTCONN 1
+
+#ifndef EPOLLEXCLUSIVE
+#define EPOLLEXCLUSIVE (1u << 28)
+#endif
+
+/**
+ * 较老的系统头文件中没有定义下面的 socket 选项。
+*/
+#ifndef SO_INCOMING_CPU
+#define SO_INCOMING_CPU 49
+#endif
+#ifndef SO_ATTACH_REUSEPORT_CBPF
+#define SO_ATTACH_REUSEPORT_CBPF 51
+#endif
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+
+/**
+ *  @function   socket 配置方案，由配置文件中的 ListenProfileN 指定给各个监听端口。
+ *  @notice 监听 socket 上的选项在 OpenListenSocket 中设置，连接 socket 上的选项在 EventAcceptHandler 中设置。
+ *          各个选项为 0 时不设置，使用系统的默认值。
+ *  @time   2020-04-25
+*/
+struct XMNSocketProfile
+{
+    /**
+     * 配置方案的名称，为空时即缺省的方案。
+    */
+    std::string name;
+
+    /**
+     * 监听 socket ：listen 的 backlog 、TCP_FASTOPEN 的队列长度、TCP_DEFER_ACCEPT 的秒数、
+     * SO_SNDBUF 和 SO_RCVBUF 的字节数（在 listen 之前设置，连接 socket 继承，窗口扩大因子据此协商）。
+    */
+    int backlog;
+    int fastopen;
+    int deferaccept;
+    int sendbuf;
+    int recvbuf;
+
+    /**
+     * 连接 socket ：TCP_NODELAY 、TCP_NOTSENT_LOWAT 的字节数、SO_KEEPALIVE 以及
+     * TCP_KEEPIDLE 、TCP_KEEPINTVL（秒）和 TCP_KEEPCNT 。
+    */
+    int nodelay;
+    int notsentlowat;
+    int keepalive;
+    int keepidle;
+    int keepintvl;
+    int keepcnt;
+};
+
 /**
  *  @function   存放监听 socket 的相关的信息。
  *  @time   2019-08-25
 */
 struct XMNListenSockInfo
 {
+    /**
+     * 监听 socket 的地址族：AF_INET 为 TCP 端口；AF_UNIX 为 Unix 域 socket ，此时 port 为 0 。
+    */
+    int family;
+
     /**
      * 监听端口号。
     */
     size_t port;
 
+    /**
+     * Unix 域 socket 文件的路径。
+    */
+    std::string path;
+
     /**
      * 监听 socket 。
     */
     int fd;
 
+    /**
+     * 独占该监听 socket 的 worker 进程的编号。
+     * -1   所有的 worker 进程共享该监听 socket 。
+    */
+    int workerindex;
+
+    /**
+     * 该监听端口使用的 socket 配置方案，指向 XMNSocket::vsocketprofile_ 中的元素。
+    */
+    const XMNSocketProfile *pprofile;
+
     /**
      * 该监听 socket 对应的连接池中的连接。
     */
     XMNConnSockInfo *pconnsockinfo;
 };
 
+/**
+ * @function    连接的冷数据，只有部分连接、在部分时刻才会用到，第一次使用时才从内存池中申请。
+ *              大量空闲连接的 worker 进程中，XMNConnSockInfo 只保留常用的变量。
+ * @time    2020-04-22
+*/
+struct XMNConnColdInfo
+{
+public:
+    /**
+     * @paras   kSockFd 连接 socket ，用于获取 client 的地址。
+    */
+    explicit XMNConnColdInfo(const int &kSockFd);
+    ~XMNConnColdInfo();
+
+public:
+    /**
+     * 保存 client 地址信息用的，申请冷数据时通过 getpeername 获取。
+    */
+    struct sockaddr clientsockaddrinfo;
+
+    /**
+     * 业务逻辑处理的互斥量。
+    */
+    pthread_mutex_t logicprocmutex_;
+
+    /**
+     * 零拷贝发送的编号，与内核中该 socket 的计数保持一致，调用者需持有 sendmutex_ 。
+     * zerocopysendseq  已经成功调用的 MSG_ZEROCOPY 发送的次数，即：下一次发送的编号。
+     * zerocopydoneseq  编号小于该值的发送都已经收到了完成通知。
+    */
+    uint32_t zerocopysendseq;
+    uint32_t zerocopydoneseq;
+
+    /**
+     * 零拷贝等待链表的头和尾，存放已经发送但内核可能仍在引用的消息，按 XMNMsgHeader::zerocopyid 递增排列。
+    */
+    char *pzerocopyhead;
+    char *pzerocopytail;
+
+    /**
+     * 正在接收的大包的解析状态，只在该连接的事件循环中访问。
+     * streambodylen    包体的长度，0 表示当前没有正在接收的大包。
+     * streamoffset 已经交给业务逻辑的包体的字节数。
+     * streammsgcode    扩展包头中的消息代码。
+     * streamcrc32  扩展包头中的包体的 CRC32 校验值。
+     * streamcrcnow 已经收到的包体的 CRC32 校验值，随着每一块数据的到达而更新。
+    */
+    uint32_t streambodylen;
+    uint32_t streamoffset;
+    unsigned short streammsgcode;
+    int streamcrc32;
+    unsigned int streamcrcnow;
+
+    /**
+     * 待业务逻辑处理的包体块（XMNStreamChunk）链表的头和尾，通过 XMNMsgHeader::pnext 相连，调用者需持有 streammutex_ 。
+     * streamchunkcount 链表中块的数量。
+     * isstreamscheduled    是否已经向线程池投递了处理该链表的消息，保证同一时刻只有一个线程按顺序处理。
+    */
+    pthread_mutex_t streammutex_;
+    char *pstreamhead;
+    char *pstreamtail;
+    size_t streamchunkcount;
+    bool isstreamscheduled;
+
+    /**
+     * 该连接上正在进行的流式发送，见 XMNSocket::StartStreamWriter ，连接关闭时随冷数据一起释放。
+    */
+    XMNStreamWriter *pstreamwriter;
+};
+
 /**
  * @function    存放连接 socket 的相关信息。
+ *              按照访问的线程和频率分组，每组从新的 cache line 开始，
+ *              防止不同线程修改的变量（尤其是原子变量）相互之间伪共享。
  * @time    2019-08-26
 */
 struct XMNConnSockInfo
@@ -73,7 +323,8 @@ public:
         GENERALMODE,
         REGISTERMODE,
         PINGMODE,
-        LOGINMODE
+        LOGINMODE,
+        UDPTOKENMODE
     };
 
 public:
@@ -88,57 +339,84 @@ public:
     void ClearConnSockInfo();
 
     /**
-     * @function    根据不同的内存模型采用不同的方式释放内存。
-     * @paras   none 。
+     * @function    根据消息的内存模型采用不同的方式释放待发送的消息的内存。
+     * @paras   pdata   待释放的消息，即：消息头 + 包头 + 包体。
      * @time    2020-03-18
     */
-    void FreeSendDataMem();
-    void FreeSendDataMem(char *pdata);
+    static void FreeSendDataMem(char *pdata);
 
-public:
     /**
-     * 指向下一个该类型的对象。
-     * 暂时无用。
+     * @function    释放该连接的待发送消息链表中的所有消息，调用者需持有 sendmutex_ 。
+     * @paras   none 。
+     * @ret  释放的消息的数量。
+     * @time    2020-04-15
     */
-    XMNConnSockInfo *next;
+    size_t FreeSendQueue();
 
     /**
-     * 连接 socket 。
+     * @function    处理一个已经完整发送的消息，调用者需持有 sendmutex_ 。
+     *              若该连接还有 MSG_ZEROCOPY 发送尚未完成，内核可能仍在引用该消息，
+     *              则将其放入零拷贝等待链表中，待完成通知到达后再释放；否则直接释放。
+     * @paras   pdata   已经完整发送的消息。
+     * @time    2020-04-16
     */
-    int fd;
+    void ReleaseSentData(char *pdata);
 
     /**
-     * 该连接 socket 对应的监听 socket 的信息。
+     * @function    释放零拷贝等待链表中编号小于 zerocopydoneseq 的消息，调用者需持有 sendmutex_ 。
+     *              没有冷数据的连接不会有零拷贝发送，直接返回。
+     * @paras   isall   是否不论编号全部释放，连接回收时使用。
+     * @time    2020-04-16
     */
-    XMNListenSockInfo *plistensockinfo;
+    void FreeZeroCopyQueue(const bool &isall);
 
     /**
-     * 位域，失效的标志位。
-     * 0    有效
-     * 1    失效
-     * 暂时无用。
+     * @function    该连接当前的句柄。
+     * @time    2020-04-21
     */
-    unsigned int instance : 1;
+    XMNConnHandle Handle() const { return ((XMNConnHandle)slotindex << 32) | generation; }
 
     /**
-     * 序号。
+     * @function    获取该连接的冷数据，第一次调用时申请，可以在任意线程中调用。
+     * @paras   none 。
+     * @ret  该连接的冷数据。
+     * @time    2020-04-22
     */
-    uint64_t currsequence;
+    XMNConnColdInfo *GetColdInfo();
 
     /**
-     * 保存 client 地址信息用的。
+     * @function    释放该连接的冷数据，连接归还至连接池时调用。
+     * @time    2020-04-22
     */
-    struct sockaddr clientsockaddrinfo;
+    void FreeColdInfo();
 
+public:
+    /**************************************************************************************
+     * 
+     ***************** 第 1 个 cache line ：各个线程都会读取、很少修改的变量 **************** 
+     * 
+    **************************************************************************************/
     /**
-     * 读准备好标志。
+     * 代数，连接被取出、放入回收链表以及归还时都会加 1 ，用于判断句柄是否过期。
+     * 槽被重新使用时不清零，所以旧连接的句柄不会和新连接的句柄相同。
     */
-    uint8_t r_ready;
+    alignas(XMN_CACHE_LINE_SIZE) std::atomic<uint32_t> generation;
 
     /**
-     * 写准备好标志。
+     * 连接在连接槽表中的下标，由 XMNConnSlotTable 设置。
     */
-    uint8_t w_ready;
+    uint32_t slotindex;
+
+    /**
+     * 连接 socket 。
+    */
+    int fd;
+
+    /**
+     * 存储该连接对应的 accept 返回的 socket 的触发事件类型。
+     * 包括 EPOLLIN、EPOLLRDHUP 等。 
+    */
+    uint32_t events;
 
     /**
      * 读事件相关处理函数。
@@ -153,150 +431,364 @@ public:
     XMNEventHandler whandler;
 
     /**
-     * 存储该连接对应的 accept 返回的 socket 的触发事件类型。
-     * 包括 EPOLLIN、EPOLLRDHUP 等。 
+     * 该连接 socket 对应的监听 socket 的信息。
     */
-    uint32_t events;
+    XMNListenSockInfo *plistensockinfo;
 
     /**
-     * 业务逻辑处理的互斥量。
+     * 冷数据，见 XMNConnColdInfo ，通过 GetColdInfo 获取。
     */
-    pthread_mutex_t logicprocmutex_;
+    std::atomic<XMNConnColdInfo *> pcoldinfo;
 
     /**************************************************************************************
      * 
-     ***************** 与收包相关的变量 **************** 
+     ***************** 第 2 个 cache line ：只由事件线程修改的收包相关的变量 **************** 
      * 
     **************************************************************************************/
     /**
-     * 状态机变量1：
-     * 接收当前数据包的状态。
+     * 接收缓冲区，每次 recv 尽量填满空闲空间，其中所有完整的包一次性取出并交给线程池，
+     * 不完整的包留在缓冲区中等待下次接收。
+     * 在连接第一次收到数据时申请内存，连接回收时释放。
     */
-    RecvStatus recvstatus;
+    alignas(XMN_CACHE_LINE_SIZE) XMNRingBuffer recvringbuff;
 
     /**
-     * 状态机变量2：
-     * 存放当前需要接收的数据的首地址，供 RecvData 函数使用。
-     * 在接收包头数据时，该指针指向了 dataheader 。
-     * 在接收包体数据时，该指针指向了 precvalldata 。
+     * io_uring 后端中，正在分发的完成事件携带的结果，由 XMNUringBackend::PrepareEvent 设置。
+     * preadydata 、readydatalen    multishot recv 收到的、尚未被收包状态机取走的数据。
+     * readyres 数据取完之后 Recv 的结果（0 或者 -errno），对于监听 socket 则是 multishot accept 得到的新连接。
     */
-    char *precvdatastart;
+    char *preadydata;
+    uint32_t readydatalen;
+    int readyres;
 
     /**
-     * 状态机变量3：
-     * 当前需要接收的数据的字节数。
+     * 上次受到 flood 攻击的时间。
     */
-    size_t recvdatalen;
+    uint64_t floodlasttime;
 
     /**
-     * 存放包头数据。
+     * 一共连续受到 flood 攻击的次数，只在事件线程的收包过程中修改。
     */
-    char dataheader[XMN_PKG_HEADER_SIZE];
+    uint32_t floodattackcount;
 
     /**
-     * 存放最终需要接收的所有数据，即：消息头 + 包头 + 包体。
+     * io_uring 后端中该连接上已经提交的请求的标志位，由 XMNUringBackend 维护。
     */
-    char *precvalldata;
+    uint8_t uringflags;
 
     /**
-     * 标记 precvalldata 是否需要释放。
+     * 读准备好标志。
     */
-    bool isfree;
+    uint8_t r_ready;
+
+    /**
+     * 写准备好标志。
+    */
+    uint8_t w_ready;
+
+    /**
+     * 连接是否已经放入回收链表中，用于防止重复放入。
+    */
+    std::atomic<bool> isretired;
 
     /**************************************************************************************
      * 
-     ***************** 与发包相关的变量 *****************
+     ***************** 第 3 、4 个 cache line ：业务逻辑线程和发送数据线程修改的发包相关的变量 *****************
      * 
     **************************************************************************************/
     /**
-     * 保存整个消息的头指针，即：消息头 + 包头 + 包体，用于释放消息。
+     * 发送数据的互斥量，保护下面的待发送消息链表。
+     * 发送数据线程和 epoll 驱动的发送（WaitWriteRequestHandler）都会操作该链表。
     */
-    char *psendalldataforfree;
+    alignas(XMN_CACHE_LINE_SIZE) pthread_mutex_t sendmutex_;
 
     /**
-     * 保存最终需要发送的所有数据，即：包头 + 包体。
+     * 待发送消息链表的头和尾，消息之间通过 XMNMsgHeader::pnext 相连。
+     * 发送时将链表中的消息一次性组成 iovec ，由一次 writev/sendmsg 发出。
     */
-    char *psenddata;
+    char *psendqueuehead;
+    char *psendqueuetail;
 
     /**
-     * 待发送的数据的字节数量，即：psenddata（包头 + 包体）。
+     * 链表头部的消息中已经发送出去的字节数（包头 + 包体中的偏移）。
     */
-    size_t senddatalen;
+    uint32_t sendheadoffset;
 
     /**
-     * 记录该消息需要由 epoll_wait 来驱动发送的次数。
-     * TODO：更准确的注释内容后续补充。
+     * 待发送消息链表中尚未发出的字节数，流式发送据此判断高低水位。
     */
-    std::atomic<size_t> throwepollsendcount;
+    uint32_t sendqueuebytes;
 
-    /**************************************************************************************
-     * 
-     ***************** 和连接回收相关的变量 *****************
-     * 
-    **************************************************************************************/
     /**
-     * 连接放入回收链表时的时间。
+     * 在发送消息队列中该连接对应的数据包的数量。
+     * 用于防止某个 client 只发送不接收而导致服务器的问题。
+     * 对于上述 client ，需要将其踢掉。
     */
-    time_t putinrecylisttime;
+    std::atomic<uint32_t> nosendmsgcount;
 
     /**
-     * 标记发送端内存的申请方式。
+     * 已经交给线程池、尚未处理完的该连接的消息的数量，由事件线程增加，业务逻辑线程处理完之后减少。
     */
-    MemMode memmode;
+    std::atomic<uint32_t> recvmsgcount;
 
-    /**************************************************************************************
-     * 
-     ***************** 和心跳包相关的变量 *****************
-     * 
-    **************************************************************************************/
     /**
-     * 最后一次接收到心跳包的时间。
+     * 该连接是否已经在 epoll 中挂了 EPOLLOUT ，即：剩余的数据由 epoll_wait 来驱动发送。
+     * 为 1 时新的消息只放入待发送消息链表中，不再放入发送连接队列。
     */
-    time_t lastpingtime;
+    std::atomic<uint32_t> throwepollsendcount;
 
-    /**************************************************************************************
-     * 
-     ***************** 与网络安全相关的变量 **************** 
-     * 
-    **************************************************************************************/
     /**
-     * 上次受到 flood 攻击的时间。
+     * 负责发送该连接的数据的发送数据线程的下标，按照 socket 描述符分配。
     */
-    uint64_t floodlasttime;
+    uint16_t sendshardindex;
 
     /**
-     * 一共连续受到 flood 攻击的次数。
+     * 负责该连接的事件的 reactor 的下标，0 为 worker 进程的主事件循环，在 accept 时分配。
+     * 该连接的 Ctl 、Recv 、Send 、Close 都通过该 reactor 的事件后端执行。
     */
-    std::atomic<size_t> floodattackcount;
+    uint16_t reactorindex;
 
     /**
-     * 在发送消息队列中该连接对应的数据包的数量。
-     * 用于防止某个 client 只发送不接收而导致服务器的问题。
-     * 对于上述 client ，需要将其踢掉。
+     * 该连接是否已经在发送连接队列中。
+    */
+    bool issendscheduled;
+
+    /**
+     * 该连接的 socket 是否开启了 SO_ZEROCOPY ，开启时冷数据在 accept 时申请。
+    */
+    bool iszerocopy;
+
+    /**
+     * 流式发送是否在等待 sendqueuebytes 降到低水位以下，降到之后由发送的线程投递 XMN_INNER_MSG_WRITABLE 并清除该标志。
+    */
+    bool iswritewaiting;
+
+    /**
+     * 是否因为积压过多而暂停了接收（去掉了 EPOLLIN ），修改时需持有 sendmutex_ 。
+    */
+    std::atomic<bool> isrecvpaused;
+
+    /**
+     * UDP 心跳令牌中的随机数，由业务逻辑线程在申请令牌时生成，0 表示没有申请过令牌。
+    */
+    std::atomic<uint32_t> udpnonce;
+
+    /**
+     * 最后一次接收到心跳包的时间，由业务逻辑线程或者处理 UDP 心跳的主事件循环修改。
+    */
+    std::atomic<time_t> lastpingtime;
+
+    /**
+     * 心跳监控定时器的编号，连接关闭时用于取消定时器。
+    */
+    std::atomic<uint64_t> pingtimerid;
+
+    /**
+     * 连接放入回收链表时的全局 epoch ，见 XMNEpoch 。
+    */
+    uint64_t retireepoch;
+};
+
+/**
+ * @function    连接槽表，worker 进程中所有的连接都存放在一个预先分配的数组中，通过句柄访问。
+ * @notice  （1）数组的内存直到进程退出时才释放，根据句柄定位连接不会访问已经释放的内存，
+ *          判断句柄是否过期只需比较一次代数，不需要先解引用可能已经失效的指针。
+ *          （2）槽的数量固定，槽用完时 Allocate 返回 nullptr 。
+ *          （3）从未使用过的槽的代数为 0 ，不会和任何有效的句柄匹配。
+ * @time    2020-04-21
+*/
+class XMNConnSlotTable : public NonCopyable
+{
+    friend class SingletonBase<XMNConnSlotTable>;
+
+private:
+    XMNConnSlotTable();
+    ~XMNConnSlotTable();
+
+public:
+    /**
+     * @function    创建连接槽表，需要在 worker 进程中、取出第一个连接之前调用。
+     * @paras   kSlotCount  槽的数量，不能超过 XMN_CONN_SLOT_MAX 。
+     * @ret  0   操作成功。
+     *          -1  参数错误或者内存申请失败。
+     * @time    2020-04-21
+    */
+    int Create(const size_t &kSlotCount);
+
+    /**
+     * @function    取出一个空闲的槽并构造连接，连接的代数保持不变。
+     * @paras   none 。
+     * @ret  nullptr 没有空闲的槽。
+     * @time    2020-04-21
+    */
+    XMNConnSockInfo *Allocate();
+
+    /**
+     * @function    将连接所在的槽归还。
+     * @paras   pconnsockinfo   待归还的连接。
+     * @ret  none 。
+     * @time    2020-04-21
+    */
+    void DeAllocate(XMNConnSockInfo *pconnsockinfo);
+
+    /**
+     * @function    根据句柄获取连接。
+     * @paras   kConnHandle 连接的句柄。
+     * @ret  nullptr 句柄已经过期（连接已经关闭或者槽已经被其他连接使用）或者无效。
+     * @time    2020-04-21
+    */
+    XMNConnSockInfo *Get(const XMNConnHandle &kConnHandle) const
+    {
+        const size_t kIndex = (size_t)(kConnHandle >> 32);
+        if (kIndex >= slotcount_)
+        {
+            return nullptr;
+        }
+        XMNConnSockInfo *pconnsockinfo = pslots_ + kIndex;
+        return pconnsockinfo->generation == (uint32_t)kConnHandle ? pconnsockinfo : nullptr;
+    }
+
+    /**
+     * @function    根据句柄获取连接所在的槽，不判断句柄是否过期。
+     *              仅用于连接不会被回收、但需要得知其已经关闭的场合，例如：发送连接队列。
+     * @paras   kConnHandle 连接的句柄，必须是曾经有效的句柄。
+     * @ret  连接所在的槽。
+     * @time    2020-04-21
+    */
+    XMNConnSockInfo *GetSlot(const XMNConnHandle &kConnHandle) const
+    {
+        return pslots_ + (size_t)(kConnHandle >> 32);
+    }
+
+    size_t SlotCount() const { return slotcount_; }
+    size_t UsedSlotCount() const { return usedslotcount_; }
+
+private:
+    /**
+     * 槽的数组，按需构造其中的连接。
     */
-    std::atomic<size_t> nosendmsgcount;
+    XMNConnSockInfo *pslots_;
+    size_t slotcount_;
+
+    /**
+     * 正在使用的槽的数量。
+    */
+    std::atomic<size_t> usedslotcount_;
+
+    /**
+     * 从未使用过的槽中下标最小的一个，之前的槽都已经构造过。
+    */
+    size_t nextunusedslot_;
+
+    /**
+     * 已经归还的槽的下标，后归还的先使用。
+    */
+    std::vector<uint32_t> vfreeslots_;
+
+    /**
+     * 有关槽的分配和归还的互斥量。
+    */
+    pthread_mutex_t mutex_;
+};
+
+/**
+ * @function    进程间共享的 accept 互斥量，存放在 master 进程创建的共享内存中。
+ * @time    2020-04-08
+*/
+struct XMNAcceptMutex
+{
+    /**
+     * 持有该互斥量的 worker 进程的 pid ，0 表示没有被持有。
+    */
+    std::atomic<pid_t> lock;
 };
 
 /****************************************************
  * 
  * 消息头，在收到的每一个消息的前面添加消息头。
- * 用于记录该消息对应的连接以及连接序号。
+ * 用于记录该消息对应的连接的句柄。
  * 
 ****************************************************/
 struct XMNMsgHeader
 {
     /**
-     * 指定该消息记录对应的是哪个连接。
+     * 该消息对应的连接的句柄，通过 XMNSocket::GetConnSockInfo 获取连接，同时判断该连接是否已经关闭。
+     * 同一个 XMNConnSockInfo 可能先后对应多个连接，代数不同的句柄不会混淆。
     */
-    XMNConnSockInfo *pconnsockinfo;
+    XMNConnHandle connhandle;
+
+    /**
+     * 以下两个变量仅在发送消息时使用。
+     * pnext    同一个连接的待发送消息链表中的下一个消息；接收的消息在线程池中时，为同一个连接的下一个待处理消息。
+     * memmode  该消息内存的申请方式，取值为 XMNConnSockInfo::MemMode ，释放消息时使用。
+     * 同一个连接上可能同时有不同类型的消息待发送，所以内存的申请方式必须记录在每个消息中。
+    */
+    char *pnext;
+    uint8_t memmode;
 
     /**
-     * 指定该消息对应的连接的序号，用于判断该连接是否是过期连接。
-     * 因为同一个 XMNConnSockInfo 可能对应出多个连接。
+     * 消息在零拷贝等待链表中时，释放该消息之前需要等待完成的零拷贝发送的编号。
     */
-    uint64_t currsequence;
+    uint32_t zerocopyid;
 } __attribute__((packed));
 
+/**
+ * @function    大包的包体中的一块数据，由事件循环从内存池中申请，业务逻辑处理之后归还。
+ * @time    2020-04-27
+*/
+struct XMNStreamChunk
+{
+    /**
+     * 其中的 connhandle 为该包所在连接的句柄，pnext 用于在 XMNConnColdInfo 的链表中排队。
+    */
+    XMNMsgHeader msgheader;
+
+    /**
+     * 扩展包头中的消息代码以及包体的长度。
+    */
+    unsigned short msgcode;
+    uint32_t bodylen;
+
+    /**
+     * 该块在包体中的偏移以及该块的字节数。
+    */
+    uint32_t offset;
+    uint32_t datalen;
+
+    /**
+     * 是否是包体的最后一块，以及是最后一块时整个包体的 CRC32 校验是否正确。
+    */
+    bool islast;
+    bool iscrcok;
+
+    char data[XMN_STREAM_CHUNK_SIZE];
+};
+
+/**
+ * @function    流式发送的接口，用于分多次发送的大的或者持续时间长的回复，不需要事先在内存中组合出完整的回复。
+ * @notice  （1）业务逻辑继承该类，通过 XMNSocket::StartStreamWriter 交给网络层，之后由网络层负责释放。
+ *          （2）OnWritable 在线程池中调用，同一时刻最多只有一个线程调用，其中通过 XMNSocket::StreamWrite 发送数据，
+ *          StreamWrite 返回 1 时说明待发送的数据已经达到高水位，应当返回，等到降到低水位以下时会再次调用。
+ *          （3）这样该连接占用的发送内存与 socket 的发送窗口相当，而不是与回复的大小相当。
+ * @time    2020-04-28
+*/
+class XMNStreamWriter
+{
+public:
+    virtual ~XMNStreamWriter() {}
+
+    /**
+     * @function    连接可以继续发送数据时调用，第一次在 StartStreamWriter 之后立即调用。
+     * @paras   psocket 调用 StreamWrite 使用的对象。
+     *          kConnHandle 该连接的句柄。
+     * @ret  0   还有数据要发送，等到待发送的数据降到低水位以下时再次调用。
+     *          1   已经发送完毕，之后该对象被释放。
+     *          < 0 出错，之后该对象被释放。
+     * @time    2020-04-28
+    */
+    virtual int OnWritable(XMNSocket *psocket, const XMNConnHandle &kConnHandle) = 0;
+};
+
 class XMNSocket : public NonCopyable
 {
 public:
@@ -329,6 +821,110 @@ public:
         pthread_t threadhandle_;
     };
 
+    /**
+     * 保存单个发送数据线程的信息以及由其负责的发送连接队列。
+    */
+    class SendShard : public NonCopyable
+    {
+    public:
+        SendShard() = delete;
+        SendShard(XMNSocket *pthis) : pthis_(pthis)
+        {
+            threadhandle_ = 0;
+            eventfd_ = -1;
+        }
+        ~SendShard(){};
+
+    public:
+        /**
+         * 该线程所在的 XMNSocket 对象的首地址。
+        */
+        XMNSocket *pthis_;
+        /**
+         * 该线程的描述符。
+        */
+        pthread_t threadhandle_;
+        /**
+         * 用于唤醒该线程的 eventfd ，队列由空变为非空时才写入，多次唤醒合并为一次。
+        */
+        int eventfd_;
+        /**
+         * 有关发送连接队列的相关操作的互斥量。
+        */
+        pthread_mutex_t connqueue_mutex_;
+        /**
+         * 发送连接队列，存放待发送消息链表中有消息、需要由该线程发送的连接。
+         * 消息本身存放在各个连接的待发送消息链表中，每个连接在该队列中最多出现一次。
+        */
+        std::vector<XMNConnHandle> connqueue_;
+    };
+
+    /**
+     * 保存单个 reactor（事件循环）的信息，每个 reactor 有自己的事件后端，只处理分配给它的连接。
+     * 下标为 0 的 reactor 是 worker 进程的主事件循环，负责监听 socket 和定时器；
+     * 其余的 reactor 各由一个线程运行。
+    */
+    class Reactor : public NonCopyable
+    {
+    public:
+        Reactor() = delete;
+        Reactor(XMNSocket *pthis, const size_t &kIndex) : pthis_(pthis), index_(kIndex)
+        {
+            threadhandle_ = 0;
+            peventbackend_ = nullptr;
+            wakeupfd_ = -1;
+            conncount_ = 0;
+            lastactivens_ = 0;
+            spinpollcount_ = 0;
+            spinhitcount_ = 0;
+            blockwaitcount_ = 0;
+        }
+        ~Reactor(){};
+
+    public:
+        /**
+         * 该 reactor 所在的 XMNSocket 对象的首地址。
+        */
+        XMNSocket *pthis_;
+        /**
+         * 该 reactor 在 vreactor_ 中的下标。
+        */
+        size_t index_;
+        /**
+         * 运行该 reactor 的线程的描述符，主事件循环为 0 。
+        */
+        pthread_t threadhandle_;
+        /**
+         * 该 reactor 的事件后端。
+        */
+        XMNEventBackend *peventbackend_;
+        /**
+         * 用于唤醒该 reactor 线程的 eventfd ，退出以及推进 epoch 时使用，主事件循环不需要。
+        */
+        int wakeupfd_;
+        /**
+         * 由该 reactor 负责的连接的数量，用于按最少连接数分配新连接。
+        */
+        std::atomic<size_t> conncount_;
+        /**
+         * 忙轮询相关：最后一次取到事件的时间（CLOCK_MONOTONIC ，单位 ns），只由运行该 reactor 的线程读写。
+        */
+        uint64_t lastactivens_;
+        /**
+         * 忙轮询的统计，由 PrintInfo 读取并清零。
+         * spinpollcount_   以超时时间 0 调用 Wait 的次数。
+         * spinhitcount_    其中取到了事件的次数。
+         * blockwaitcount_  堵塞调用 Wait 的次数。
+        */
+        std::atomic<size_t> spinpollcount_;
+        std::atomic<size_t> spinhitcount_;
+        std::atomic<size_t> blockwaitcount_;
+        /**
+         * 用于存储 Wait 返回的发生的事件。
+        */
+        struct epoll_event wait_events_[XMN_EPOLL_WAIT_MAX_EVENTS];
+    };
+
 public:
     XMNSocket();
     virtual ~XMNSocket();
@@ -354,6 +950,7 @@ public:
      * @ret  0   操作成功。
      *          -1  connsock_pool_mutex_    初始化失败。
      *          -2  connsock_pool_recycle_mutex_   初始化失败。
+     *          -3  recvpausedmutex_    初始化失败。
      * @time    2019-09-21
     */
     virtual int InitializeWorker();
@@ -425,6 +1022,34 @@ public:
                             const int &kFlag,
                             XMNConnSockInfo *pconnsockinfo);
 
+    /**
+     * @function    根据 accept 负载均衡的方式和当前的在线人数，决定本进程是否监听共享的 socket 。
+     *              在线人数接近 worker_connection_count_ 时暂停 accept ，新连接交由其他空闲的 worker 进程处理。
+     *              需要在每次 EpollProcessEvents 之前调用。
+     * @paras   none 。
+     * @ret  EpollProcessEvents 应该使用的超时时间，单位 ms 。
+     * @time    2020-04-08
+    */
+    int ProcessAcceptBalance();
+
+    /**
+     * @function    释放 accept 互斥量，需要在每次 EpollProcessEvents 之后调用，以便其他 worker 进程获取。
+     * @paras   none 。
+     * @ret  none 。
+     * @time    2020-04-08
+    */
+    void ReleaseAcceptMutex();
+
+    /**
+     * @function    由 master 进程在回收 worker 进程时调用，该进程持有 accept 互斥量时强制释放，
+     *              否则其他 worker 进程再也获取不到互斥量，全部停止 accept 。
+     *              只有原子操作，可以在信号处理函数中调用。
+     * @paras   kPid    已经退出的 worker 进程的 pid 。
+     * @ret  none 。
+     * @time    2020-04-29
+    */
+    void ForceReleaseAcceptMutex(const pid_t &kPid);
+
     /**
      * @function    epoll 等待接收和处理事件。
      * @paras   kTimer  等待事件的超时时间，单位 ms 。
@@ -433,6 +1058,17 @@ public:
     */
     int EpollProcessEvents(const int &kTimer);
 
+    /**
+     * @function    连接所属的 reactor 的事件后端。
+     * @paras   pconnsockinfo   连接。
+     * @ret  事件后端。
+     * @time    2020-04-23
+    */
+    XMNEventBackend *EventBackend(const XMNConnSockInfo *pconnsockinfo) const
+    {
+        return vreactor_[pconnsockinfo->reactorindex]->peventbackend_;
+    }
+
     /**
      * @function    返回消息队列中元素的数量。
      * @paras   none 。
@@ -454,32 +1090,155 @@ public:
     */
     virtual void ThreadRecvProcFunc(char *pmsgbuf);
 
+    /**
+     * @function    处理大包的包体中的一块数据，同一个包的各块按顺序在同一时刻只由一个线程调用。
+     *              最后一块的 iscrcok 为 false 时，说明包体在传输中被破坏，之前各块的数据都不可信。
+     * @paras   pchunk  包体中的一块数据，调用结束后归还内存池，不能保存该指针。
+     * @ret  none 。
+     * @time    2020-04-27
+    */
+    virtual void HandleStreamChunk(XMNStreamChunk *pchunk);
+
+    /**
+     * @function    在连接上开始流式发送，pwriter 的 OnWritable 随后在线程池中被调用。
+     * @paras   kConnHandle 连接的句柄。
+     *          pwriter 通过 new 创建的流式发送对象，无论成功与否都由网络层负责释放。
+     * @ret  0   操作成功。
+     *          -1  连接已经关闭。
+     *          -2  该连接上已经有正在进行的流式发送。
+     *          -3  申请内存失败。
+     * @time    2020-04-28
+    */
+    int StartStreamWriter(const XMNConnHandle &kConnHandle, XMNStreamWriter *pwriter);
+
+    /**
+     * @function    流式发送中发送一个包，包体的 CRC32 在这里计算。
+     * @paras   kConnHandle 连接的句柄。
+     *          kMsgCode    包的消息代码。
+     *          pdata   包体，可以为 nullptr 。
+     *          kDataLen    包体的字节数，包头 + 包体不能超过 PKG_MAX_LEN ，与 client 解析普通包头的上限一致。
+     * @ret  0   操作成功，可以继续发送。
+     *          1   操作成功，待发送的数据已经达到高水位，应当从 OnWritable 中返回 0 等待下一次调用。
+     *          -1  连接已经关闭、消息被丢弃或者申请内存失败。
+     *          -2  包体太长。
+     * @time    2020-04-28
+    */
+    int StreamWrite(const XMNConnHandle &kConnHandle, const uint16_t &kMsgCode, const char *pdata, const size_t &kDataLen);
+
     /**************************************************************************************
      * 
      ***************** 与心跳监控相关的变量 *****************
      * 
     **************************************************************************************/
-    virtual int PingTimeOutChecking(XMNMsgHeader *pmsgheader, time_t currenttime);
+    /**
+     * @function    心跳监控定时器到期时调用，检查连接是否在规定的时间内发送过心跳包。
+     * @paras   pconnsockinfo   被监控的连接。
+     *          kConnHandle 添加定时器时连接的句柄，用于判断连接是否已经被关闭。
+     *          kCurrentTime    当前时间。
+     * @ret  0   操作成功。
+     * @time    2019-10-04
+    */
+    virtual int PingTimeOutChecking(XMNConnSockInfo *pconnsockinfo, const XMNConnHandle &kConnHandle, const time_t &kCurrentTime);
+
+    /**************************************************************************************
+     * 
+     ***************** 定时器相关操作 *****************
+     * 
+    **************************************************************************************/
+    /**
+     * @function    添加定时器，可以在任意线程中调用，到期时在 worker 进程的事件线程中执行。
+     *              业务逻辑可以借此执行延迟的任务，执行的函数中不要做耗时的操作。
+     * @paras   kDelayMs    多长时间之后执行，单位 ms ，精度为 XMN_TIMER_WHEEL_TICK_MS 。
+     *          kHandler    到期时执行的函数。
+     * @ret  > 0 定时器的编号。
+     *          0   添加失败。
+     * @time    2020-04-19
+    */
+    uint64_t AddTimer(const uint32_t &kDelayMs, const XMNTimerWheel::TimerHandler &kHandler);
+
+    /**
+     * @function    取消定时器。
+     * @paras   kTimerId    AddTimer 返回的定时器的编号。
+     * @ret  0   操作成功。
+     *          -1  定时器已经执行或者已经被取消。
+     * @time    2020-04-19
+    */
+    int CancelTimer(const uint64_t &kTimerId);
+
+    /**
+     * @function    线程池处理完一个消息之后调用，减少该连接尚未处理完的消息的数量，必要时恢复接收。
+     * @paras   kConnHandle 消息对应的连接的句柄。
+     * @ret  none 。
+     * @time    2020-04-29
+    */
+    void RecvMsgDone(const XMNConnHandle &kConnHandle);
+
+    /**
+     * @function    根据句柄获取连接，业务逻辑通过消息头中的句柄获取消息对应的连接。
+     * @paras   kConnHandle 连接的句柄。
+     * @ret  nullptr 连接已经关闭。
+     * @notice  返回的连接在当前线程离开 epoch 临界区之前不会被重新使用。
+     * @time    2020-04-21
+    */
+    XMNConnSockInfo *GetConnSockInfo(const XMNConnHandle &kConnHandle) const
+    {
+        return SingletonBase<XMNConnSlotTable>::GetInstance().Get(kConnHandle);
+    }
 
 protected:
     /**
-     * @function    发送数据。
+     * @function    处理网络层投递给线程池的内部消息，业务逻辑在 ThreadRecvProcFunc 中遇到 pkglen 为 0 的包时调用。
+     * @paras   pmsgbuf 内部消息，函数中释放。
+     * @ret  none 。
+     * @time    2020-04-28
+    */
+    void ThreadInnerProcFunc(char *pmsgbuf);
+
+    /**
+     * @function    发送数据，将消息放入对应连接的待发送消息链表中，
+     *              若该连接尚未等待发送，则直接发送（开启了 SendDirectEnable 时）或者将其放入发送连接队列中。
      * @paras   psenddata   待发送的数据。
      * @ret  0   操作成功。
+     *          -1  待发送的消息太多或者连接已断开，消息被丢弃。
+     *          -2  该连接积压了太多待发送的消息，连接被关闭。
      * @time    2019-09-25
     */
     int PutInSendDataQueue(char *psenddata);
 
     /**
-     * @function    向 client 发送消息。
-     * @paras   none 。
+     * @function    向 client 发送消息，一次发送多段数据。
+     * @paras   pconnsockinfo   待发送数据的连接。
+     *          piov    待发送的数据的数组。
+     *          kIovCnt 数组的元素个数。
+     *          kFlags  sendmsg 的 flags ，如 MSG_ZEROCOPY 。
      * @ret > 0 发送成功，返回值就是已发送的数据的字节数。
      *      0   对端已关闭。
      *      -1  发送缓冲区已满。
      *      -2  未知错误。
+     *      -3  MSG_ZEROCOPY 所需的内核内存不足，可以改用普通方式发送。
      * @time    2019-09-26
     */
-    int SendData(XMNConnSockInfo *pconnsockinfo);
+    ssize_t SendData(XMNConnSockInfo *pconnsockinfo, const struct iovec *piov, const int &kIovCnt, const int &kFlags);
+
+    /**
+     * @function    将连接的待发送消息链表中的消息尽量发送出去，每次最多组合 XMN_SEND_IOV_MAX 个消息。
+     *              调用者需持有该连接的 sendmutex_ 。
+     * @paras   pconnsockinfo   待发送数据的连接。
+     * @ret  0   链表中的消息全部发送完毕。
+     *          1   发送缓冲区已满，链表中还有消息，需要由 epoll 驱动发送。
+     *          -1  发送出错或者对端已关闭，链表中的消息已被丢弃。
+     * @time    2020-04-15
+    */
+    int FlushSendQueue(XMNConnSockInfo *pconnsockinfo);
+
+    /**
+     * @function    从 socket 的错误队列中读取 MSG_ZEROCOPY 的完成通知，并释放已经完成发送的消息。
+     *              由 epoll_wait 返回的 EPOLLERR 驱动。
+     * @paras   pconnsockinfo   开启了 SO_ZEROCOPY 的连接。
+     * @ret  读取到的完成通知的数量。
+     * @time    2020-04-16
+    */
+    int RecvZeroCopyCompletion(XMNConnSockInfo *pconnsockinfo);
 
     /**
      * @function    sever 端主动地关闭 socket 的函数。
@@ -488,38 +1247,153 @@ protected:
      *          -1  形参为空指针。
      * @time    2019-10-04
     */
-    int ActivelyCloseSocket(XMNConnSockInfo *pconnsockinfo);
+    int ActivelyCloseSocket(XMNConnSockInfo *pconnsockinfo);
+
+    /**
+     * @function    为连接生成 UDP 心跳的令牌，之前的令牌随之失效。
+     * @paras   pconnsockinfo   申请令牌的连接。
+     *          ptoken  存放令牌，网络字节序。
+     * @ret  0   操作成功。
+     *          -1  没有开启 UDP 心跳。
+     * @time    2020-04-26
+    */
+    int IssueUdpToken(XMNConnSockInfo *pconnsockinfo, XMNUdpToken *ptoken);
+
+private:
+    /**
+     * @function    读取配置文件中的内容。
+     * @paras   0  操作成功。
+     *          1  读取 port 数量失败。
+     *          2  读取 各个port 失败。
+     * @time    2019-08-26
+    */
+    int ReadConf();
+
+    /**
+     *  @function    打开指定数量的监听 socket 并进行相关配置。
+     *  @paras  none 。
+     *  @ret 0   操作成功。
+     *          -1  sokcet 创建失败。
+     *          -2  setsockopt 设置失败。
+     *          -3  SetNonBlocking 设置失败。
+     *          -4  bind 绑定失败。
+     *          -5  listen  监听失败。
+     *  @time   2019-08-25
+    */
+    int OpenListenSocket();
+
+    /**
+     *  @function    创建一个监听 socket 并加入到 vlistenportsockinfolist_ 中。
+     *  @paras  kPort   监听的端口号。
+     *          kWorkerIndex    独占该 socket 的 worker 进程的编号，-1 表示所有 worker 进程共享。
+     *          pprofile    该端口使用的 socket 配置方案。
+     *  @ret >= 0    创建的监听 socket 。
+     *          < 0 同 OpenListenSocket 的返回值。
+     *  @time   2020-04-06
+    */
+    int OpenOneListenSocket(const size_t &kPort, const int &kWorkerIndex, const XMNSocketProfile *pprofile);
+
+    /**
+     *  @function    创建一个 Unix 域监听 socket 并加入到 vlistenportsockinfolist_ 中，所有 worker 进程共享。
+     *  @paras  kstrPath    socket 文件的路径，已经存在的同名文件会被删除。
+     *          pprofile    使用的 socket 配置方案，只有 Backlog 、SendBuf 和 RecvBuf 生效。
+     *  @ret >= 0    创建的监听 socket 。
+     *          < 0 同 OpenListenSocket 的返回值。
+     *  @time   2020-04-25
+    */
+    int OpenUnixListenSocket(const std::string &kstrPath, const XMNSocketProfile *pprofile);
+
+    /**
+     *  @function    读取名称为 kstrName 的 socket 配置方案，已经读取过的直接返回。
+     *  @paras  kstrName    配置方案的名称，配置文件中的选项为 "名称.选项" ，例如 lowlatency.NoDelay 。
+     *  @ret >= 0    配置方案在 vsocketprofile_ 中的下标。
+     *          -1  选项的值非法。
+     *  @time   2020-04-25
+    */
+    int ReadSocketProfile(const std::string &kstrName);
+
+    /**
+     *  @function    按照监听端口的 socket 配置方案设置新连接的 socket 选项，失败时只记录日志。
+     *  @paras  kSockFd 连接 socket 。
+     *          kProfile    socket 配置方案。
+     *  @ret  none 。
+     *  @time   2020-04-25
+    */
+    void ApplyConnSocketProfile(const int &kSockFd, const XMNSocketProfile &kProfile);
+
+    /**
+     *  @function    向 reuseport 组中挂载 CBPF 程序，按照接收数据包的 CPU 编号选择组内的 socket 。
+     *  @paras  kSockFd 组内任意一个监听 socket 。
+     *  @ret 0   操作成功。
+     *  @time   2020-04-06
+    */
+    int AttachReusePortCpuProgram(const int &kSockFd);
+
+    /**
+     *  @function    为每个 worker 进程创建一个接收 UDP 心跳的 socket ，组成 reuseport 组，
+     *              并挂载按照令牌中的 worker 编号选择 socket 的 CBPF 程序。
+     *  @paras  none 。
+     *  @ret 0   操作成功或者没有开启 UDP 心跳。
+     *          < 0 同 OpenListenSocket 的返回值。
+     *  @time   2020-04-26
+    */
+    int OpenUdpSocket();
+
+    /**
+     *  @function   关闭监听 socket 。
+     *  @paras  none 。
+     *  @ret 0   操作成功。
+     *  @time   2019-08-25
+    */
+    int CloseListenSocket();
+
+public:
+    /**
+     *  @function   关闭不属于指定 worker 进程的独占监听 socket 。
+     *              master 进程在创建完所有 worker 进程之后以 -1 调用，不再持有任何独占的 socket ，
+     *              这样某个 worker 进程退出后，其 socket 会随之离开 reuseport 组。
+     *  @paras  kWorkerIndex    需要保留的 worker 进程的编号。
+     *  @ret 0   操作成功。
+     *  @time   2020-04-06
+    */
+    int CloseWorkerListenSocket(const int &kWorkerIndex);
 
-private:
     /**
-     * @function    读取配置文件中的内容。
-     * @paras   0  操作成功。
-     *          1  读取 port 数量失败。
-     *          2  读取 各个port 失败。
-     * @time    2019-08-26
+     *  @function   是否需要将 worker 进程绑定到 CPU 上，以配合 reuseport 的 CPU 分配策略。
+     *  @paras  none 。
+     *  @ret true   需要绑定。
+     *  @time   2020-04-06
     */
-    int ReadConf();
+    bool IsReusePortCpuSteering() const
+    {
+        return reuseportcpusteering_;
+    }
 
     /**
-     *  @function    打开指定数量的监听 socket 并进行相关配置。
+     *  @function   reactor 线程的数量，用于规划 CPU 绑定。
+     *  @time   2020-04-24
+    */
+    size_t ReactorThreadCount() const
+    {
+        return reactorthreadcount_;
+    }
+
+private:
+    /**
+     *  @function    将所有监听 socket 加入 epoll 中，开始 accept 新连接。
      *  @paras  none 。
      *  @ret 0   操作成功。
-     *          -1  sokcet 创建失败。
-     *          -2  setsockopt 设置失败。
-     *          -3  SetNonBlocking 设置失败。
-     *          -4  bind 绑定失败。
-     *          -5  listen  监听失败。
-     *  @time   2019-08-25
+     *  @time   2020-04-08
     */
-    int OpenListenSocket();
+    int EnableAcceptEvents();
 
     /**
-     *  @function   关闭监听 socket 。
+     *  @function    将所有监听 socket 从 epoll 中删除，暂停 accept 新连接。
      *  @paras  none 。
      *  @ret 0   操作成功。
-     *  @time   2019-08-25
+     *  @time   2020-04-08
     */
-    int CloseListenSocket();
+    int DisableAcceptEvents();
 
     /**
      *  @function    设置文件 IO 为非堵塞。
@@ -558,30 +1432,179 @@ private:
     void WaitWriteRequestHandler(XMNConnSockInfo *pconnsockinfo);
 
     /**
-     * @function    从指定的连接中接收 bufflen 字节的数据到 pbuff 中。
+     * @function    由 epoll_wait 驱动，EpollProcessEvents 调用的函数。
+     *              timerfd 可读时执行到期的定时器。
+     * @paras   pconnsockinfo   绑定了 timerfd 的连接。
+     * @ret  none 。
+     * @time    2020-04-19
+    */
+    void TimerRequestHandler(XMNConnSockInfo *pconnsockinfo);
+
+    /**
+     * @function    由 epoll_wait 驱动，EpollProcessEvents 调用的函数。
+     *              UDP socket 可读时通过 recvmmsg 批量读取心跳包，按照令牌找到对应的 TCP 连接并更新心跳时间，
+     *              回复通过 sendmmsg 批量发送，不经过线程池。
+     * @paras   pconnsockinfo   绑定了 UDP socket 的连接。
+     * @ret  none 。
+     * @time    2020-04-26
+    */
+    void UdpRequestHandler(XMNConnSockInfo *pconnsockinfo);
+
+    /**
+     * @function    由事件后端驱动，reactor 线程的 eventfd 可读时调用，只是取走计数。
+     * @paras   pconnsockinfo   绑定了 eventfd 的连接。
+     * @ret  none 。
+     * @time    2020-04-23
+    */
+    void ReactorWakeupHandler(XMNConnSockInfo *pconnsockinfo);
+
+    /**
+     * @function    按照配置创建事件后端，io_uring 不可用时退回到 epoll 。
+     * @paras   none 。
+     * @ret  非 nullptr  初始化成功的事件后端。
+     *          nullptr 初始化失败。
+     * @time    2020-04-23
+    */
+    XMNEventBackend *CreateEventBackend();
+
+    /**
+     * @function    等待并分发一个 reactor 上的事件，主事件循环和 reactor 线程共用。
+     * @paras   preactor    reactor 。
+     *          kTimer  等待事件的超时时间，单位 ms ，-1 表示一直堵塞。
+     * @ret  0   操作成功。
+     * @time    2020-04-23
+    */
+    int ReactorProcessEvents(Reactor *preactor, const int &kTimer);
+
+    /**
+     * @function    reactor 线程，循环处理分配给该 reactor 的连接的事件，直至 worker 进程退出。
+     * @paras   preactor    该线程的相关信息，即：Reactor 。
+     * @ret  nullptr   操作成功。
+     * @time    2020-04-23
+    */
+    static void *ReactorThread(void *preactor);
+
+    /**
+     * @function    为新连接选择 reactor ，没有 reactor 线程时为主事件循环。
+     * @paras   none 。
+     * @ret  reactor 的下标。
+     * @time    2020-04-23
+    */
+    size_t SelectReactor();
+
+    /**
+     * @function    唤醒所有的 reactor 线程，使其离开并重新进入 epoch 临界区。
+     *              堵塞在 Wait 中的 reactor 线程会阻止全局 epoch 的推进。
+     * @paras   none 。
+     * @ret  none 。
+     * @time    2020-04-23
+    */
+    void WakeupReactors();
+
+    /**
+     * @function    从指定的连接中接收数据，一次填满该连接的接收缓冲区的空闲空间。
      * @paras   pconnsockinfo   待接收数据的连接。
      * @ret > 0 接收到的数据的字节数。
-     *      = 0 client 已经关闭。
+     *      = 0 client 已经关闭或者暂时没有数据。
      *      < 0 有异常。
      * @time    2019-08-31
     */
     ssize_t RecvData(XMNConnSockInfo *pconnsockinfo);
 
     /**
-     * @function    判断该包是否正常以及为接收包体做准备。
+     * @function    从接收缓冲区中解析出所有完整的包，一次性压入消息队列中。
+     *              不完整的包留在接收缓冲区中。
      * @paras   pconnsockinfo   待处理的连接。
      * @ret  none 。
-     * @time    2019-08-31
+     * @time    2020-04-14
     */
-    void WaitRequestHandlerHeader(XMNConnSockInfo *pconnsockinfo);
+    void ParseRecvRingBuffer(XMNConnSockInfo *pconnsockinfo);
 
     /**
-     * @function    对接收的完整的包进行处理（压入消息队列中并初始化状态机）。
+     * @function    将接收缓冲区中正在接收的大包的包体按块取出，放入该连接的包体块链表中。
      * @paras   pconnsockinfo   待处理的连接。
+     *          pcoldinfo   该连接的冷数据，其中记录了大包的解析状态。
+     * @ret  0   操作成功，包体接收完毕时 streambodylen 被置为 0 。
+     *          -1  积压的包体块超过了 streammaxpendingchunks_ ，需要断开连接。
+     * @time    2020-04-27
+    */
+    int ParseStreamBody(XMNConnSockInfo *pconnsockinfo, XMNConnColdInfo *pcoldinfo);
+
+    /**
+     * @function    向线程池投递一个内部消息。
+     * @paras   pconnsockinfo   消息对应的连接，内部消息也计入该连接尚未处理完的消息的数量。
+     *          kType   内部消息的类型，取值为 XMN_INNER_MSG_* 。
+     * @ret  0   操作成功。
+     *          -1  申请内存失败，没有投递。
+     * @time    2020-04-28
+    */
+    int PutInInnerMsg(XMNConnSockInfo *pconnsockinfo, const uint16_t &kType);
+
+    /**
+     * @function    按顺序取出该连接积压的所有包体块，逐个调用 HandleStreamChunk 。
+     * @paras   pconnsockinfo   消息对应的连接。
+     * @ret  none 。
+     * @time    2020-04-27
+    */
+    void ProcessStreamChunks(XMNConnSockInfo *pconnsockinfo);
+
+    /**
+     * @function    调用该连接的流式发送对象的 OnWritable ，发送完毕时释放该对象，否则等待下一次可写。
+     * @paras   pconnsockinfo   消息对应的连接。
+     * @ret  none 。
+     * @time    2020-04-28
+    */
+    void ProcessWritable(XMNConnSockInfo *pconnsockinfo);
+
+    /**
+     * @function    连接的流式发送在等待可写，并且待发送的数据已经降到低水位以下时，投递 XMN_INNER_MSG_WRITABLE 。
+     *              调用者需持有该连接的 sendmutex_ 。投递失败时保持等待，下一个 tick 由定时器重试。
+     * @paras   pconnsockinfo   刚刚发送过数据或者释放过消息的连接。
      * @ret  none 。
-     * @time    2019-09-01
+     * @time    2020-04-28
+    */
+    void CheckStreamWritable(XMNConnSockInfo *pconnsockinfo);
+
+    /**************************************************************************************
+     * 
+     ***************** 背压相关的函数 *****************
+     * 
+    **************************************************************************************/
+    /**
+     * @function    连接或者 worker 进程是否有任何一项积压达到了高水位。
+     * @time    2020-04-29
+    */
+    bool IsRecvOverloaded(XMNConnSockInfo *pconnsockinfo);
+
+    /**
+     * @function    连接和 worker 进程的所有积压是否都已经降到了低水位以下。
+     * @time    2020-04-29
+    */
+    bool IsRecvDrained(XMNConnSockInfo *pconnsockinfo);
+
+    /**
+     * @function    积压达到高水位时暂停该连接的接收：去掉 EPOLLIN ，由 TCP 的流量控制让 client 放慢发送。
+     *              调用者需持有该连接的 sendmutex_ 。
+     * @paras   pconnsockinfo   待检查的连接。
+     * @ret  true    该连接处于暂停接收的状态。
+     * @time    2020-04-29
+    */
+    bool PauseRecv(XMNConnSockInfo *pconnsockinfo);
+
+    /**
+     * @function    积压都降到低水位以下时恢复该连接的接收。调用者需持有该连接的 sendmutex_ 。
+     * @paras   pconnsockinfo   待检查的连接。
+     * @ret  true    该连接仍处于暂停接收的状态。
+     * @time    2020-04-29
+    */
+    bool ResumeRecv(XMNConnSockInfo *pconnsockinfo);
+
+    /**
+     * @function    定时检查所有暂停接收的连接，用于 worker 进程的积压降下来、而连接本身没有任何动静的情况。
+     *              暂停接收的连接的列表不为空时每个 tick 执行一次。
+     * @time    2020-04-29
     */
-    void WaitRequestHandlerBody(XMNConnSockInfo *pconnsockinfo);
+    void ResumePausedConns();
 
     /**************************************************************************************
      * 
@@ -592,6 +1615,7 @@ private:
      * @function    从连接池中取出一个连接，将 accept 返回的 socket 和该连接进行关联。
      * @paras   kSockFd accept 返回的 socket 。
      * @ret 绑定好的连接池中的一个连接。
+     *          nullptr 连接槽表中没有空闲的槽。
      * @time    2019-09-19
     */
     XMNConnSockInfo *PutOutConnSockInfofromPool(const int &kSockFd);
@@ -613,12 +1637,22 @@ private:
     void PutInConnSockInfo2RecyList(XMNConnSockInfo *pconnsockinfo);
 
     /**
-     * @function    定时将到时的连接归还至空闲连接池中。
-     * @paras   pthreadinfo 线程的相关信息。
-     * @ret  nullptr .
+     * @function    回收定时器到期时，将已经没有线程能够访问的连接归还至连接池中。
+     *              连接放入回收链表之后全局 epoch 推进了两次，且不在发送连接队列中时，即可归还。
+     *              回收链表不为空时，每个 tick 执行一次。
+     * @paras   none 。
+     * @ret  none 。
      * @time    2019-09-19
     */
-    static void *ConnSockInfoRecycleThread(void *pthreadinfo);
+    void RecycleConnSockInfo();
+
+    /**
+     * @function    将回收链表中所有的连接归还至连接池中，worker 进程退出时调用。
+     * @paras   none 。
+     * @ret  none 。
+     * @time    2020-04-19
+    */
+    void FreeRecycleConnSockInfo();
 
     /**
      * @function    关闭已经建立的连接。
@@ -642,24 +1676,24 @@ private:
      * 
     **************************************************************************************/
     /**
-     * @function    发送数据线程，每次循环只发送一次数据。
-     * @paras   pthreadinfo   线程的相关信息。
+     * @function    发送数据线程，每次被唤醒后取走所负责的发送连接队列中的全部连接，
+     *              对每个连接用一次 writev/sendmsg 发出其待发送消息链表中所有的消息。
+     * @paras   psendshard   该线程的相关信息，即：SendShard 。
      * @ret  nullptr   操作成功。
      * @time    2019-09-25
     */
-    static void *SendDataThread(void *pthreadinfo);
+    static void *SendDataThread(void *psendshard);
 
     /**
-     * @function    从存储待发送的数据的数据池中获得消息。
-     * @paras   none 。
-     * @ret  非 nullptr  待发送的消息。
-     *          nullptr 数据池中不存在消息。
-     * @time    2019-09-25
+     * @function    将连接放入负责它的发送数据线程的发送连接队列中，必要时唤醒该线程。
+     * @paras   pconnsockinfo   待发送数据的连接。
+     * @ret  none 。
+     * @time    2020-04-18
     */
-    char *PutOutSendDataFromQueue();
+    void PutInSendShard(XMNConnSockInfo *pconnsockinfo);
 
     /**
-     * @function    释放发送队列中的消息。
+     * @function    释放所有发送连接队列中各个连接的待发送的消息。
      * @paras   none 。
      * @ret  0   操作成功。
      * @time    2019-09-26
@@ -672,64 +1706,20 @@ private:
      * 
     **************************************************************************************/
     /**
-     * @function    将指定的连接信息放入 multimap 中，等待心跳监控。
-     * @paras   connsockinfo   指定的连接的信息。
-     * @ret  0   操作成功。
-     * @time    2019-10-04
-    */
-    int PutInConnSockInfo2PingMultiMap(XMNConnSockInfo *pconnsockinfo);
-
-    /**
-     * @function    从 multimap 中获取最早的时间，即：头部元素。
-     * @paras   none 。
-     * @ret  最早的时间。
-     * @time    2019-10-04
-    */
-    time_t GetEarliestTime();
-
-    /**
-     * @function    对心跳包进行监控的执行线程，执行过程：
-     *                  当发现某个连接的上次心跳包的通信时间与当前时间差值超过 3*pingwaittime_ 时，
-     *               认为该连接的对端已经关闭，server 端可以主动断开连接。
-     *                  该线程的检查周期当当前时间超过 ping_multimap_ 中最早的时间时，则按照上述步骤检查一遍。   
-     * @paras   pthreadinfo 该线程的相关信息。
+     * @function    为指定的连接添加心跳监控定时器，每隔 pingwaittime_ 检查一次。
+     * @paras   pconnsockinfo   指定的连接。
      * @ret  none 。
      * @time    2019-10-04
     */
-    static void *PingThread(void *pthreadinfo);
-
-    /**
-     * @function    从监控 map 中找到比指定 time 最早的消息头。
-     * @paras   待比较的时间。
-     * @ret  满足条件的消息。
-     * @time    2019-10-04
-    */
-    XMNMsgHeader *GetOverTimeMsgHeader(const time_t &timetmp);
-
-    /**
-     * @function    从监控 map 中移除最早的时间并返回该消息。
-     * @paras   none 。
-     * @ret  最早时间的消息。
-     * @time    2019-10-04
-    */
-    XMNMsgHeader *RemoveFirstMsgHeader();
-
-    /**
-     * @function    从心跳监控的 multimap 中删除指定的消息头。
-     * @paras   connsockinfo   待删除的连接。
-     * @ret  0   操作成功。
-     *          -1  形参为空指针。
-     * @time    2019-10-04
-    */
-    int PutOutMsgHeaderFromMultiMap(XMNConnSockInfo *pconnsockinfo);
+    void PutInConnSockInfo2PingTimer(XMNConnSockInfo *pconnsockinfo);
 
     /**
-     * @function    清空并释放心跳监控 multimap 。
-     * @paras   none 。
+     * @function    心跳监控定时器到期时执行，重新添加定时器之后检查该连接。
+     * @paras   kConnHandle 添加定时器时连接的句柄，连接已经关闭时不再检查。
      * @ret  none 。
      * @time    2019-10-04
     */
-    void FreePingMultiMap();
+    void PingTimerHandler(const XMNConnHandle &kConnHandle);
 
     /**************************************************************************************
      * 
@@ -764,11 +1754,16 @@ protected:
     **************************************************************************************/
     /**
      * 两个功能：
-     * 1、对于连接来说，每隔 pingwaittime_ 时间，HandlePing 线程就会检查一次该连接是否已经朝时了。
+     * 1、对于连接来说，每隔 pingwaittime_ 时间，心跳监控定时器就会检查一次该连接是否已经超时了。
      * 2、上述的超时时间就是 pingwaittime_ * 3 ，如果超时则断开连接。
     */
     size_t pingwaittime_;
 
+    /**
+     * 扩展包头允许的最大包体长度，0 表示不接收扩展包头，同时也是下载请求的长度上限。
+    */
+    size_t pkgmaxbodylen_;
+
 private:
     /**
      *  监听的 port 的数量。
@@ -780,6 +1775,19 @@ private:
     */
     std::vector<size_t> vportsum_;
 
+    /**
+     * 所有用到的 socket 配置方案，在 ReadConf 中读取之后不再改变（监听 socket 中保存了指向其元素的指针），
+     * vportprofile_ 中保存各个 port 使用的方案的下标。
+    */
+    std::vector<XMNSocketProfile> vsocketprofile_;
+    std::vector<size_t> vportprofile_;
+
+    /**
+     * Unix 域监听 socket 的路径以及各自使用的 socket 配置方案的下标。
+    */
+    std::vector<std::string> vunixpath_;
+    std::vector<size_t> vunixprofile_;
+
     /**
      * 监听的 port 以及其对应的监听 socket 的 vector。
     */
@@ -791,14 +1799,178 @@ private:
     int worker_connection_count_;
 
     /**
-     * epoll 对象的文件描述符。
+     * worker 进程的数量。
+    */
+    size_t worker_process_count_;
+
+    /**
+     * 是否为每个 worker 进程创建独占的 SO_REUSEPORT 监听 socket 。
+    */
+    bool reuseportenable_;
+
+    /**
+     * 是否按照接收数据包的 CPU 将连接分配给绑定在该 CPU 上的 worker 进程。
+    */
+    bool reuseportcpusteering_;
+
+    /**
+     * accept 负载均衡的方式，取值为 XMN_ACCEPT_BALANCE_* 。
+    */
+    int acceptbalancemode_;
+
+    /**
+     * 在线人数达到该值时暂停 accept ，0 表示不限制。
+    */
+    size_t acceptstopcount_;
+
+    /**
+     * 暂停 accept 之后，在线人数降到该值以下时恢复 accept 。
+    */
+    size_t acceptresumecount_;
+
+    /**
+     * 监听 socket 当前是否在 epoll 中。
+    */
+    bool acceptenabled_;
+
+    /**
+     * 没有获取到 accept 互斥量的 worker 进程，再次尝试获取的时间间隔，单位 ms 。
+    */
+    int acceptmutexdelay_;
+
+    /**
+     * 进程间共享的 accept 互斥量。
+    */
+    XMNAcceptMutex *paccept_mutex_;
+
+    /**
+     * 本进程当前是否持有 accept 互斥量。
+    */
+    bool acceptmutexheld_;
+
+    /**
+     * 是否开启 epoll 的边缘触发模式（ET）。
+     * 开启后，accept 和 recv 都会循环执行直至返回 EAGAIN ，以减少 epoll_wait 的唤醒次数。
+    */
+    bool epolletenable_;
+
+    /**
+     * 事件后端的类型，取值为 XMN_EVENT_BACKEND_* 。
+    */
+    int eventbackend_;
+
+    /**
+     * io_uring 后端的 SQ 大小、接收缓冲区的数量以及每个接收缓冲区的大小。
+    */
+    unsigned uringentries_;
+    unsigned uringrecvbuffcount_;
+    unsigned uringrecvbuffsize_;
+
+    /**
+     * 每个连接的接收缓冲区的大小。
+    */
+    size_t recvbuffsize_;
+
+    /**
+     * 流式发送的高水位和低水位（字节），待发送的数据达到高水位时 StreamWrite 返回 1 ，降到低水位以下时再次调用 OnWritable 。
+    */
+    size_t streamhighwater_;
+    size_t streamlowwater_;
+
+    /**************************************************************************************
+     * 
+     ***************** 与背压相关的变量 **************** 
+     * 
+    **************************************************************************************/
+    /**
+     * 是否开启背压：积压达到高水位时暂停连接的接收，而不是断开连接。
+    */
+    bool backpressureenable_;
+
+    /**
+     * 每个连接的高低水位：尚未处理完的接收的消息的数量、待发送的字节数。
+     * 待发送的消息的数量固定以 XMN_SEND_MAX_PENDING_MSGS 的 1/2 和 1/4 为高低水位。
+    */
+    size_t connrecvhighwater_;
+    size_t connrecvlowwater_;
+    size_t connsendhighwater_;
+    size_t connsendlowwater_;
+
+    /**
+     * worker 进程的接收消息队列和发送消息队列中消息数量的高低水位，超过高水位时每个有数据到达的连接都暂停接收。
+    */
+    size_t recvqueuehighwater_;
+    size_t recvqueuelowwater_;
+    size_t sendqueuehighwater_;
+    size_t sendqueuelowwater_;
+
+    /**
+     * 每个连接最多积压的待发送的消息的数量，超过时断开连接。
+     * 开启背压时，暂停接收之前已经收到的包仍会产生回复，所以在 XMN_SEND_MAX_PENDING_MSGS 的基础上留出余量。
+    */
+    size_t sendmaxpendingmsgs_;
+
+    /**
+     * 每个连接最多积压的大包的数据块的数量，超过时断开连接。开启背压时同样在 XMN_STREAM_MAX_PENDING_CHUNKS 的基础上留出余量。
+    */
+    size_t streammaxpendingchunks_;
+
+    /**
+     * 暂停了接收的连接的句柄，由 ResumePausedConns 定时检查。
+    */
+    std::vector<XMNConnHandle> vrecvpaused_;
+    pthread_mutex_t recvpausedmutex_;
+
+    /**
+     * ResumePausedConns 的定时器是否正在运行，与 vrecvpaused_ 一起由 recvpausedmutex_ 保护。
+    */
+    bool isrecvpausedtimer_;
+
+    /**
+     * 统计：暂停接收的次数，由 PrintInfo 输出后清零。
+    */
+    std::atomic<size_t> recvpausecount_;
+
+    /**
+     * 是否开启零拷贝发送，以及一次发送的数据达到多少字节时才使用 MSG_ZEROCOPY 。
+    */
+    bool sendzerocopyenable_;
+    size_t sendzerocopythreshold_;
+
+    /**
+     * 是否由调用 PutInSendDataQueue 的线程直接发送数据，只有连接上没有积压的消息时才直接发送。
+    */
+    bool senddirectenable_;
+
+    /**
+     * 忙轮询：最近一次取到事件之后的 busypollspinns_ 时间内以超时时间 0 调用 Wait ，之后恢复堵塞等待。0 表示关闭。
+    */
+    uint64_t busypollspinns_;
+
+    /**
+     * 为新连接设置的 SO_BUSY_POLL 的值，单位 us ，同时设置 SO_PREFER_BUSY_POLL 。0 表示不设置。
+    */
+    int busypollsocketus_;
+
+    /**
+     * 本 worker 进程的各个 reactor ，在 EpollInit 中创建，下标为 0 的是主事件循环。
+    */
+    std::vector<Reactor *> vreactor_;
+
+    /**
+     * reactor 线程的数量，为 0 时所有的连接都由主事件循环处理。
+    */
+    size_t reactorthreadcount_;
+
+    /**
+     * 新连接分配给 reactor 线程的方式，取值为 XMN_REACTOR_DISPATCH_* 。
     */
-    int epoll_handle_;
+    int reactordispatchmode_;
 
     /**
-     * 用于存储 epoll_wait() 返回的发生的事件。
+     * 轮流分配时下一个 reactor 线程的序号。
     */
-    struct epoll_event wait_events_[XMN_EPOLL_WAIT_MAX_EVENTS];
+    size_t reactornext_;
 
     /**
      * 保存每个 worker 进程专用的供 socket 类使用的线程的信息。
@@ -816,7 +1988,7 @@ private:
     pthread_mutex_t connsock_pool_mutex_;
 
     /**
-     * 待回收的连接的列表。
+     * 待回收的连接的列表，按照放入的先后顺序，即：retireepoch 从小到大排列。
     */
     std::list<XMNConnSockInfo *> recycleconnsock_pool_;
 
@@ -830,35 +2002,25 @@ private:
     */
     pthread_mutex_t connsock_pool_recycle_mutex_;
 
-    /**
-     * 待回收的连接的等待时间。
-    */
-    int recyconnsockinfowaittime_;
-
     /**************************************************************************************
      * 
      ***************** 与发送消息相关的变量 **************** 
      * 
     **************************************************************************************/
     /**
-     * 发送消息队列。
-    */
-    std::queue<char *> senddata_queue_;
-
-    /**
-     * 发送消息队列中消息的数量。
+     * 所有连接的待发送消息链表中消息的总数量。
     */
     std::atomic<size_t> queue_senddata_count_;
 
     /**
-     * 有关发送消息队列的相关操作的互斥量。
+     * 发送数据线程的数量。
     */
-    pthread_mutex_t senddata_queue_mutex_;
+    size_t sendthreadcount_;
 
     /**
-     * 与发送消息操作相关的信号量。
+     * 各个发送数据线程的信息，连接按照 socket 描述符分配给其中的一个。
     */
-    sem_t senddata_queue_sem_;
+    std::vector<SendShard *> vsendshard_;
 
     /**************************************************************************************
      * 
@@ -870,28 +2032,61 @@ private:
     */
     bool pingenable_;
 
+    /**************************************************************************************
+     * 
+     ***************** 与定时器相关的变量 **************** 
+     * 
+    **************************************************************************************/
     /**
-     * 与心跳监控的 multimap 相关的互斥量。
+     * 心跳监控、连接回收以及业务逻辑的定时器所在的时间轮。
     */
-    pthread_mutex_t ping_multimap_mutex_;
+    XMNTimerWheel timerwheel_;
 
     /**
-     * 被心跳监控的连接信息的 multimap 。
+     * 绑定了时间轮的 timerfd 的连接。
+    */
+    XMNConnSockInfo *ptimerconnsockinfo_;
+
+    /**************************************************************************************
+     * 
+     ***************** 与 UDP 心跳相关的变量 **************** 
      * 
-     * time_t   表示下次要进行心跳包通信的最长时间。
-     * XMNMsgHeader 当前连接的消息头。
+    **************************************************************************************/
+    /**
+     * 接收 UDP 心跳的端口，0 表示不开启。
     */
-    std::multimap<time_t, XMNMsgHeader *> ping_multimap_;
+    size_t udpport_;
 
     /**
-     * ping_multimap_ 元素个数。
+     * 各个 worker 进程的 UDP socket ，下标为 worker 编号，worker 进程中只保留自己的。
     */
-    std::atomic<size_t> ping_multimap_count_;
+    std::vector<int> vudpsockfd_;
+
+    /**
+     * 绑定了本 worker 进程的 UDP socket 的连接。
+    */
+    XMNConnSockInfo *pudpconnsockinfo_;
+
+    /**
+     * recvmmsg/sendmmsg 使用的缓冲区，只在主事件循环中使用，在 EpollInit 中申请。
+    */
+    struct UdpBatch
+    {
+        struct mmsghdr recvmsgs[XMN_UDP_BATCH_MAX_MSGS];
+        struct mmsghdr sendmsgs[XMN_UDP_BATCH_MAX_MSGS];
+        struct iovec recviov[XMN_UDP_BATCH_MAX_MSGS];
+        struct iovec sendiov[XMN_UDP_BATCH_MAX_MSGS];
+        struct sockaddr_storage addrs[XMN_UDP_BATCH_MAX_MSGS];
+        char recvbuf[XMN_UDP_BATCH_MAX_MSGS][XMN_UDP_DGRAM_MAX_LEN];
+        char sendbuf[XMN_UDP_BATCH_MAX_MSGS][sizeof(XMNPkgHeader)];
+    };
+    UdpBatch *pudpbatch_;
 
     /**
-     * ping_multimap_ 中最早时间的值。
+     * 统计：处理的 UDP 心跳包的数量以及被丢弃的数据报的数量，由 PrintInfo 输出后清零。
     */
-    time_t ping_multimap_headtime_;
+    size_t udppingcount_;
+    size_t udpdropcount_;
 
     /**************************************************************************************
      * 
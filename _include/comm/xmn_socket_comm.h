@@ -1,6 +1,8 @@
 #ifndef XMOON__INCLUDE_XMN_COMM_H_
 #define XMOON__INCLUDE_XMN_COMM_H_
 
+#include <stdint.h>
+
 /**
  * server 从 client 能够接收的最大的字节数量。
 */
@@ -8,59 +10,85 @@
 
 /****************************************************
  * 
- * 定义 server 接收 client 发来的数据的状态。
+ * 包头结构，这些数据有 client 发给 server 。
  * 
 ****************************************************/
-enum RecvStatus
+/**
+ * 使得结构体中各个成员紧密的挨在一起，保证所有的系统收发的包头的字节数是一样的。
+*/
+
+struct XMNPkgHeader
 {
     /**
-    * 开始接收数据的包头。
-    */
-    PKG_HD_INIT = 0,
-    /**
-    * 包头没有接收完，需要继续接收。
+     * 报文的总长度（包头 + 包体）。
     */
-    PKG_HD_RECVING = 1,
+    unsigned short pkglen;
+
     /**
-    * 包头接收完毕，开始接收包体。
+     * 消息类型的代码，用于区别不同的命令（消息）。
     */
-    PKG_BD_INIT = 2,
+    unsigned short msgcode;
+
     /**
-    * 包体没有接收完，需要继续继续接收包体。
+     * CRC32 校验，用于防止接收到的数据和 client 发送的数据不符的问题。
     */
-    PKG_BD_RECVING = 3
-};
+    int crc32;
+} __attribute__((packed));
 
 /**
- * XMNListenSockInfo 中存放的包头数据的数组的大小。
+ * 扩展包头的标记：pkglen 为该值时，包头为 XMNPkgHeaderExt ，包体长度由 bodylen 给出。
 */
-#define XMN_PKG_HEADER_SIZE 20
+#define XMN_PKG_EXT_MARK 0xFFFF
 
 /****************************************************
  * 
- * 包头结构，这些数据有 client 发给 server 。
+ * 扩展包头，用于包体超过 PKG_MAX_LEN 的大包，各个字段均为网络字节序。
+ * 前 4 个字节与 XMNPkgHeader 相同，server 据此区分两种包头；包体由 server 分块交给业务逻辑。
  * 
 ****************************************************/
-/**
- * 使得结构体中各个成员紧密的挨在一起，保证所有的系统收发的包头的字节数是一样的。
-*/
-
-struct XMNPkgHeader
+struct XMNPkgHeaderExt
 {
     /**
-     * 报文的总长度（包头 + 包体）。
+     * 固定为 XMN_PKG_EXT_MARK 。
     */
     unsigned short pkglen;
 
-    /**
-     * 消息类型的代码，用于区别不同的命令（消息）。
-    */
     unsigned short msgcode;
 
     /**
-     * CRC32 校验，用于防止接收到的数据和 client 发送的数据不符的问题。
+     * 整个包体的 CRC32 校验。
     */
     int crc32;
+
+    /**
+     * 包体的长度（不含包头）。
+    */
+    uint32_t bodylen;
+} __attribute__((packed));
+
+/****************************************************
+ * 
+ * UDP 心跳的令牌，由 client 通过 TCP 连接申请，之后放在 UDP 心跳包的包体中。
+ * 各个字段均为网络字节序，workerindex 必须位于包体的开头，reuseport 的 CBPF 程序据此选择 worker 进程。
+ * 
+****************************************************/
+struct XMNUdpToken
+{
+    /**
+     * TCP 连接所在的 worker 进程的编号。
+    */
+    uint32_t workerindex;
+
+    /**
+     * TCP 连接的句柄，即：槽的下标和代数。
+    */
+    uint32_t slotindex;
+    uint32_t generation;
+
+    /**
+     * 申请令牌时生成的随机数，防止伪造他人的令牌。
+    */
+    uint32_t nonce;
 } __attribute__((packed));
 
 #endif
\ No newline at end of file
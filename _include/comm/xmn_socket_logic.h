@@ -17,6 +17,13 @@ struct NoBodyInfoAll
     XMNPkgHeader pkgheader;
 } __attribute__((packed));
 
+struct UdpTokenInfoAll
+{
+    XMNMsgHeader msgheader;
+    XMNPkgHeader pkgheader;
+    XMNUdpToken udptoken;
+} __attribute__((packed));
+
 struct LoginInfoAll
 {
     XMNMsgHeader msgheader;
@@ -50,6 +57,18 @@ public:
         char *ppkgbody,
         size_t pkgbodylen);
 
+    int HandleUdpToken(
+        XMNMsgHeader *pmsgheader,
+        char *ppkgbody,
+        size_t pkgbodylen);
+
+    int HandleDownload(
+        XMNMsgHeader *pmsgheader,
+        char *ppkgbody,
+        size_t pkgbodylen);
+
+    int HandleUpload(XMNStreamChunk *pchunk);
+
     /**
      * @function 向 client 发送无包体的数据。
      * @paras   pmsgheader  消息头。
@@ -61,7 +80,8 @@ public:
 
 public:
     virtual void ThreadRecvProcFunc(char *pmsgbuf);
-    virtual int PingTimeOutChecking(XMNMsgHeader *pmsgheader, time_t currenttime);
+    virtual void HandleStreamChunk(XMNStreamChunk *pchunk);
+    virtual int PingTimeOutChecking(XMNConnSockInfo *pconnsockinfo, const XMNConnHandle &kConnHandle, const time_t &kCurrentTime);
 };
 
 #endif
\ No newline at end of file
@@ -6,8 +6,21 @@
  * 心跳包。
 */
 #define CMD_LOGIC_PING (CMD_LOGIC_START + 0)
+/**
+ * 申请 UDP 心跳的令牌，回复的包体为 XMNUdpToken 。
+*/
+#define CMD_LOGIC_UDP_TOKEN (CMD_LOGIC_START + 1)
 #define CMD_LOGIC_REGISTER (CMD_LOGIC_START + 5)
 #define CMD_LOGIC_LOGIN (CMD_LOGIC_START + 6)
+/**
+ * 上传大块数据，使用扩展包头（XMNPkgHeaderExt），包体完整且校验正确时回复无包体的同名消息。
+*/
+#define CMD_LOGIC_UPLOAD (CMD_LOGIC_START + 7)
+/**
+ * 下载数据，包体为 4 字节的网络字节序的长度，长度为 0 或者超过 PkgMaxBodyLen 的请求被拒绝。
+ * server 以流式发送分多个同名的包回复，包体为空的包表示结束。
+*/
+#define CMD_LOGIC_DOWNLOAD (CMD_LOGIC_START + 8)
 
 struct RegisterInfo
 {
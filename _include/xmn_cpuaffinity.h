@@ -0,0 +1,145 @@
+/*****************************************************************************************
+ *
+ *  @function worker 进程的 CPU 绑定（thread-per-core 部署方式），由配置文件 [Proc] 中的选项决定。
+ *  @notice （1）事件循环（主事件循环和 reactor 线程）各自绑定在一个核上，减少跨核迁移和 cache 失效。
+ *          （2）业务逻辑线程和发送数据线程默认与本 worker 的事件循环位于同一个核及其超线程兄弟核上，
+ *          配置了 LogicCpuList 时则绑定在该列表中的核上，与事件循环的核隔离。
+ *          （3）worker 进程在创建线程之前先将自身绑定在业务逻辑的核上，之后创建的线程继承该设置，
+ *          事件循环的线程启动之后再将自己绑定在各自的核上。
+ *  @time   2020-04-24
+ *
+ *****************************************************************************************/
+#ifndef XMOON__INCLUDE_XMN_CPUAFFINITY_H_
+#define XMOON__INCLUDE_XMN_CPUAFFINITY_H_
+
+#include "base/noncopyable.h"
+#include "base/singletonbase.h"
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * CPU 绑定的方式。
+ * XMN_CPU_AFFINITY_NONE    不绑定。
+ * XMN_CPU_AFFINITY_WORKER  每个 worker 进程的所有事件循环绑定在同一个核上。
+ * XMN_CPU_AFFINITY_REACTOR 每个事件循环各自绑定在一个核上。
+*/
+#define XMN_CPU_AFFINITY_NONE 0
+#define XMN_CPU_AFFINITY_WORKER 1
+#define XMN_CPU_AFFINITY_REACTOR 2
+
+class XMNCpuAffinity : public NonCopyable
+{
+    friend class SingletonBase<XMNCpuAffinity>;
+
+private:
+    XMNCpuAffinity();
+    ~XMNCpuAffinity(){};
+
+public:
+    /**
+     * @function    读取配置文件中 CPU 绑定相关的选项。
+     * @paras   none 。
+     * @ret  0   操作成功。
+     *          -1  CpuAffinityMode 错误。
+     *          -2  IoCpuList 格式错误。
+     *          -3  LogicCpuList 格式错误。
+     * @time    2020-04-24
+    */
+    int ReadConf();
+
+    /**
+     * @function    是否开启了 CPU 绑定。
+     * @time    2020-04-24
+    */
+    bool IsEnabled() const { return mode_ != XMN_CPU_AFFINITY_NONE; }
+
+    /**
+     * @function    计算本 worker 进程中各个事件循环以及业务逻辑线程所使用的核。
+     * @paras   kWorkerIndex    worker 进程的编号。
+     *          kWorkerCount    worker 进程的数量。
+     *          kLoopCount  事件循环的数量，即：reactor 线程的数量 + 1 。
+     *          kIsCpuSteering  是否开启了 reuseport 的 CPU 分配策略，开启时 worker n 的事件循环必须位于 CPU n 上。
+     * @ret  none 。
+     * @time    2020-04-24
+    */
+    void Plan(const size_t &kWorkerIndex, const size_t &kWorkerCount, const size_t &kLoopCount, const bool &kIsCpuSteering);
+
+    /**
+     * @function    将调用线程绑定在业务逻辑线程和发送数据线程使用的核上，需要在创建这些线程之前调用。
+     * @paras   none 。
+     * @ret  0   操作成功。
+     *          -1  绑定失败。
+     * @time    2020-04-24
+    */
+    int BindLogicThreads();
+
+    /**
+     * @function    将调用线程绑定在编号为 kLoopIndex 的事件循环的核上。
+     * @paras   kLoopIndex  事件循环的编号，0 为主事件循环。
+     * @ret  0   操作成功。
+     *          -1  绑定失败。
+     * @time    2020-04-24
+    */
+    int BindEventLoop(const size_t &kLoopIndex);
+
+    /**
+     * @function    在日志中输出本 worker 进程的 CPU 分配情况。
+     * @paras   kWorkerIndex    worker 进程的编号。
+     * @ret  none 。
+     * @time    2020-04-24
+    */
+    void Report(const size_t &kWorkerIndex) const;
+
+private:
+    /**
+     * @function    解析 CPU 列表，格式为 "0-3,8,10" ，结果升序且不重复。
+     * @paras   kstrCpuList CPU 列表。
+     *          vcpus   存放解析结果。
+     * @ret  0   操作成功。
+     *          -1  格式错误或者 CPU 编号超出范围。
+     * @time    2020-04-24
+    */
+    static int ParseCpuList(const std::string &kstrCpuList, std::vector<int> &vcpus);
+
+    /**
+     * @function    将 kCpu 以及与其共享同一个物理核的超线程兄弟核加入 vcpus 中。
+     * @time    2020-04-24
+    */
+    static void AddSiblings(const int &kCpu, std::vector<int> &vcpus);
+
+    /**
+     * @function    将调用线程绑定在 vcpus 中的核上。
+     * @ret  0   操作成功。
+     * @time    2020-04-24
+    */
+    static int BindCurrentThread(const std::vector<int> &vcpus);
+
+    /**
+     * @function    将 CPU 列表转换为字符串，用于日志。
+     * @time    2020-04-24
+    */
+    static std::string CpuListToString(const std::vector<int> &vcpus);
+
+private:
+    /**
+     * 绑定的方式，取值为 XMN_CPU_AFFINITY_* 。
+    */
+    int mode_;
+
+    /**
+     * 配置文件中事件循环以及业务逻辑线程可以使用的核，为空时分别表示所有的核、与事件循环共用。
+    */
+    std::vector<int> viocpus_;
+    std::vector<int> vlogiccpus_;
+
+    /**
+     * Plan 的结果：各个事件循环所在的核，以及业务逻辑线程和发送数据线程所在的核。
+    */
+    std::vector<int> vloopcpu_;
+    std::vector<int> vlogicplan_;
+};
+
+#endif
@@ -33,6 +33,16 @@ public:
     */
     int GetCRC32(unsigned char *buffer, const size_t &kSize);
 
+    /**
+     * @function 在已有的 CRC 值 kCrc 的基础上继续计算后续数据的 CRC 值，用于分块到达的数据。
+     * @paras kCrc 之前的数据的 CRC 值，第一块数据传入 0 。
+     *        buffer 待转换的数据的首地址。
+     *        kSize 待转换的数据的字节数量。
+     * @ret 到目前为止所有数据的 CRC 值，与对全部数据调用 GetCRC32 的结果相同。
+     * @time 2020-04-27
+    */
+    unsigned int UpdateCRC32(const unsigned int &kCrc, unsigned char *buffer, const size_t &kSize);
+
 private:
     /**
      * @function 创建单字节的查表法所用到的表。
@@ -0,0 +1,109 @@
+/*****************************************************************************************
+ *
+ *  @function 基于 epoch 的内存回收（epoch-based reclamation），用于回收连接。
+ *  @notice （1）访问连接的线程（事件线程、业务逻辑线程、发送数据线程）在访问期间处于临界区中，
+ *          即：Enter 与 Leave 之间，临界区之外不能持有未经序号校验的连接指针。
+ *          （2）对象在 epoch 为 e 时被废弃，全局 epoch 推进到 e + 2 时，
+ *          所有在废弃之前进入临界区的线程都已经离开，对象可以被重新使用。
+ *          （3）每个线程第一次进入临界区时自动登记，最多支持 XMN_EPOCH_MAX_THREADS 个线程。
+ *  @time   2020-04-20
+ *
+ *****************************************************************************************/
+#ifndef XMOON__INCLUDE_XMN_EPOCH_H_
+#define XMOON__INCLUDE_XMN_EPOCH_H_
+
+#include "base/noncopyable.h"
+#include "base/singletonbase.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+
+/**
+ * 可以登记的线程的最大数量。
+*/
+#define XMN_EPOCH_MAX_THREADS 1024
+
+class XMNEpoch : public NonCopyable
+{
+    friend class SingletonBase<XMNEpoch>;
+
+private:
+    XMNEpoch();
+    ~XMNEpoch(){};
+
+public:
+    /**
+     * @function    进入、离开临界区，可以嵌套，最外层的 Leave 才真正离开。
+     * @paras   none 。
+     * @ret  none 。
+     * @time    2020-04-20
+    */
+    void Enter();
+    void Leave();
+
+    /**
+     * @function    当前的全局 epoch ，用于记录对象被废弃时的 epoch 。
+     * @time    2020-04-20
+    */
+    uint64_t CurrEpoch() const { return globalepoch_.load(); }
+
+    /**
+     * @function    所有处于临界区中的线程都已经看到了当前的全局 epoch 时，将其推进一步。
+     * @paras   none 。
+     * @ret  推进之后（或者无法推进时）的全局 epoch 。
+     * @time    2020-04-20
+    */
+    uint64_t TryAdvance();
+
+private:
+    /**
+     * @function    获取当前线程的槽的下标，第一次调用时登记。
+     * @paras   none 。
+     * @ret  >= 0    槽的下标。
+     *          -1  登记的线程过多，该线程不受保护。
+     * @time    2020-04-20
+    */
+    int GetSlot();
+
+private:
+    /**
+     * 每个线程的槽，各占一个 cache line ，防止伪共享。
+     * 0 表示不在临界区中，否则为进入临界区时看到的全局 epoch 。
+    */
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> epoch;
+    };
+    Slot slots_[XMN_EPOCH_MAX_THREADS];
+
+    /**
+     * 已经登记的线程的数量。
+    */
+    std::atomic<size_t> slotcount_;
+
+    /**
+     * 全局 epoch ，从 1 开始。
+    */
+    alignas(64) std::atomic<uint64_t> globalepoch_;
+};
+
+/**
+ * @function    自动进入、离开 epoch 临界区，用法与 XMNLockMutex 相同。
+ * @time    2020-04-20
+*/
+class XMNEpochGuard : public NonCopyable
+{
+public:
+    XMNEpochGuard()
+    {
+        SingletonBase<XMNEpoch>::GetInstance().Enter();
+    }
+    ~XMNEpochGuard()
+    {
+        SingletonBase<XMNEpoch>::GetInstance().Leave();
+    }
+};
+
+#endif
@@ -83,6 +83,11 @@ extern pid_t g_xmn_pid_parent;
 */
 extern int g_xmn_process_type;
 
+/**
+ * worker 进程的编号，master 进程中为 -1 。
+*/
+extern int g_xmn_worker_index;
+
 /**
  * 记录打开的日志文件的相关信息。
 */
@@ -0,0 +1,184 @@
+/*****************************************************************************************
+ *
+ *  @function 环形缓冲区，用作每个连接的接收缓冲区。
+ *  @notice （1）容量必须是 2 的幂，读写位置只增不减，通过掩码映射到缓冲区中。
+ *          （2）没有虚函数、构造函数和析构函数，可以随所在的对象一起被 memset 清零，
+ *          清零之后即为未分配内存的空缓冲区。
+ *          （3）本身不加锁，同一时刻只能有一个线程读写。
+ *          （4）缓冲区的内存来自 XMNRingBufferPool ，连接空闲时归还，下次收到数据时再取，
+ *          空闲连接不占用接收缓冲区。
+ *  @time   2020-04-14
+ *
+ *****************************************************************************************/
+#ifndef XMOON__INCLUDE_XMN_RINGBUFFER_H_
+#define XMOON__INCLUDE_XMN_RINGBUFFER_H_
+
+#include "base/noncopyable.h"
+#include "base/singletonbase.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+#include <atomic>
+
+/**
+ * 缓冲池中最多保留的空闲内存块的数量，超过的部分直接释放，避免突发流量之后长期占用内存。
+*/
+#define XMN_RING_BUFFER_POOL_MAX_FREE 256
+
+struct XMNRingBuffer
+{
+public:
+    /**
+     * @function    为缓冲区申请内存。
+     * @paras   kCapacity   缓冲区的字节数，必须是 2 的幂。
+     * @ret  0   操作成功。
+     *          -1  参数错误或者申请内存失败。
+     * @time    2020-04-14
+    */
+    int Create(const size_t &kCapacity);
+
+    /**
+     * @function    释放缓冲区的内存，缓冲区中尚未取走的数据一并丢弃。
+     * @paras   none 。
+     * @ret  none 。
+     * @time    2020-04-14
+    */
+    void Destroy();
+
+    /**
+     * @function    缓冲区是否已经申请了内存。
+     * @time    2020-04-14
+    */
+    bool IsCreated() const { return pbuff_ != nullptr; }
+
+    /**
+     * @function    缓冲区中尚未取走的数据的字节数。
+     * @time    2020-04-14
+    */
+    size_t Size() const { return tail_ - head_; }
+
+    /**
+     * @function    缓冲区中空闲空间的字节数。
+     * @time    2020-04-14
+    */
+    size_t FreeSize() const { return capacity_ - (tail_ - head_); }
+
+    /**
+     * @function    获取空闲空间，供 readv 等函数一次性写入数据。
+     * @paras   piov    存放空闲空间的数组，至少有 2 个元素。
+     * @ret  空闲空间被分为的段数，0 表示缓冲区已满。
+     * @time    2020-04-14
+    */
+    int WritableIov(struct iovec *piov) const;
+
+    /**
+     * @function    向 WritableIov 获取的空闲空间写入数据之后，将写位置后移。
+     * @paras   kLen    写入的字节数。
+     * @ret  none 。
+     * @time    2020-04-14
+    */
+    void Produce(const size_t &kLen);
+
+    /**
+     * @function    拷贝缓冲区头部的数据，但不取走。
+     * @paras   pdst    存放数据的内存。
+     *          kLen    拷贝的字节数，不能大于 Size() 。
+     * @ret  none 。
+     * @time    2020-04-14
+    */
+    void Peek(char *pdst, const size_t &kLen) const;
+
+    /**
+     * @function    丢弃缓冲区头部的数据。
+     * @paras   kLen    丢弃的字节数，不能大于 Size() 。
+     * @ret  none 。
+     * @time    2020-04-14
+    */
+    void Consume(const size_t &kLen);
+
+    /**
+     * @function    取走缓冲区头部的数据，即：Peek + Consume 。
+     * @paras   pdst    存放数据的内存。
+     *          kLen    取走的字节数，不能大于 Size() 。
+     * @ret  none 。
+     * @time    2020-04-14
+    */
+    void Read(char *pdst, const size_t &kLen);
+
+private:
+    /**
+     * 缓冲区的首地址。
+    */
+    char *pbuff_;
+
+    /**
+     * 缓冲区的字节数。
+    */
+    size_t capacity_;
+
+    /**
+     * 读位置和写位置，实际的下标为 & (capacity_ - 1) 。
+    */
+    size_t head_;
+    size_t tail_;
+};
+
+/**
+ * @function    接收缓冲区的内存池，所有连接共用同一种大小的内存块。
+ * @notice  大小与内存块不同的申请直接交给 XMNMemory 。
+ * @time    2020-04-21
+*/
+class XMNRingBufferPool : public NonCopyable
+{
+    friend class SingletonBase<XMNRingBufferPool>;
+
+private:
+    XMNRingBufferPool();
+    ~XMNRingBufferPool();
+
+public:
+    /**
+     * @function    设置内存块的大小，需要在申请内存之前调用。
+     * @paras   kBlockSize  内存块的字节数，即：连接的接收缓冲区的大小。
+     * @ret  none 。
+     * @time    2020-04-21
+    */
+    void Init(const size_t &kBlockSize);
+
+    /**
+     * @function    申请、归还内存块。
+     * @paras   kSize   内存块的字节数。
+     * @ret  Allocate 返回内存块的首地址，失败时返回 nullptr 。
+     * @time    2020-04-21
+    */
+    char *Allocate(const size_t &kSize);
+    void DeAllocate(char *pbuff, const size_t &kSize);
+
+    /**
+     * @function    内存块的大小、正在被连接使用的内存块的数量、池中空闲的内存块的数量。
+     * @time    2020-04-21
+    */
+    size_t BlockSize() const { return blocksize_; }
+    size_t UsedCount() const { return usedcount_; }
+    size_t FreeCount() const { return freecount_; }
+
+private:
+    /**
+     * 空闲的内存块中嵌入的指针。
+    */
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+private:
+    FreeBlock *pfreehead_;
+    size_t blocksize_;
+    std::atomic<size_t> usedcount_;
+    std::atomic<size_t> freecount_;
+    pthread_mutex_t mutex_;
+};
+
+#endif
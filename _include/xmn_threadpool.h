@@ -8,6 +8,8 @@
 #include <vector>
 #include <atomic>
 #include <queue>
+#include <deque>
+#include <unordered_map>
 #include <memory>
 
 class XMNThreadPool : public NonCopyable
@@ -60,6 +62,21 @@ private:
         pthread_cond_t *pcond_;
     };
 
+    /**
+     * 同一个连接的待处理消息的子队列，消息之间通过 XMNMsgHeader::pnext 链接。
+     * 子队列不为空时才存在，并且在轮转队列中。
+    */
+    struct DrrFlow
+    {
+        char *phead;
+        char *ptail;
+
+        /**
+         * 赤字轮询（DRR）中该连接剩余的可处理的开销。
+        */
+        size_t deficit;
+    };
+
 public:
     XMNThreadPool();
     ~XMNThreadPool();
@@ -68,10 +85,13 @@ public:
     /**
      * @function    创建线程池。
      * @paras   kThreadCount 线程池中线程的数量。
+     *          kDrrQuantum 赤字轮询中每个连接每一轮增加的开销，单位为字节。
      * @ret  0   操作成功。
+     *          -1  创建线程失败。
+     *          -2  kDrrQuantum 为 0 。
      * @time    2019-09-04
     */
-    int Create(const size_t &kThreadCount);
+    int Create(const size_t &kThreadCount, const size_t &kDrrQuantum);
 
     /**
      * @funtion 释放线程池中所有线程。
@@ -97,6 +117,15 @@ public:
     */
     int PutInRecvDataQueue_Signal(char *data);
 
+    /**
+     * @function    将一批接收到的数据压入消息队列中，只加一次锁，并按需唤醒线程。
+     * @paras   pdatas  接收到的数据的数组。
+     *          kCount  数据的个数。
+     * @ret  0   操作成功。
+     * @time    2020-04-14
+    */
+    int PutInRecvDataQueue_Signal(char **pdatas, const size_t &kCount);
+
     /**
      * @function    获取消息的数量
      * @paras   none 。
@@ -124,6 +153,22 @@ private:
     */
     char *PutOutRecvDataQueue();
 
+    /**
+     * @function    将消息放入其所属连接的子队列的尾部，子队列由空变为非空时加入轮转队列的尾部。
+     *              调用者需持有 recvdata_queue_mutex_ 。
+     * @paras   pdata   接收到的数据。
+     *          pflow   上一次放入的子队列，同一批消息一般属于同一个连接，可以省去查找；可以为 nullptr 。
+     * @ret  该消息所在的子队列。
+     * @time    2020-04-29
+    */
+    DrrFlow *PushDrrFlow(char *pdata, DrrFlow *pflow);
+
+    /**
+     * @function    处理一个消息的开销：包的长度，内部消息按一个大包的数据块计算。
+     * @time    2020-04-29
+    */
+    static size_t MsgCost(char *pdata);
+
 private:
     /**
      * 线程池中线程的数量。
@@ -171,9 +216,15 @@ private:
     pthread_mutex_t recvdata_queue_mutex_;
 
     /**
-     * 存放接收的数据的消息队列。
+     * 存放接收的数据的消息队列：每个连接一个子队列，按赤字轮询（DRR）在连接之间调度，
+     * 一个 client 大量地发送请求不会让其他连接的请求（例如心跳）长时间得不到处理。
+     * drrflows_    连接的句柄 -> 该连接的子队列。
+     * drractive_   轮转队列，其中是所有不为空的子队列，队首是正在被处理的子队列。
+     * drrquantum_  每个子队列每一轮增加的开销。
     */
-    std::queue<char *> recvdata_queue_;
+    std::unordered_map<uint64_t, DrrFlow> drrflows_;
+    std::deque<DrrFlow *> drractive_;
+    size_t drrquantum_;
 
     /**
      * 存放接收的数据的消息队列的大小。
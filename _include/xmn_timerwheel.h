@@ -0,0 +1,167 @@
+/*****************************************************************************************
+ *
+ *  @function 哈希时间轮定时器，由 timerfd 驱动，添加和取消定时器的时间复杂度均为 O(1) 。
+ *  @notice （1）时间轮有 kSlotCount 个槽，每个 tick 前进一个槽，超时时间超过一圈的定时器记录剩余的圈数。
+ *          （2）可以在任意线程中添加、取消定时器，到期的定时器在调用 ProcessExpired 的线程中执行，
+ *          即：worker 进程的事件线程，timerfd 和 socket 一起由事件后端监控。
+ *          （3）定时器只执行一次，需要周期执行时在回调函数中重新添加。
+ *          （4）没有定时器时 timerfd 停止计时，空闲的 worker 进程不会被定时唤醒。
+ *  @time   2020-04-19
+ *
+ *****************************************************************************************/
+#ifndef XMOON__INCLUDE_XMN_TIMERWHEEL_H_
+#define XMOON__INCLUDE_XMN_TIMERWHEEL_H_
+
+#include "base/noncopyable.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+class XMNTimerWheel : public NonCopyable
+{
+public:
+    /**
+     * 定时器到期时执行的函数。
+    */
+    typedef std::function<void()> TimerHandler;
+
+public:
+    XMNTimerWheel();
+    ~XMNTimerWheel();
+
+public:
+    /**
+     * @function    创建时间轮和 timerfd ，需要在 worker 进程中调用。
+     * @paras   kSlotCount  槽的数量。
+     *          kTickMs 每个槽代表的时间，单位 ms 。
+     * @ret  0   操作成功。
+     *          -1  参数错误或者 timerfd 创建失败。
+     * @time    2020-04-19
+    */
+    int Create(const size_t &kSlotCount, const uint32_t &kTickMs);
+
+    /**
+     * @function    关闭 timerfd ，丢弃所有尚未到期的定时器。
+     * @paras   none 。
+     * @ret  none 。
+     * @time    2020-04-19
+    */
+    void Destroy();
+
+    /**
+     * @function    timerfd ，可读时调用 ProcessExpired 。
+     * @time    2020-04-19
+    */
+    int GetFd() const { return timerfd_; }
+
+    /**
+     * @function    添加定时器。
+     * @paras   kDelayMs    多长时间之后执行，单位 ms ，按 tick 向上取整。
+     *          kHandler    到期时执行的函数。
+     * @ret  > 0 定时器的编号，用于取消定时器。
+     *          0   时间轮尚未创建。
+     * @time    2020-04-19
+    */
+    uint64_t AddTimer(const uint32_t &kDelayMs, const TimerHandler &kHandler);
+
+    /**
+     * @function    取消定时器。
+     * @paras   kTimerId    AddTimer 返回的定时器的编号。
+     * @ret  0   操作成功，回调函数不会再被执行。
+     *          -1  定时器不存在，已经执行、正在执行或者已经被取消。
+     * @time    2020-04-19
+    */
+    int CancelTimer(const uint64_t &kTimerId);
+
+    /**
+     * @function    读取 timerfd ，按照经过的 tick 数推进时间轮，执行所有到期的定时器。
+     * @paras   none 。
+     * @ret  执行的定时器的数量。
+     * @time    2020-04-19
+    */
+    size_t ProcessExpired();
+
+    /**
+     * @function    尚未到期的定时器的数量。
+     * @time    2020-04-19
+    */
+    size_t TimerCount() const { return timer_count_; }
+
+private:
+    /**
+     * 定时器，挂在所在槽的双向循环链表中。
+    */
+    struct TimerNode
+    {
+        TimerNode *pprev;
+        TimerNode *pnext;
+        uint64_t id;
+        size_t rounds;
+        TimerHandler handler;
+    };
+
+private:
+    /**
+     * @function    启动或者停止 timerfd 的周期计时。调用者需要持有 mutex_ 。
+     * @paras   isrunning   true 启动，false 停止。
+     * @ret  0   操作成功。
+     * @time    2020-04-19
+    */
+    int SetTimerFd(const bool &isrunning);
+
+    /**
+     * @function    将定时器挂入槽中或者从槽中摘下。调用者需要持有 mutex_ 。
+     * @time    2020-04-19
+    */
+    void LinkNode(TimerNode *pnode, const size_t &kSlot);
+    void UnlinkNode(TimerNode *pnode);
+
+private:
+    /**
+     * 各个槽的链表头，不存放定时器。
+    */
+    std::vector<TimerNode> vslots_;
+
+    /**
+     * 定时器的编号与定时器的对应关系，用于 O(1) 取消定时器。
+    */
+    std::unordered_map<uint64_t, TimerNode *> timers_;
+
+    /**
+     * 时间轮当前指向的槽。
+    */
+    size_t currslot_;
+
+    /**
+     * 每个槽代表的时间，单位 ms 。
+    */
+    uint32_t tickms_;
+
+    /**
+     * 驱动时间轮的 timerfd 。
+    */
+    int timerfd_;
+
+    /**
+     * 下一个定时器的编号，编号只增不减，不会重复使用。
+    */
+    uint64_t nexttimerid_;
+
+    /**
+     * 尚未到期的定时器的数量。
+    */
+    std::atomic<size_t> timer_count_;
+
+    /**
+     * 有关时间轮操作的互斥量。
+    */
+    pthread_mutex_t mutex_;
+};
+
+#endif
@@ -34,6 +34,7 @@ XMNThreadPool g_threadpool;
 pid_t g_xmn_pid = -1;
 pid_t g_xmn_pid_parent = -1;
 int g_xmn_process_type = XMN_PROCESS_MASTER;
+int g_xmn_worker_index = -1;
 
 sig_atomic_t g_xmn_reap = 0;
 bool g_isquit = false;
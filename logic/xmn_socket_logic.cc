@@ -8,6 +8,8 @@
 #include "netinet/in.h"
 #include <string.h>
 
+#include <algorithm>
+
 /**
  * TODO：此处为什么函数指针必须是 XMNSocketLogic 作用域下的。
  * 定义一个函数指针类型，该函数指针仅仅指向符合要求的 XMNSocketLogic 的成员函数。
@@ -20,16 +22,85 @@ using MsgHandler = int (XMNSocketLogic::*)(XMNMsgHeader *pmsgheader, char *ppkgb
 static const MsgHandler msghandlerall[] =
     {
         &XMNSocketLogic::HandlePing,     //【0】
-        nullptr,                         //【1】
+        &XMNSocketLogic::HandleUdpToken, //【1】
         nullptr,                         //【2】
         nullptr,                         //【3】
         nullptr,                         //【4】
         &XMNSocketLogic::HandleRegister, //【5】
         &XMNSocketLogic::HandleLogin,    //【6】
+        nullptr,                         //【7】
+        &XMNSocketLogic::HandleDownload, //【8】
 };
 
 #define TOTAL_COMMANDS (sizeof(msghandlerall) / sizeof(MsgHandler))
 
+/**
+ * 使用扩展包头的大包的处理函数，每次处理包体中的一块数据，按消息码索引。
+*/
+using StreamHandler = int (XMNSocketLogic::*)(XMNStreamChunk *pchunk);
+
+static const StreamHandler streamhandlerall[] =
+    {
+        nullptr,                      //【0】
+        nullptr,                      //【1】
+        nullptr,                      //【2】
+        nullptr,                      //【3】
+        nullptr,                      //【4】
+        nullptr,                      //【5】
+        nullptr,                      //【6】
+        &XMNSocketLogic::HandleUpload //【7】
+};
+
+#define TOTAL_STREAM_COMMANDS (sizeof(streamhandlerall) / sizeof(StreamHandler))
+
+/**
+ * 下载的流式发送，每次可写时发送若干块数据，直至达到高水位，只在内存中保存一块数据。
+ * 每块数据作为一个普通包发送，包头 + 包体不超过 PKG_MAX_LEN 。
+*/
+#define DOWNLOAD_CHUNK_LEN (PKG_MAX_LEN - sizeof(XMNPkgHeader))
+
+class DownloadWriter : public XMNStreamWriter
+{
+public:
+    explicit DownloadWriter(const uint32_t &kTotalLen) : kTotalLen_(kTotalLen), sentlen_(0) {}
+
+    virtual int OnWritable(XMNSocket *psocket, const XMNConnHandle &kConnHandle)
+    {
+        char data[DOWNLOAD_CHUNK_LEN];
+        int r = 0;
+        while (sentlen_ < kTotalLen_)
+        {
+            /**
+             * 业务逻辑在此生成下一块数据，这里用偏移填充。
+            */
+            const uint32_t kLen = std::min(kTotalLen_ - sentlen_, (uint32_t)DOWNLOAD_CHUNK_LEN);
+            for (uint32_t i = 0; i < kLen; ++i)
+            {
+                data[i] = (char)(sentlen_ + i);
+            }
+            r = psocket->StreamWrite(kConnHandle, CMD_LOGIC_DOWNLOAD, data, kLen);
+            if (r < 0)
+            {
+                return r;
+            }
+            sentlen_ += kLen;
+            if (r == 1)
+            {
+                return 0;
+            }
+        }
+
+        /**
+         * 包体为空的包表示结束。
+        */
+        return psocket->StreamWrite(kConnHandle, CMD_LOGIC_DOWNLOAD, nullptr, 0) < 0 ? -1 : 1;
+    }
+
+private:
+    const uint32_t kTotalLen_;
+    uint32_t sentlen_;
+};
+
 XMNSocketLogic::XMNSocketLogic()
 {
     ;
@@ -59,7 +130,11 @@ int XMNSocketLogic::HandleRegister(XMNMsgHeader *pmsgheader, char *ppkgbody, siz
     {
         return -2;
     }
-    XMNConnSockInfo *pconnsockinfo = pmsgheader->pconnsockinfo;
+    XMNConnSockInfo *pconnsockinfo = GetConnSockInfo(pmsgheader->connhandle);
+    if (pconnsockinfo == nullptr)
+    {
+        return -3;
+    }
     /*
      * （2）对该业务逻辑处理进行加锁。
      * 解释：对于同一个用户，可能同时发送来多个请求过来，造成多个线程同时为该用户服务。
@@ -68,8 +143,7 @@ int XMNSocketLogic::HandleRegister(XMNMsgHeader *pmsgheader, char *ppkgbody, siz
      * 很可能造成这个用户购买成功了 A，又购买成功了 B。
      * 所以根据上述考虑，同一个连接多个逻辑进行加锁处理。
     */
-    XMNLockMutex lockmutex_logic(&pconnsockinfo->logicprocmutex_);
-    pconnsockinfo->memmode = XMNConnSockInfo::REGISTERMODE;
+    XMNLockMutex lockmutex_logic(&pconnsockinfo->GetColdInfo()->logicprocmutex_);
     /**
      * （3）获取发送来的所有数据。
     */
@@ -96,6 +170,7 @@ int XMNSocketLogic::HandleRegister(XMNMsgHeader *pmsgheader, char *ppkgbody, siz
     // a、消息头。
     XMNMsgHeader *pmsgheader_send = (XMNMsgHeader *)psenddata;
     memcpy(pmsgheader_send, pmsgheader, sizeof(XMNMsgHeader));
+    pmsgheader_send->memmode = XMNConnSockInfo::REGISTERMODE;
     // b、包头
     XMNPkgHeader *ppkgheader_send = (XMNPkgHeader *)(psenddata + kMsgHeaderLen_);
     ppkgheader_send->pkglen = htons(kPkgHeaderLen_ + sizeof(RegisterInfo));
@@ -152,6 +227,15 @@ void XMNSocketLogic::ThreadRecvProcFunc(char *pmsgbuf)
     size_t pkglen = ntohs(ppkgheader->pkglen);
     size_t pkgbodylen = pkglen - kPkgHeaderLen_;
 
+    /**
+     * 网络层投递的内部消息，例如处理大包的包体块、继续流式发送。
+    */
+    if (pkglen == 0)
+    {
+        ThreadInnerProcFunc(pmsgbuf);
+        return;
+    }
+
     /**
      * （2）CRC32 校验。
     */
@@ -185,8 +269,8 @@ void XMNSocketLogic::ThreadRecvProcFunc(char *pmsgbuf)
      * 如果 client 发来了数据包，server 激活线程池中一个线程去处理，在这个过程中 client 与 server 断开了连接，
      * 那么该消息就不必处理。
     */
-    pconnsockinfo = pmsgheader->pconnsockinfo;
-    if (pconnsockinfo->currsequence != pmsgheader->currsequence)
+    pconnsockinfo = GetConnSockInfo(pmsgheader->connhandle);
+    if (pconnsockinfo == nullptr)
     {
         goto lblexit;
     }
@@ -228,21 +312,138 @@ int XMNSocketLogic::HandlePing(XMNMsgHeader *pmsgheader, char *ppkgbody, size_t
         return -2;
     }
 
-    XMNConnSockInfo *pconnsockinfo = pmsgheader->pconnsockinfo;
-    XMNLockMutex lockmutex_logic(&pconnsockinfo->logicprocmutex_);
-    pconnsockinfo->memmode = XMNConnSockInfo::PINGMODE;
+    XMNConnSockInfo *pconnsockinfo = GetConnSockInfo(pmsgheader->connhandle);
+    if (pconnsockinfo == nullptr)
+    {
+        return -3;
+    }
+    /**
+     * 心跳包只更新时间，不需要业务逻辑的互斥量，空闲连接也就不需要申请冷数据。
+    */
     pconnsockinfo->lastpingtime = time(nullptr);
 
     SendNoBodyData2Client(pmsgheader, CMD_LOGIC_PING);
     return 0;
 }
 
+int XMNSocketLogic::HandleUdpToken(XMNMsgHeader *pmsgheader, char *ppkgbody, size_t pkgbodylen)
+{
+    if (pmsgheader == nullptr)
+    {
+        return -1;
+    }
+    if (pkgbodylen != 0)
+    {
+        return -2;
+    }
+
+    XMNConnSockInfo *pconnsockinfo = GetConnSockInfo(pmsgheader->connhandle);
+    if (pconnsockinfo == nullptr)
+    {
+        return -3;
+    }
+
+    /**
+     * 没有开启 UDP 心跳时不回复，client 继续通过 TCP 发送心跳包。
+    */
+    XMNUdpToken udptoken;
+    if (IssueUdpToken(pconnsockinfo, &udptoken) != 0)
+    {
+        return -4;
+    }
+
+    XMNCRC32 &crc32 = SingletonBase<XMNCRC32>::GetInstance();
+    char *psenddata = (char *)SingletonBase<XMNMemPool<UdpTokenInfoAll>>::GetInstance().Allocate();
+    XMNMsgHeader *pmsgheader_send = (XMNMsgHeader *)psenddata;
+    memcpy(pmsgheader_send, pmsgheader, sizeof(XMNMsgHeader));
+    pmsgheader_send->memmode = XMNConnSockInfo::UDPTOKENMODE;
+    XMNPkgHeader *ppkgheader_send = (XMNPkgHeader *)(psenddata + kMsgHeaderLen_);
+    ppkgheader_send->pkglen = htons(kPkgHeaderLen_ + sizeof(XMNUdpToken));
+    ppkgheader_send->msgcode = htons(CMD_LOGIC_UDP_TOKEN);
+    char *ppkgbody_send = psenddata + kMsgHeaderLen_ + kPkgHeaderLen_;
+    memcpy(ppkgbody_send, &udptoken, sizeof(XMNUdpToken));
+    ppkgheader_send->crc32 = htonl(crc32.GetCRC32((unsigned char *)ppkgbody_send, sizeof(XMNUdpToken)));
+
+    PutInSendDataQueue(psenddata);
+    return 0;
+}
+
+void XMNSocketLogic::HandleStreamChunk(XMNStreamChunk *pchunk)
+{
+    if (pchunk->msgcode >= TOTAL_STREAM_COMMANDS || streamhandlerall[pchunk->msgcode] == nullptr)
+    {
+        /**
+         * 只在最后一块时输出日志，防止一个大包刷屏。
+        */
+        if (pchunk->islast)
+        {
+            XMNLogStdErr(0, "XMNSocketLogic::HandleStreamChunk()中的 msgcode = %d 消息码找不到对应的处理函数。", pchunk->msgcode);
+        }
+        return;
+    }
+    (this->*streamhandlerall[pchunk->msgcode])(pchunk);
+}
+
+int XMNSocketLogic::HandleDownload(XMNMsgHeader *pmsgheader, char *ppkgbody, size_t pkgbodylen)
+{
+    if ((ppkgbody == nullptr) || (pkgbodylen != sizeof(uint32_t)))
+    {
+        return -1;
+    }
+
+    /**
+     * 回复交给流式发送对象分批生成，不需要一次性在内存中组合。
+    */
+    uint32_t totallen = 0;
+    memcpy(&totallen, ppkgbody, sizeof(uint32_t));
+    totallen = ntohl(totallen);
+
+    /**
+     * 长度由 client 决定，与上传一样以 PkgMaxBodyLen 为上限，避免一个请求长时间占用发送线程和带宽。
+    */
+    if (totallen == 0 || totallen > pkgmaxbodylen_)
+    {
+        XMNLogStdErr(0, "XMNSocketLogic::HandleDownload 中请求的长度（%d）为 0 或者超过了上限，拒绝下载。", (int)totallen);
+        return -1;
+    }
+    return StartStreamWriter(pmsgheader->connhandle, new DownloadWriter(totallen));
+}
+
+int XMNSocketLogic::HandleUpload(XMNStreamChunk *pchunk)
+{
+    /**
+     * （1）各种业务处理，例如将 pchunk->data 写入 pchunk->offset 处。
+     * 在最后一块的校验结果出来之前，已经处理的数据都不可信。
+    */
+
+    /**
+     * ------------------------------------------------------------------
+    */
+
+    if (!pchunk->islast)
+    {
+        return 0;
+    }
+    if (!pchunk->iscrcok)
+    {
+        XMNLogStdErr(0, "XMNSocketLogic::HandleUpload 中 crc32 校验失败，丢弃数据。");
+        return -1;
+    }
+
+    /**
+     * （2）整个包体接收完毕，回复 client 。
+    */
+    SendNoBodyData2Client(&pchunk->msgheader, CMD_LOGIC_UPLOAD);
+    return 0;
+}
+
 void XMNSocketLogic::SendNoBodyData2Client(XMNMsgHeader *pmsgheader, const uint16_t &kMsgCode)
 {
     XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
     char *psenddata = (char *)SingletonBase<XMNMemPool<NoBodyInfoAll>>::GetInstance().Allocate();
 
     memcpy(psenddata, pmsgheader, sizeof(char) * kMsgHeaderLen_);
+    ((XMNMsgHeader *)psenddata)->memmode = XMNConnSockInfo::PINGMODE;
     XMNPkgHeader *ppkgheader = (XMNPkgHeader *)(psenddata + kMsgHeaderLen_);
 
     ppkgheader->pkglen = htons(kPkgHeaderLen_);
@@ -254,31 +455,22 @@ void XMNSocketLogic::SendNoBodyData2Client(XMNMsgHeader *pmsgheader, const uint1
     return;
 }
 
-int XMNSocketLogic::PingTimeOutChecking(XMNMsgHeader *pmsgheader, time_t currenttime)
+int XMNSocketLogic::PingTimeOutChecking(XMNConnSockInfo *pconnsockinfo, const XMNConnHandle &kConnHandle, const time_t &kCurrentTime)
 {
-    if (pmsgheader == nullptr)
+    if (pconnsockinfo == nullptr)
     {
         return -1;
     }
-    XMNConnSockInfo *pconnsockinfo = pmsgheader->pconnsockinfo;
-    if (pmsgheader->currsequence == pconnsockinfo->currsequence)
+    if (kConnHandle == pconnsockinfo->Handle())
     {
         /**
          * 此连接没有断开。
         */
-        if ((currenttime - pconnsockinfo->lastpingtime) > (pingwaittime_ * 3))
+        if ((kCurrentTime - pconnsockinfo->lastpingtime) > (pingwaittime_ * 3))
         {
             XMNLogStdErr(0, "超时不发心跳包，连接被关闭。");
             ActivelyCloseSocket(pconnsockinfo);
         }
-        SingletonBase<XMNMemPool<XMNMsgHeader>>::GetInstance().DeAllocate(pmsgheader);
-    }
-    else
-    {
-        /**
-         * 此连接已经断开。
-        */
-        SingletonBase<XMNMemPool<XMNMsgHeader>>::GetInstance().DeAllocate(pmsgheader);
     }
     return 0;
 }
\ No newline at end of file
@@ -64,3 +64,19 @@ int XMNCRC32::GetCRC32(unsigned char *buffer, const size_t &kSize)
 	}
 	return crc ^ 0xffffffff;
 }
+
+unsigned int XMNCRC32::UpdateCRC32(const unsigned int &kCrc, unsigned char *buffer, const size_t &kSize)
+{
+	if ((buffer == nullptr) || (kSize == 0))
+	{
+		return kCrc;
+	}
+
+	unsigned int crc(kCrc ^ 0xffffffff);
+	size_t len = kSize;
+	while (len--)
+	{
+		crc = (crc >> 8) ^ crc32_table[(crc & 0xFF) ^ *buffer++];
+	}
+	return crc ^ 0xffffffff;
+}
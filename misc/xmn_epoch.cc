@@ -0,0 +1,89 @@
+#include "xmn_epoch.h"
+#include "xmn_func.h"
+
+/**
+ * 当前线程的槽的下标以及临界区的嵌套深度。
+*/
+static thread_local int g_epochslot = -2;
+static thread_local int g_epochdepth = 0;
+
+XMNEpoch::XMNEpoch()
+{
+    for (auto &x : slots_)
+    {
+        x.epoch = 0;
+    }
+    slotcount_ = 0;
+    globalepoch_ = 1;
+}
+
+int XMNEpoch::GetSlot()
+{
+    if (g_epochslot == -2)
+    {
+        size_t slot = slotcount_++;
+        /**
+         * XMNSocket::ReadConf 保证配置的线程数量不超过上限，这里只防止越界。
+        */
+        if (slot >= XMN_EPOCH_MAX_THREADS)
+        {
+            XMNLogStdErr(0, "XMNEpoch::GetSlot 中登记的线程超过了 %d 个。", XMN_EPOCH_MAX_THREADS);
+            slotcount_ = XMN_EPOCH_MAX_THREADS;
+            g_epochslot = -1;
+        }
+        else
+        {
+            g_epochslot = (int)slot;
+        }
+    }
+    return g_epochslot;
+}
+
+void XMNEpoch::Enter()
+{
+    if (g_epochdepth++ > 0)
+    {
+        return;
+    }
+    int slot = GetSlot();
+    if (slot >= 0)
+    {
+        /**
+         * 读取与写入之间全局 epoch 可能被推进了，需要重新写入，直至写入的是最新的值。
+        */
+        uint64_t epoch = 0;
+        do
+        {
+            epoch = globalepoch_.load();
+            slots_[slot].epoch.store(epoch);
+        } while (epoch != globalepoch_.load());
+    }
+}
+
+void XMNEpoch::Leave()
+{
+    if (--g_epochdepth > 0)
+    {
+        return;
+    }
+    if (g_epochslot >= 0)
+    {
+        slots_[g_epochslot].epoch.store(0);
+    }
+}
+
+uint64_t XMNEpoch::TryAdvance()
+{
+    uint64_t curr = globalepoch_.load();
+    const size_t kSlotCount = slotcount_;
+    for (size_t i = 0; i < kSlotCount; ++i)
+    {
+        uint64_t epoch = slots_[i].epoch.load();
+        if (epoch != 0 && epoch != curr)
+        {
+            return curr;
+        }
+    }
+    globalepoch_.compare_exchange_strong(curr, curr + 1);
+    return globalepoch_.load();
+}
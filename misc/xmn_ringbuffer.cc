@@ -0,0 +1,176 @@
+#include "xmn_ringbuffer.h"
+#include "xmn_memory.h"
+#include "xmn_lockmutex.hpp"
+
+#include <string.h>
+
+int XMNRingBuffer::Create(const size_t &kCapacity)
+{
+    if (kCapacity == 0 || (kCapacity & (kCapacity - 1)) != 0)
+    {
+        return -1;
+    }
+
+    pbuff_ = SingletonBase<XMNRingBufferPool>::GetInstance().Allocate(kCapacity);
+    if (pbuff_ == nullptr)
+    {
+        return -1;
+    }
+    capacity_ = kCapacity;
+    head_ = 0;
+    tail_ = 0;
+    return 0;
+}
+
+void XMNRingBuffer::Destroy()
+{
+    if (pbuff_ != nullptr)
+    {
+        SingletonBase<XMNRingBufferPool>::GetInstance().DeAllocate(pbuff_, capacity_);
+        pbuff_ = nullptr;
+    }
+    capacity_ = 0;
+    head_ = 0;
+    tail_ = 0;
+}
+
+int XMNRingBuffer::WritableIov(struct iovec *piov) const
+{
+    const size_t kFreeSize = FreeSize();
+    if (kFreeSize == 0)
+    {
+        return 0;
+    }
+
+    /**
+     * 空闲空间从写位置开始，若越过了缓冲区的末尾，则回绕到缓冲区的开头。
+    */
+    const size_t kTailIndex = tail_ & (capacity_ - 1);
+    const size_t kFirstLen = capacity_ - kTailIndex;
+    piov[0].iov_base = pbuff_ + kTailIndex;
+    if (kFreeSize <= kFirstLen)
+    {
+        piov[0].iov_len = kFreeSize;
+        return 1;
+    }
+    piov[0].iov_len = kFirstLen;
+    piov[1].iov_base = pbuff_;
+    piov[1].iov_len = kFreeSize - kFirstLen;
+    return 2;
+}
+
+void XMNRingBuffer::Produce(const size_t &kLen)
+{
+    tail_ += kLen;
+}
+
+void XMNRingBuffer::Peek(char *pdst, const size_t &kLen) const
+{
+    const size_t kHeadIndex = head_ & (capacity_ - 1);
+    const size_t kFirstLen = capacity_ - kHeadIndex;
+    if (kLen <= kFirstLen)
+    {
+        memcpy(pdst, pbuff_ + kHeadIndex, kLen);
+        return;
+    }
+    memcpy(pdst, pbuff_ + kHeadIndex, kFirstLen);
+    memcpy(pdst + kFirstLen, pbuff_, kLen - kFirstLen);
+}
+
+void XMNRingBuffer::Consume(const size_t &kLen)
+{
+    head_ += kLen;
+    /**
+     * 缓冲区空了之后回到开头，使得下次接收的数据尽量连续存放，不必分两段拷贝。
+    */
+    if (head_ == tail_)
+    {
+        head_ = 0;
+        tail_ = 0;
+    }
+}
+
+void XMNRingBuffer::Read(char *pdst, const size_t &kLen)
+{
+    Peek(pdst, kLen);
+    Consume(kLen);
+}
+
+XMNRingBufferPool::XMNRingBufferPool()
+{
+    pfreehead_ = nullptr;
+    blocksize_ = 0;
+    usedcount_ = 0;
+    freecount_ = 0;
+    pthread_mutex_init(&mutex_, nullptr);
+}
+
+XMNRingBufferPool::~XMNRingBufferPool()
+{
+    XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
+    while (pfreehead_ != nullptr)
+    {
+        FreeBlock *pblock = pfreehead_;
+        pfreehead_ = pblock->next;
+        memory.FreeMemory(pblock);
+    }
+    pthread_mutex_destroy(&mutex_);
+}
+
+void XMNRingBufferPool::Init(const size_t &kBlockSize)
+{
+    XMNLockMutex lock(&mutex_);
+    blocksize_ = kBlockSize;
+}
+
+char *XMNRingBufferPool::Allocate(const size_t &kSize)
+{
+    XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
+    if (kSize != blocksize_)
+    {
+        return (char *)memory.AllocMemory(kSize, false);
+    }
+
+    ++usedcount_;
+    {
+        XMNLockMutex lock(&mutex_);
+        if (pfreehead_ != nullptr)
+        {
+            FreeBlock *pblock = pfreehead_;
+            pfreehead_ = pblock->next;
+            --freecount_;
+            return (char *)pblock;
+        }
+    }
+
+    char *pbuff = (char *)memory.AllocMemory(kSize, false);
+    if (pbuff == nullptr)
+    {
+        --usedcount_;
+    }
+    return pbuff;
+}
+
+void XMNRingBufferPool::DeAllocate(char *pbuff, const size_t &kSize)
+{
+    XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
+    if (kSize != blocksize_)
+    {
+        memory.FreeMemory(pbuff);
+        return;
+    }
+
+    --usedcount_;
+    {
+        XMNLockMutex lock(&mutex_);
+        if (freecount_ < XMN_RING_BUFFER_POOL_MAX_FREE)
+        {
+            FreeBlock *pblock = (FreeBlock *)pbuff;
+            pblock->next = pfreehead_;
+            pfreehead_ = pblock;
+            ++freecount_;
+            return;
+        }
+    }
+    memory.FreeMemory(pbuff);
+}
@@ -3,9 +3,11 @@
 #include "xmn_global.h"
 #include "xmn_memory.h"
 #include "xmn_lockmutex.hpp"
+#include "xmn_epoch.h"
 
 #include <errno.h>
 #include <unistd.h>
+#include <arpa/inet.h>
 
 XMNThreadPool::XMNThreadPool()
 {
@@ -13,6 +15,7 @@ XMNThreadPool::XMNThreadPool()
     threadrunningcount_ = 0;
     allthreadswork_lasttime_ = 0;
     queue_recvdata_count_ = 0;
+    drrquantum_ = 4096;
 
     thread_mutex_ = PTHREAD_MUTEX_INITIALIZER;
     recvdata_queue_mutex_ = PTHREAD_MUTEX_INITIALIZER;
@@ -45,13 +48,19 @@ XMNThreadPool::~XMNThreadPool()
     //     recvdata_queue_.pop();
     //     delete ptmp;
     // }
-    std::queue<char *>().swap(recvdata_queue_);
+    drractive_.clear();
+    drrflows_.clear();
 }
 
-int XMNThreadPool::Create(const size_t &kThreadCount)
+int XMNThreadPool::Create(const size_t &kThreadCount, const size_t &kDrrQuantum)
 {
     int r = 0;
+    if (kDrrQuantum == 0)
+    {
+        return -2;
+    }
     threadpoolsize_ = kThreadCount;
+    drrquantum_ = kDrrQuantum;
 
     /**
      * （1）创建指定数量的线程。
@@ -162,9 +171,15 @@ void *XMNThreadPool::ThreadFunc(void *pthreaddata)
         ++pthreadpool->threadrunningcount_;
 
         /**
-         * 开始业务处理。
+         * 开始业务处理，处理期间处于 epoch 临界区中，消息所属的连接不会被归还至连接池。
+         * 消息在业务处理中被释放，先记下其所属的连接，处理完之后减少该连接尚未处理完的消息的数量。
         */
-        g_socket.ThreadRecvProcFunc(pmsg);
+        {
+            XMNEpochGuard epochguard;
+            const XMNConnHandle kConnHandle = ((XMNMsgHeader *)pmsg)->connhandle;
+            g_socket.ThreadRecvProcFunc(pmsg);
+            g_socket.RecvMsgDone(kConnHandle);
+        }
 
         /**
          * 业务处理结束。
@@ -231,26 +246,30 @@ int XMNThreadPool::Destroy()
 int XMNThreadPool::Call()
 {
     /**
-     * 按照线程等待队列中的顺序依次调用线程。
-     * 若无线程可掉，则休息 10us ，再次调用尝试。
+     * （1）按照线程等待队列中的顺序唤醒一个空闲的线程。
+     * 线程在持有 thread_mutex_ 时检查消息队列并将条件变量放入等待队列，pthread_cond_wait 才释放该锁，
+     * 所以持有该锁之后再检查等待队列：
+     * a、等待队列中的线程都已经在等待，唤醒不会丢失；
+     * b、等待队列为空时，所有的线程都在处理消息，处理完之后会再次检查消息队列，刚放入的消息不会被遗漏，
+     * 此时直接返回，不必等待空闲的线程，事件循环不会因为业务逻辑繁忙而停顿。
     */
     pthread_cond_t *pcond = nullptr;
-    while (true)
+    int r = 0;
     {
-        pthread_mutex_lock(&queue_thread_cond_mutex);
-        pcond = queue_thread_cond_.front();
-        if (!pcond)
+        XMNLockMutex lockmutex_thread(&thread_mutex_);
         {
-            pthread_mutex_unlock(&queue_thread_cond_mutex);
-            usleep(10);
-            continue;
+            XMNLockMutex lockmutex_cond(&queue_thread_cond_mutex);
+            if (!queue_thread_cond_.empty())
+            {
+                pcond = queue_thread_cond_.front();
+                queue_thread_cond_.pop();
+            }
+        }
+        if (pcond != nullptr)
+        {
+            r = pthread_cond_signal(pcond);
         }
-        queue_thread_cond_.pop();
-        pthread_mutex_unlock(&queue_thread_cond_mutex);
-        break;
     }
-
-    int r = pthread_cond_signal(pcond);
     if (r != 0)
     {
         XMNLogStdErr(r, "XMNThreadPool::Call 中 pthread_cond_signal 执行失败。");
@@ -284,7 +303,7 @@ int XMNThreadPool::PutInRecvDataQueue_Signal(char *data)
         XMNLogStdErr(r, "XMNThreadPool::PutInRecvDataQueue_Signal 中的 pthread_mutex_lock 执行失败。");
     }
 
-    recvdata_queue_.push(data);
+    PushDrrFlow(data, nullptr);
     queue_recvdata_count_++;
 
     r = pthread_mutex_unlock(&recvdata_queue_mutex_);
@@ -299,18 +318,126 @@ int XMNThreadPool::PutInRecvDataQueue_Signal(char *data)
     return 0;
 }
 
+int XMNThreadPool::PutInRecvDataQueue_Signal(char **pdatas, const size_t &kCount)
+{
+    int r = 0;
+    /**
+     * （1）向消息队列中压入 client 发来的一批数据。
+    */
+    r = pthread_mutex_lock(&recvdata_queue_mutex_);
+    if (r != 0)
+    {
+        XMNLogStdErr(r, "XMNThreadPool::PutInRecvDataQueue_Signal 中的 pthread_mutex_lock 执行失败。");
+    }
+
+    DrrFlow *pflow = nullptr;
+    for (size_t i = 0; i < kCount; ++i)
+    {
+        pflow = PushDrrFlow(pdatas[i], pflow);
+    }
+    queue_recvdata_count_ += kCount;
+
+    r = pthread_mutex_unlock(&recvdata_queue_mutex_);
+    if (r != 0)
+    {
+        XMNLogStdErr(r, "XMNThreadPool::PutInRecvDataQueue_Signal 中的 pthread_mutex_unlock 执行失败。");
+    }
+
+    /**
+     * （2）唤醒线程取走消息，线程处理完一个消息之后会继续从消息队列中取，
+     * 所以最多唤醒空闲的线程数量个线程，但至少唤醒一个。
+    */
+    size_t callcount = 0;
+    {
+        XMNLockMutex lockmutex_cond(&queue_thread_cond_mutex);
+        callcount = queue_thread_cond_.size();
+    }
+    if (callcount > kCount)
+    {
+        callcount = kCount;
+    }
+    if (callcount == 0)
+    {
+        callcount = 1;
+    }
+    for (size_t i = 0; i < callcount; ++i)
+    {
+        Call();
+    }
+    return 0;
+}
+
 char *XMNThreadPool::PutOutRecvDataQueue()
 {
     XMNLockMutex lockmutex_recvdata(&recvdata_queue_mutex_);
-    char *pbuf = nullptr;
-    if (queue_recvdata_count_ > 0)
+    while (!drractive_.empty())
     {
-        pbuf = recvdata_queue_.front();
-        recvdata_queue_.pop();
+        /**
+         * （1）队首的子队列的赤字不足以处理其队首的消息时，增加一轮的开销并移到轮转队列的尾部。
+         * 每一轮每个连接最多处理 drrquantum_ 字节的消息，其余的留到下一轮。
+        */
+        DrrFlow *pflow = drractive_.front();
+        char *pbuf = pflow->phead;
+        const size_t kCost = MsgCost(pbuf);
+        if (pflow->deficit < kCost)
+        {
+            pflow->deficit += drrquantum_;
+            drractive_.pop_front();
+            drractive_.push_back(pflow);
+            continue;
+        }
+
+        /**
+         * （2）取出消息，子队列取空时将其删除，该连接之后的消息重新从 0 开始累积赤字。
+        */
+        pflow->deficit -= kCost;
+        pflow->phead = ((XMNMsgHeader *)pbuf)->pnext;
+        if (pflow->phead == nullptr)
+        {
+            drractive_.pop_front();
+            drrflows_.erase(((XMNMsgHeader *)pbuf)->connhandle);
+        }
         queue_recvdata_count_--;
+        return pbuf;
     }
 
-    return pbuf;
+    return nullptr;
+}
+
+XMNThreadPool::DrrFlow *XMNThreadPool::PushDrrFlow(char *pdata, DrrFlow *pflow)
+{
+    XMNMsgHeader *pmsgheader = (XMNMsgHeader *)pdata;
+    pmsgheader->pnext = nullptr;
+
+    /**
+     * 同一批消息属于同一个连接时，直接使用上一次的子队列。
+     * 子队列只在取空时删除，这期间不会有其他线程取消息，所以上一次的子队列仍然存在。
+    */
+    if (pflow == nullptr || ((XMNMsgHeader *)pflow->phead)->connhandle != pmsgheader->connhandle)
+    {
+        pflow = &drrflows_[pmsgheader->connhandle];
+    }
+    if (pflow->phead == nullptr)
+    {
+        pflow->phead = pdata;
+        pflow->deficit = 0;
+        drractive_.push_back(pflow);
+    }
+    else
+    {
+        ((XMNMsgHeader *)pflow->ptail)->pnext = pdata;
+    }
+    pflow->ptail = pdata;
+    return pflow;
+}
+
+size_t XMNThreadPool::MsgCost(char *pdata)
+{
+    /**
+     * 内部消息（pkglen 为 0 ）驱动大包的数据块的处理或者流式发送，至少按一个数据块计算。
+    */
+    const size_t kPkgLen = ntohs(((XMNPkgHeader *)(pdata + sizeof(XMNMsgHeader)))->pkglen);
+    return kPkgLen == 0 ? XMN_STREAM_CHUNK_SIZE : kPkgLen;
 }
 
 size_t XMNThreadPool::RecvDataQueueSize()
@@ -0,0 +1,208 @@
+#include "xmn_timerwheel.h"
+#include "xmn_func.h"
+#include "xmn_lockmutex.hpp"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+XMNTimerWheel::XMNTimerWheel()
+{
+    currslot_ = 0;
+    tickms_ = 0;
+    timerfd_ = -1;
+    nexttimerid_ = 1;
+    timer_count_ = 0;
+    pthread_mutex_init(&mutex_, nullptr);
+}
+
+XMNTimerWheel::~XMNTimerWheel()
+{
+    Destroy();
+    pthread_mutex_destroy(&mutex_);
+}
+
+int XMNTimerWheel::Create(const size_t &kSlotCount, const uint32_t &kTickMs)
+{
+    if (kSlotCount == 0 || kTickMs == 0)
+    {
+        return -1;
+    }
+
+    timerfd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerfd_ == -1)
+    {
+        XMNLogStdErr(errno, "XMNTimerWheel::Create 中 timerfd_create 执行失败。");
+        return -1;
+    }
+
+    XMNLockMutex lock(&mutex_);
+    vslots_.resize(kSlotCount);
+    for (auto &x : vslots_)
+    {
+        x.pprev = &x;
+        x.pnext = &x;
+    }
+    currslot_ = 0;
+    tickms_ = kTickMs;
+    return 0;
+}
+
+void XMNTimerWheel::Destroy()
+{
+    XMNLockMutex lock(&mutex_);
+    for (auto &x : timers_)
+    {
+        delete x.second;
+    }
+    timers_.clear();
+    timer_count_ = 0;
+    std::vector<TimerNode>().swap(vslots_);
+    if (timerfd_ != -1)
+    {
+        close(timerfd_);
+        timerfd_ = -1;
+    }
+}
+
+uint64_t XMNTimerWheel::AddTimer(const uint32_t &kDelayMs, const TimerHandler &kHandler)
+{
+    XMNLockMutex lock(&mutex_);
+    if (timerfd_ == -1)
+    {
+        return 0;
+    }
+
+    /**
+     * （1）计算定时器所在的槽以及需要等待的圈数，至少等待一个 tick 。
+    */
+    size_t ticks = (kDelayMs + tickms_ - 1) / tickms_;
+    if (ticks == 0)
+    {
+        ticks = 1;
+    }
+    TimerNode *pnode = new TimerNode;
+    pnode->id = nexttimerid_++;
+    pnode->rounds = (ticks - 1) / vslots_.size();
+    pnode->handler = kHandler;
+    LinkNode(pnode, (currslot_ + ticks) % vslots_.size());
+    timers_[pnode->id] = pnode;
+
+    /**
+     * （2）由空变为非空时启动 timerfd 。
+    */
+    if (timer_count_++ == 0)
+    {
+        SetTimerFd(true);
+    }
+    return pnode->id;
+}
+
+int XMNTimerWheel::CancelTimer(const uint64_t &kTimerId)
+{
+    XMNLockMutex lock(&mutex_);
+    auto it = timers_.find(kTimerId);
+    if (it == timers_.end())
+    {
+        return -1;
+    }
+    TimerNode *pnode = it->second;
+    timers_.erase(it);
+    UnlinkNode(pnode);
+    --timer_count_;
+    delete pnode;
+    return 0;
+}
+
+size_t XMNTimerWheel::ProcessExpired()
+{
+    /**
+     * （1）取出 timerfd 记录的到期次数，即：经过的 tick 数。
+    */
+    uint64_t ticks = 0;
+    if (read(timerfd_, &ticks, sizeof(ticks)) != sizeof(ticks))
+    {
+        return 0;
+    }
+
+    /**
+     * （2）推进时间轮，将到期的定时器摘下。
+     * 回调函数在锁外执行，回调函数中可以再添加、取消定时器。
+    */
+    std::vector<TimerNode *> vexpired;
+    {
+        XMNLockMutex lock(&mutex_);
+        for (uint64_t i = 0; i < ticks && timer_count_ > vexpired.size(); ++i)
+        {
+            currslot_ = (currslot_ + 1) % vslots_.size();
+            TimerNode *phead = &vslots_[currslot_];
+            TimerNode *pnode = phead->pnext;
+            while (pnode != phead)
+            {
+                TimerNode *pnext = pnode->pnext;
+                if (pnode->rounds == 0)
+                {
+                    UnlinkNode(pnode);
+                    timers_.erase(pnode->id);
+                    vexpired.push_back(pnode);
+                }
+                else
+                {
+                    --pnode->rounds;
+                }
+                pnode = pnext;
+            }
+        }
+        timer_count_ -= vexpired.size();
+        if (timer_count_ == 0)
+        {
+            SetTimerFd(false);
+        }
+    }
+
+    /**
+     * （3）执行到期的定时器。
+    */
+    for (const auto &x : vexpired)
+    {
+        x->handler();
+        delete x;
+    }
+    return vexpired.size();
+}
+
+int XMNTimerWheel::SetTimerFd(const bool &isrunning)
+{
+    struct itimerspec its;
+    memset(&its, 0, sizeof(struct itimerspec));
+    if (isrunning)
+    {
+        its.it_interval.tv_sec = tickms_ / 1000;
+        its.it_interval.tv_nsec = (long)(tickms_ % 1000) * 1000000;
+        its.it_value = its.it_interval;
+    }
+    if (timerfd_settime(timerfd_, 0, &its, nullptr) != 0)
+    {
+        XMNLogStdErr(errno, "XMNTimerWheel::SetTimerFd 中 timerfd_settime 执行失败。");
+        return -1;
+    }
+    return 0;
+}
+
+void XMNTimerWheel::LinkNode(TimerNode *pnode, const size_t &kSlot)
+{
+    TimerNode *phead = &vslots_[kSlot];
+    pnode->pprev = phead->pprev;
+    pnode->pnext = phead;
+    phead->pprev->pnext = pnode;
+    phead->pprev = pnode;
+}
+
+void XMNTimerWheel::UnlinkNode(TimerNode *pnode)
+{
+    pnode->pprev->pnext = pnode->pnext;
+    pnode->pnext->pprev = pnode->pprev;
+    pnode->pprev = nullptr;
+    pnode->pnext = nullptr;
+}
@@ -0,0 +1,97 @@
+#include "comm/xmn_event_backend.h"
+#include "comm/xmn_socket.h"
+#include "xmn_func.h"
+#include "xmn_macro.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+XMNEpollBackend::XMNEpollBackend(const int &kMaxConnections) : maxconnections_(kMaxConnections)
+{
+    epoll_handle_ = -1;
+}
+
+XMNEpollBackend::~XMNEpollBackend()
+{
+    if (epoll_handle_ != -1)
+    {
+        close(epoll_handle_);
+        epoll_handle_ = -1;
+    }
+}
+
+int XMNEpollBackend::Init()
+{
+    epoll_handle_ = epoll_create(maxconnections_);
+    if (epoll_handle_ <= 0)
+    {
+        XMNLogStdErr(errno, "XMNEpollBackend::Init 中的 epoll_create()执行失败！");
+        return -1;
+    }
+    return 0;
+}
+
+int XMNEpollBackend::Ctl(const int &kSockFd,
+                         const uint32_t &kOption,
+                         const uint32_t &kEvents,
+                         XMNConnSockInfo *pconnsockinfo)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(struct epoll_event));
+    ev.events = kEvents;
+    ev.data.u64 = pconnsockinfo->Handle();
+    if (epoll_ctl(epoll_handle_, kOption, kSockFd, &ev) != 0)
+    {
+        XMNLogStdErr(errno, "XMNEpollBackend::Ctl 中 epoll_ctl 执行失败。");
+        return -1;
+    }
+    return 0;
+}
+
+int XMNEpollBackend::AddReadableFd(const int &kFd, XMNConnSockInfo *pconnsockinfo)
+{
+    return Ctl(kFd, EPOLL_CTL_ADD, EPOLLIN, pconnsockinfo);
+}
+
+int XMNEpollBackend::Wait(struct epoll_event *pevents, const int &kMaxEvents, const int &kTimer)
+{
+    return epoll_wait(epoll_handle_, pevents, kMaxEvents, kTimer);
+}
+
+int XMNEpollBackend::Accept(XMNConnSockInfo *plistenconnsockinfo,
+                            struct sockaddr *paddr,
+                            socklen_t *paddrlen,
+                            const int &kFlags)
+{
+    if (kFlags != 0)
+    {
+        return accept4(plistenconnsockinfo->fd, paddr, paddrlen, kFlags);
+    }
+    return accept(plistenconnsockinfo->fd, paddr, paddrlen);
+}
+
+ssize_t XMNEpollBackend::Recv(XMNConnSockInfo *pconnsockinfo, const struct iovec *piov, const int &kIovCnt)
+{
+    return readv(pconnsockinfo->fd, piov, kIovCnt);
+}
+
+ssize_t XMNEpollBackend::Send(XMNConnSockInfo *pconnsockinfo, const struct iovec *piov, const int &kIovCnt, const int &kFlags)
+{
+    /**
+     * 用 sendmsg 代替 writev ，以便通过 MSG_NOSIGNAL 避免对端关闭时产生 SIGPIPE 。
+    */
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(struct msghdr));
+    msg.msg_iov = (struct iovec *)piov;
+    msg.msg_iovlen = kIovCnt;
+    return sendmsg(pconnsockinfo->fd, &msg, MSG_NOSIGNAL | kFlags);
+}
+
+int XMNEpollBackend::Close(XMNConnSockInfo *pconnsockinfo)
+{
+    /**
+     * close 之后 socket 会自动从 epoll 中删除。
+    */
+    return close(pconnsockinfo->fd);
+}
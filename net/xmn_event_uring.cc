@@ -0,0 +1,782 @@
+#include "comm/xmn_event_backend.h"
+#include "comm/xmn_socket.h"
+#include "xmn_func.h"
+#include "xmn_macro.h"
+#include "xmn_lockmutex.hpp"
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * glibc 没有提供 io_uring 的封装函数，直接使用系统调用。
+*/
+static inline int XMNIoUringSetup(unsigned entries, struct io_uring_params *pparams)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, pparams);
+}
+
+static inline int XMNIoUringEnter(int fd, unsigned tosubmit, unsigned mincomplete, unsigned flags, void *parg, size_t argsize)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, tosubmit, mincomplete, flags, parg, argsize);
+}
+
+static inline int XMNIoUringRegister(int fd, unsigned opcode, void *parg, unsigned nrargs)
+{
+    return (int)syscall(__NR_io_uring_register, fd, opcode, parg, nrargs);
+}
+
+XMNUringBackend::XMNUringBackend(const unsigned &kEntries,
+                                 const unsigned &kRecvBuffCount,
+                                 const unsigned &kRecvBuffSize) : entries_(kEntries),
+                                                                  recvbuffcount_(kRecvBuffCount),
+                                                                  recvbuffsize_(kRecvBuffSize)
+{
+    ring_fd_ = -1;
+    eventthread_ = 0;
+    pthread_mutex_init(&sq_mutex_, nullptr);
+    psqring_ = nullptr;
+    sqringsize_ = 0;
+    pcqring_ = nullptr;
+    cqringsize_ = 0;
+    psqes_ = nullptr;
+    sqessize_ = 0;
+    psqhead_ = nullptr;
+    psqtail_ = nullptr;
+    sqmask_ = 0;
+    psqarray_ = nullptr;
+    sqlocaltail_ = 0;
+    pcqhead_ = nullptr;
+    pcqtail_ = nullptr;
+    cqmask_ = 0;
+    pcqes_ = nullptr;
+    pbufring_ = nullptr;
+    bufringsize_ = 0;
+    precvbuffs_ = nullptr;
+    bufringtail_ = 0;
+}
+
+XMNUringBackend::~XMNUringBackend()
+{
+    /**
+     * 关闭 io_uring 时内核会撤销所有未完成的请求，之后才能释放缓冲区。
+    */
+    if (ring_fd_ != -1)
+    {
+        close(ring_fd_);
+        ring_fd_ = -1;
+    }
+    if (psqes_ != nullptr)
+    {
+        munmap(psqes_, sqessize_);
+    }
+    if (pcqring_ != nullptr && pcqring_ != psqring_)
+    {
+        munmap(pcqring_, cqringsize_);
+    }
+    if (psqring_ != nullptr)
+    {
+        munmap(psqring_, sqringsize_);
+    }
+    if (pbufring_ != nullptr)
+    {
+        munmap(pbufring_, bufringsize_);
+    }
+    if (precvbuffs_ != nullptr)
+    {
+        munmap(precvbuffs_, (size_t)recvbuffcount_ * recvbuffsize_);
+    }
+    pthread_mutex_destroy(&sq_mutex_);
+}
+
+int XMNUringBackend::Init()
+{
+    /**
+     * （1）创建 io_uring ，CQ 的大小为 SQ 的 4 倍，multishot 请求会产生多个完成事件。
+    */
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries_ * 4;
+    ring_fd_ = XMNIoUringSetup(entries_, &params);
+    if (ring_fd_ < 0)
+    {
+        XMNLogStdErr(errno, "XMNUringBackend::Init 中 io_uring_setup 执行失败。");
+        ring_fd_ = -1;
+        return -1;
+    }
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP))
+    {
+        XMNLogStdErr(0, "XMNUringBackend::Init 发现内核不支持 IORING_FEAT_EXT_ARG 或者 IORING_FEAT_NODROP 。");
+        return -1;
+    }
+
+    /**
+     * （2）映射 SQ 、CQ 以及 SQE 数组。
+    */
+    sqringsize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqringsize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        sqringsize_ = cqringsize_ = (sqringsize_ > cqringsize_ ? sqringsize_ : cqringsize_);
+    }
+    psqring_ = mmap(nullptr, sqringsize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (psqring_ == MAP_FAILED)
+    {
+        psqring_ = nullptr;
+        XMNLogStdErr(errno, "XMNUringBackend::Init 中 mmap SQ 执行失败。");
+        return -2;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        pcqring_ = psqring_;
+    }
+    else
+    {
+        pcqring_ = mmap(nullptr, cqringsize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        if (pcqring_ == MAP_FAILED)
+        {
+            pcqring_ = nullptr;
+            XMNLogStdErr(errno, "XMNUringBackend::Init 中 mmap CQ 执行失败。");
+            return -2;
+        }
+    }
+    sqessize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *psqes = mmap(nullptr, sqessize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (psqes == MAP_FAILED)
+    {
+        XMNLogStdErr(errno, "XMNUringBackend::Init 中 mmap SQE 执行失败。");
+        return -2;
+    }
+    psqes_ = (struct io_uring_sqe *)psqes;
+
+    char *psq = (char *)psqring_;
+    psqhead_ = (unsigned *)(psq + params.sq_off.head);
+    psqtail_ = (unsigned *)(psq + params.sq_off.tail);
+    sqmask_ = *(unsigned *)(psq + params.sq_off.ring_mask);
+    psqarray_ = (unsigned *)(psq + params.sq_off.array);
+    sqlocaltail_ = *psqtail_;
+
+    char *pcq = (char *)pcqring_;
+    pcqhead_ = (unsigned *)(pcq + params.cq_off.head);
+    pcqtail_ = (unsigned *)(pcq + params.cq_off.tail);
+    cqmask_ = *(unsigned *)(pcq + params.cq_off.ring_mask);
+    pcqes_ = (struct io_uring_cqe *)(pcq + params.cq_off.cqes);
+
+    /**
+     * （3）创建并注册 provided buffer ring ，buffer group 为 0 。
+    */
+    bufringsize_ = recvbuffcount_ * sizeof(struct io_uring_buf);
+    void *pbufring = mmap(nullptr, bufringsize_, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (pbufring == MAP_FAILED)
+    {
+        XMNLogStdErr(errno, "XMNUringBackend::Init 中 mmap buffer ring 执行失败。");
+        return -3;
+    }
+    pbufring_ = (struct io_uring_buf_ring *)pbufring;
+    void *precvbuffs = mmap(nullptr, (size_t)recvbuffcount_ * recvbuffsize_, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (precvbuffs == MAP_FAILED)
+    {
+        XMNLogStdErr(errno, "XMNUringBackend::Init 中 mmap 接收缓冲区执行失败。");
+        return -3;
+    }
+    precvbuffs_ = (char *)precvbuffs;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)pbufring_;
+    reg.ring_entries = recvbuffcount_;
+    reg.bgid = 0;
+    if (XMNIoUringRegister(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+    {
+        XMNLogStdErr(errno, "XMNUringBackend::Init 中注册 provided buffer ring 失败。");
+        return -3;
+    }
+    bufringtail_ = 0;
+    for (unsigned i = 0; i < recvbuffcount_; ++i)
+    {
+        RecycleRecvBuff(i);
+    }
+
+    /**
+     * （4）默认 Init 和 Wait 都在 worker 进程的主线程中调用，由 reactor 线程运行时通过 SetEventThread 修改。
+    */
+    eventthread_ = pthread_self();
+    vreadyevents_.resize(XMN_EPOLL_WAIT_MAX_EVENTS);
+    return 0;
+}
+
+struct io_uring_sqe *XMNUringBackend::GetSqe()
+{
+    unsigned head = __atomic_load_n(psqhead_, __ATOMIC_ACQUIRE);
+    if (sqlocaltail_ - head > sqmask_)
+    {
+        /**
+         * SQ 已满，先提交已有的请求腾出空间。
+        */
+        Submit();
+        head = __atomic_load_n(psqhead_, __ATOMIC_ACQUIRE);
+        if (sqlocaltail_ - head > sqmask_)
+        {
+            return nullptr;
+        }
+    }
+
+    unsigned index = sqlocaltail_ & sqmask_;
+    struct io_uring_sqe *psqe = &psqes_[index];
+    memset(psqe, 0, sizeof(struct io_uring_sqe));
+    psqarray_[index] = index;
+    ++sqlocaltail_;
+    return psqe;
+}
+
+int XMNUringBackend::Submit()
+{
+    /**
+     * SQE 填写完毕之后才更新 SQ 的 tail ，否则其他线程的提交可能会把尚未填写完的 SQE 交给内核。
+    */
+    __atomic_store_n(psqtail_, sqlocaltail_, __ATOMIC_RELEASE);
+    unsigned tosubmit = sqlocaltail_ - __atomic_load_n(psqhead_, __ATOMIC_ACQUIRE);
+    if (tosubmit == 0)
+    {
+        return 0;
+    }
+
+    int r = 0;
+    do
+    {
+        r = XMNIoUringEnter(ring_fd_, tosubmit, 0, 0, nullptr, 0);
+    } while (r < 0 && errno == EINTR);
+    if (r < 0)
+    {
+        XMNLogStdErr(errno, "XMNUringBackend::Submit 中 io_uring_enter 执行失败。");
+    }
+    return r;
+}
+
+void XMNUringBackend::SubmitIfForeign()
+{
+    if (!pthread_equal(pthread_self(), eventthread_))
+    {
+        Submit();
+    }
+}
+
+void XMNUringBackend::ArmAccept(XMNConnSockInfo *pconnsockinfo, const int &kSockFd)
+{
+    struct io_uring_sqe *psqe = GetSqe();
+    if (psqe == nullptr)
+    {
+        XMNLogStdErr(0, "XMNUringBackend::ArmAccept 中 SQ 已满。");
+        return;
+    }
+    psqe->opcode = IORING_OP_ACCEPT;
+    psqe->fd = kSockFd;
+    psqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    psqe->accept_flags = SOCK_NONBLOCK;
+    psqe->user_data = UserData(pconnsockinfo, REQ_ACCEPT);
+    pconnsockinfo->uringflags |= FLAG_READ_ARMED;
+}
+
+void XMNUringBackend::ArmRecv(XMNConnSockInfo *pconnsockinfo, const int &kSockFd)
+{
+    struct io_uring_sqe *psqe = GetSqe();
+    if (psqe == nullptr)
+    {
+        XMNLogStdErr(0, "XMNUringBackend::ArmRecv 中 SQ 已满。");
+        return;
+    }
+    psqe->opcode = IORING_OP_RECV;
+    psqe->fd = kSockFd;
+    psqe->ioprio = IORING_RECV_MULTISHOT;
+    psqe->flags = IOSQE_BUFFER_SELECT;
+    psqe->buf_group = 0;
+    psqe->user_data = UserData(pconnsockinfo, REQ_RECV);
+    pconnsockinfo->uringflags |= FLAG_READ_ARMED;
+}
+
+void XMNUringBackend::ArmPollOut(XMNConnSockInfo *pconnsockinfo, const int &kSockFd)
+{
+    struct io_uring_sqe *psqe = GetSqe();
+    if (psqe == nullptr)
+    {
+        XMNLogStdErr(0, "XMNUringBackend::ArmPollOut 中 SQ 已满。");
+        return;
+    }
+    psqe->opcode = IORING_OP_POLL_ADD;
+    psqe->fd = kSockFd;
+    psqe->poll32_events = POLLOUT;
+    psqe->user_data = UserData(pconnsockinfo, REQ_POLLOUT);
+    pconnsockinfo->uringflags |= FLAG_POLLOUT_ARMED;
+}
+
+void XMNUringBackend::ArmPollIn(XMNConnSockInfo *pconnsockinfo, const int &kSockFd)
+{
+    struct io_uring_sqe *psqe = GetSqe();
+    if (psqe == nullptr)
+    {
+        XMNLogStdErr(0, "XMNUringBackend::ArmPollIn 中 SQ 已满。");
+        return;
+    }
+    psqe->opcode = IORING_OP_POLL_ADD;
+    psqe->fd = kSockFd;
+    psqe->poll32_events = POLLIN;
+    psqe->user_data = UserData(pconnsockinfo, REQ_POLLIN);
+    pconnsockinfo->uringflags |= FLAG_POLLIN_ARMED;
+}
+
+uint64_t XMNUringBackend::UserData(XMNConnSockInfo *pconnsockinfo, const uint8_t &kType)
+{
+    return (pconnsockinfo->Handle() << 3) | kType;
+}
+
+void XMNUringBackend::CancelRequest(const uint64_t &kUserData)
+{
+    struct io_uring_sqe *psqe = GetSqe();
+    if (psqe == nullptr)
+    {
+        XMNLogStdErr(0, "XMNUringBackend::CancelRequest 中 SQ 已满。");
+        return;
+    }
+    psqe->opcode = IORING_OP_ASYNC_CANCEL;
+    psqe->fd = -1;
+    psqe->addr = kUserData;
+    psqe->user_data = REQ_IGNORE;
+}
+
+void XMNUringBackend::CancelFd(const int &kSockFd)
+{
+    struct io_uring_sqe *psqe = GetSqe();
+    if (psqe == nullptr)
+    {
+        XMNLogStdErr(0, "XMNUringBackend::CancelFd 中 SQ 已满。");
+        return;
+    }
+    psqe->opcode = IORING_OP_ASYNC_CANCEL;
+    psqe->fd = kSockFd;
+    psqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+    psqe->user_data = REQ_IGNORE;
+}
+
+void XMNUringBackend::RecycleRecvBuff(const int &kBid)
+{
+    /**
+     * io_uring_buf_ring 中的 bufs 由 __DECLARE_FLEX_ARRAY 声明，在 C++ 中其偏移量不为 0 ，
+     * 故直接将其当作 io_uring_buf 数组使用，tail 与 bufs[0].resv 重叠。
+    */
+    struct io_uring_buf *pbufs = (struct io_uring_buf *)pbufring_;
+    struct io_uring_buf *pbuf = &pbufs[bufringtail_ & (recvbuffcount_ - 1)];
+    pbuf->addr = (uint64_t)(uintptr_t)(precvbuffs_ + (size_t)kBid * recvbuffsize_);
+    pbuf->len = recvbuffsize_;
+    pbuf->bid = (unsigned short)kBid;
+    ++bufringtail_;
+    __atomic_store_n(&pbufs[0].resv, bufringtail_, __ATOMIC_RELEASE);
+}
+
+void XMNUringBackend::RearmTerminated()
+{
+    for (auto &x : vrearmconnsockinfo_)
+    {
+        x->uringflags &= ~FLAG_REARM_QUEUED;
+        if (!(x->uringflags & FLAG_READ_ARMED) || x->fd == -1)
+        {
+            continue;
+        }
+        if (x->uringflags & FLAG_LISTEN)
+        {
+            ArmAccept(x, x->fd);
+        }
+        else
+        {
+            ArmRecv(x, x->fd);
+        }
+    }
+    vrearmconnsockinfo_.clear();
+}
+
+int XMNUringBackend::Ctl(const int &kSockFd,
+                         const uint32_t &kOption,
+                         const uint32_t &kEvents,
+                         XMNConnSockInfo *pconnsockinfo)
+{
+    XMNLockMutex sqmutex(&sq_mutex_);
+    if (kOption == EPOLL_CTL_ADD)
+    {
+        /**
+         * 监听 socket 和其对应的连接的 fd 相同，以此区分监听 socket 和连接 socket 。
+        */
+        bool islisten = pconnsockinfo->plistensockinfo != nullptr && pconnsockinfo->plistensockinfo->fd == kSockFd;
+        pconnsockinfo->uringflags = islisten ? FLAG_LISTEN : 0;
+        if (kEvents & EPOLLIN)
+        {
+            if (islisten)
+            {
+                ArmAccept(pconnsockinfo, kSockFd);
+            }
+            else
+            {
+                ArmRecv(pconnsockinfo, kSockFd);
+            }
+        }
+        if (!islisten && (kEvents & EPOLLOUT))
+        {
+            ArmPollOut(pconnsockinfo, kSockFd);
+        }
+    }
+    else if (kOption == EPOLL_CTL_MOD)
+    {
+        /**
+         * 去掉 EPOLLIN 时撤销 multishot recv ，加上 EPOLLIN 时重新提交。
+         * 去掉 EPOLLOUT 时不需要撤销 poll 请求，Wait 中会丢弃不再需要的 POLLOUT 事件。
+        */
+        if (!(pconnsockinfo->uringflags & FLAG_LISTEN))
+        {
+            if ((kEvents & EPOLLIN) && !(pconnsockinfo->uringflags & FLAG_READ_ARMED))
+            {
+                ArmRecv(pconnsockinfo, kSockFd);
+            }
+            else if (!(kEvents & EPOLLIN) && (pconnsockinfo->uringflags & FLAG_READ_ARMED))
+            {
+                CancelRequest(UserData(pconnsockinfo, REQ_RECV));
+                pconnsockinfo->uringflags &= ~FLAG_READ_ARMED;
+            }
+            if ((kEvents & EPOLLOUT) && !(pconnsockinfo->uringflags & FLAG_POLLOUT_ARMED))
+            {
+                ArmPollOut(pconnsockinfo, kSockFd);
+            }
+        }
+    }
+    else if (kOption == EPOLL_CTL_DEL)
+    {
+        CancelFd(kSockFd);
+        pconnsockinfo->uringflags &= ~(FLAG_READ_ARMED | FLAG_POLLOUT_ARMED);
+    }
+    else
+    {
+        return -1;
+    }
+
+    SubmitIfForeign();
+    return 0;
+}
+
+int XMNUringBackend::AddReadableFd(const int &kFd, XMNConnSockInfo *pconnsockinfo)
+{
+    XMNLockMutex sqmutex(&sq_mutex_);
+    pconnsockinfo->uringflags = 0;
+    ArmPollIn(pconnsockinfo, kFd);
+    SubmitIfForeign();
+    return 0;
+}
+
+void XMNUringBackend::SetEventThread(const pthread_t &kThread)
+{
+    XMNLockMutex sqmutex(&sq_mutex_);
+    eventthread_ = kThread;
+}
+
+int XMNUringBackend::Wait(struct epoll_event *pevents, const int &kMaxEvents, const int &kTimer)
+{
+    /**
+     * （1）重新提交已经终止的 multishot 请求，统计需要提交的请求的数量。
+    */
+    unsigned tosubmit = 0;
+    {
+        XMNLockMutex sqmutex(&sq_mutex_);
+        RearmTerminated();
+        __atomic_store_n(psqtail_, sqlocaltail_, __ATOMIC_RELEASE);
+        tosubmit = sqlocaltail_ - __atomic_load_n(psqhead_, __ATOMIC_ACQUIRE);
+    }
+
+    /**
+     * （2）CQ 中没有事件时，提交请求并等待事件，只需一次 io_uring_enter 。
+     * 其他线程可能同时提交请求，内核会按 SQ 的顺序处理，tosubmit 大于实际数量时只提交实际的数量。
+    */
+    unsigned cqhead = *pcqhead_;
+    unsigned cqtail = __atomic_load_n(pcqtail_, __ATOMIC_ACQUIRE);
+    if (cqhead == cqtail)
+    {
+        struct __kernel_timespec ts;
+        struct io_uring_getevents_arg arg;
+        memset(&arg, 0, sizeof(arg));
+        unsigned flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        if (kTimer >= 0)
+        {
+            ts.tv_sec = kTimer / 1000;
+            ts.tv_nsec = (long long)(kTimer % 1000) * 1000000;
+            arg.ts = (uint64_t)(uintptr_t)&ts;
+        }
+        int r = XMNIoUringEnter(ring_fd_, tosubmit, 1, flags, &arg, sizeof(arg));
+        if (r < 0)
+        {
+            if (errno == ETIME)
+            {
+                return 0;
+            }
+            if (errno != EINTR)
+            {
+                return -1;
+            }
+        }
+        cqtail = __atomic_load_n(pcqtail_, __ATOMIC_ACQUIRE);
+        if (r < 0 && cqhead == cqtail)
+        {
+            return -1;
+        }
+    }
+    else if (tosubmit > 0)
+    {
+        XMNLockMutex sqmutex(&sq_mutex_);
+        Submit();
+    }
+
+    /**
+     * （3）将完成事件转换为 epoll_event 。
+    */
+    XMNConnSlotTable &slottable = SingletonBase<XMNConnSlotTable>::GetInstance();
+    int eventcount = 0;
+    while (cqhead != cqtail && eventcount < kMaxEvents)
+    {
+        struct io_uring_cqe *pcqe = &pcqes_[cqhead & cqmask_];
+        ++cqhead;
+
+        uint8_t type = (uint8_t)(pcqe->user_data & 7);
+        XMNConnSockInfo *pconnsockinfo = slottable.Get(pcqe->user_data >> 3);
+        int res = pcqe->res;
+        int bid = (pcqe->flags & IORING_CQE_F_BUFFER) ? (int)(pcqe->flags >> IORING_CQE_BUFFER_SHIFT) : -1;
+
+        /**
+         * 请求所属的连接已经关闭（槽可能已经被新的连接使用），标志位也不再属于该请求，只需归还缓冲区。
+        */
+        if (pconnsockinfo == nullptr)
+        {
+            if (bid >= 0)
+            {
+                RecycleRecvBuff(bid);
+            }
+            continue;
+        }
+
+        if (type == REQ_ACCEPT || type == REQ_RECV)
+        {
+            /**
+             * multishot 请求终止（缓冲区耗尽、出错等）时，若连接仍需要接收数据，则在下一次 Wait 时重新提交。
+            */
+            if (!(pcqe->flags & IORING_CQE_F_MORE) && res != -ECANCELED)
+            {
+                /**
+                 * 被撤销的请求由撤销者维护标志位，撤销之后可能已经重新提交了新的请求，这里不能再修改。
+                */
+                XMNLockMutex sqmutex(&sq_mutex_);
+                if (res == 0)
+                {
+                    pconnsockinfo->uringflags &= ~FLAG_READ_ARMED;
+                }
+                else if ((pconnsockinfo->uringflags & FLAG_READ_ARMED) && !(pconnsockinfo->uringflags & FLAG_REARM_QUEUED))
+                {
+                    pconnsockinfo->uringflags |= FLAG_REARM_QUEUED;
+                    vrearmconnsockinfo_.push_back(pconnsockinfo);
+                }
+            }
+
+            /**
+             * 连接已经关闭，或者只是缓冲区暂时耗尽，则不需要分发。
+            */
+            if (pconnsockinfo->fd == -1 || res == -ECANCELED || res == -ENOBUFS)
+            {
+                if (bid >= 0)
+                {
+                    RecycleRecvBuff(bid);
+                }
+                continue;
+            }
+            pevents[eventcount].events = EPOLLIN;
+        }
+        else if (type == REQ_POLLOUT)
+        {
+            bool iswanted = false;
+            {
+                XMNLockMutex sqmutex(&sq_mutex_);
+                pconnsockinfo->uringflags &= ~FLAG_POLLOUT_ARMED;
+                iswanted = pconnsockinfo->fd != -1 && (pconnsockinfo->events & EPOLLOUT);
+            }
+            if (!iswanted || res == -ECANCELED)
+            {
+                continue;
+            }
+            pevents[eventcount].events = res > 0 ? (uint32_t)res : (EPOLLOUT | EPOLLERR);
+        }
+        else if (type == REQ_POLLIN)
+        {
+            {
+                XMNLockMutex sqmutex(&sq_mutex_);
+                pconnsockinfo->uringflags &= ~FLAG_POLLIN_ARMED;
+            }
+            if (pconnsockinfo->fd == -1 || res == -ECANCELED)
+            {
+                continue;
+            }
+            pevents[eventcount].events = EPOLLIN;
+        }
+        else
+        {
+            continue;
+        }
+
+        pevents[eventcount].data.u64 = pconnsockinfo->Handle();
+        vreadyevents_[eventcount].pconnsockinfo = pconnsockinfo;
+        vreadyevents_[eventcount].res = res;
+        vreadyevents_[eventcount].bid = bid;
+        vreadyevents_[eventcount].type = type;
+        ++eventcount;
+    }
+    __atomic_store_n(pcqhead_, cqhead, __ATOMIC_RELEASE);
+
+    return eventcount;
+}
+
+void XMNUringBackend::PrepareEvent(const int &kIndex)
+{
+    ReadyEvent &ev = vreadyevents_[kIndex];
+    if (ev.type == REQ_RECV)
+    {
+        /**
+         * 数据取完之后，Recv 返回 EAGAIN ；对端关闭或者出错时 Recv 直接返回对应的结果。
+        */
+        ev.pconnsockinfo->preadydata = ev.bid >= 0 ? precvbuffs_ + (size_t)ev.bid * recvbuffsize_ : nullptr;
+        ev.pconnsockinfo->readydatalen = ev.res > 0 ? (size_t)ev.res : 0;
+        ev.pconnsockinfo->readyres = ev.res > 0 ? -EAGAIN : ev.res;
+    }
+    else if (ev.type == REQ_ACCEPT)
+    {
+        ev.pconnsockinfo->readyres = ev.res;
+    }
+}
+
+void XMNUringBackend::FinishEvent(const int &kIndex)
+{
+    ReadyEvent &ev = vreadyevents_[kIndex];
+    if (ev.type == REQ_RECV)
+    {
+        /**
+         * 状态机没有取走的数据（连接在处理过程中被关闭）直接丢弃。
+        */
+        ev.pconnsockinfo->preadydata = nullptr;
+        ev.pconnsockinfo->readydatalen = 0;
+        ev.pconnsockinfo->readyres = -EAGAIN;
+        if (ev.bid >= 0)
+        {
+            RecycleRecvBuff(ev.bid);
+        }
+    }
+    else if (ev.type == REQ_ACCEPT)
+    {
+        /**
+         * 新连接没有被取走（例如 LT 模式下的处理函数提前返回）时需要关闭，否则会泄漏。
+        */
+        if (ev.pconnsockinfo->readyres >= 0)
+        {
+            close(ev.pconnsockinfo->readyres);
+        }
+        ev.pconnsockinfo->readyres = -EAGAIN;
+    }
+    else if (ev.type == REQ_POLLOUT)
+    {
+        /**
+         * poll 请求只通知一次，若仍然关注 EPOLLOUT（数据没有发完），则重新提交，与 epoll 的 LT 模式保持一致。
+        */
+        XMNLockMutex sqmutex(&sq_mutex_);
+        if (ev.pconnsockinfo->fd != -1 && (ev.pconnsockinfo->events & EPOLLOUT) && !(ev.pconnsockinfo->uringflags & FLAG_POLLOUT_ARMED))
+        {
+            ArmPollOut(ev.pconnsockinfo, ev.pconnsockinfo->fd);
+        }
+    }
+    else if (ev.type == REQ_POLLIN)
+    {
+        /**
+         * 同理，poll 请求只通知一次，处理完之后重新提交。
+        */
+        XMNLockMutex sqmutex(&sq_mutex_);
+        if (ev.pconnsockinfo->fd != -1 && !(ev.pconnsockinfo->uringflags & FLAG_POLLIN_ARMED))
+        {
+            ArmPollIn(ev.pconnsockinfo, ev.pconnsockinfo->fd);
+        }
+    }
+}
+
+int XMNUringBackend::Accept(XMNConnSockInfo *plistenconnsockinfo,
+                            struct sockaddr *paddr,
+                            socklen_t *paddrlen,
+                            const int &kFlags)
+{
+    /**
+     * multishot accept 不返回 client 的地址，通过 getpeername 获取。
+    */
+    int linkfd = plistenconnsockinfo->readyres;
+    if (linkfd < 0)
+    {
+        errno = -linkfd;
+        return -1;
+    }
+    plistenconnsockinfo->readyres = -EAGAIN;
+    if (getpeername(linkfd, paddr, paddrlen) != 0)
+    {
+        memset(paddr, 0, *paddrlen);
+    }
+    return linkfd;
+}
+
+ssize_t XMNUringBackend::Recv(XMNConnSockInfo *pconnsockinfo, const struct iovec *piov, const int &kIovCnt)
+{
+    if (pconnsockinfo->readydatalen > 0)
+    {
+        size_t total = 0;
+        for (int i = 0; i < kIovCnt && pconnsockinfo->readydatalen > 0; ++i)
+        {
+            size_t n = pconnsockinfo->readydatalen < piov[i].iov_len ? pconnsockinfo->readydatalen : piov[i].iov_len;
+            memcpy(piov[i].iov_base, pconnsockinfo->preadydata, n);
+            pconnsockinfo->preadydata += n;
+            pconnsockinfo->readydatalen -= n;
+            total += n;
+        }
+        return (ssize_t)total;
+    }
+    if (pconnsockinfo->readyres == 0)
+    {
+        return 0;
+    }
+    errno = -pconnsockinfo->readyres;
+    return -1;
+}
+
+ssize_t XMNUringBackend::Send(XMNConnSockInfo *pconnsockinfo, const struct iovec *piov, const int &kIovCnt, const int &kFlags)
+{
+    /**
+     * 发送数据在发送数据线程中进行，且需要立即知道实际发送的字节数，仍然直接调用 sendmsg 。
+    */
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(struct msghdr));
+    msg.msg_iov = (struct iovec *)piov;
+    msg.msg_iovlen = kIovCnt;
+    return sendmsg(pconnsockinfo->fd, &msg, MSG_NOSIGNAL | kFlags);
+}
+
+int XMNUringBackend::Close(XMNConnSockInfo *pconnsockinfo)
+{
+    /**
+     * io_uring 的请求持有 socket 的引用，直接 close 并不会终止 multishot 请求，socket 也不会真正关闭，
+     * 所以在 close 之前先撤销该 socket 上所有的请求，并立即提交。
+    */
+    {
+        XMNLockMutex sqmutex(&sq_mutex_);
+        CancelFd(pconnsockinfo->fd);
+        pconnsockinfo->uringflags &= ~(FLAG_READ_ARMED | FLAG_POLLOUT_ARMED);
+        Submit();
+    }
+    return close(pconnsockinfo->fd);
+}
@@ -5,16 +5,27 @@
 #include "xmn_lockmutex.hpp"
 #include "xmn_memory.h"
 #include "xmn_mempool.hpp"
+#include "xmn_global.h"
+#include "xmn_epoch.h"
+#include "xmn_crc32.h"
 
 #include "sys/socket.h"
 #include "sys/types.h"
 #include "sys/ioctl.h"
+#include "sys/mman.h"
 #include "linux/sockios.h"
+#include "linux/filter.h"
 #include "arpa/inet.h"
+#include "netinet/in.h"
+#include "netinet/tcp.h"
+#include "sys/un.h"
 #include "errno.h"
 #include "unistd.h"
 #include <errno.h>
 #include <sys/time.h>
+#include <linux/errqueue.h>
+#include <sys/eventfd.h>
+#include <time.h>
 
 #include <cstdio>
 #include <sstream>
@@ -25,20 +36,67 @@ XMNSocket::XMNSocket() : kMsgHeaderLen_(sizeof(XMNMsgHeader)),
 {
     listenport_count_ = 0;
     worker_connection_count_ = 0;
-    epoll_handle_ = 0;
+    worker_process_count_ = 0;
+    reuseportenable_ = false;
+    reuseportcpusteering_ = false;
+    acceptbalancemode_ = XMN_ACCEPT_BALANCE_NONE;
+    acceptstopcount_ = 0;
+    acceptresumecount_ = 0;
+    acceptenabled_ = false;
+    acceptmutexdelay_ = 500;
+    paccept_mutex_ = nullptr;
+    acceptmutexheld_ = false;
+    epolletenable_ = false;
+    eventbackend_ = XMN_EVENT_BACKEND_EPOLL;
+    uringentries_ = 1024;
+    uringrecvbuffcount_ = 1024;
+    uringrecvbuffsize_ = 4096;
+    recvbuffsize_ = 16384;
+    pkgmaxbodylen_ = 16777216;
+    streamhighwater_ = 262144;
+    streamlowwater_ = 65536;
+    backpressureenable_ = true;
+    connrecvhighwater_ = 256;
+    connrecvlowwater_ = 64;
+    connsendhighwater_ = 1048576;
+    connsendlowwater_ = 262144;
+    recvqueuehighwater_ = 100000;
+    recvqueuelowwater_ = 50000;
+    sendqueuehighwater_ = 40000;
+    sendqueuelowwater_ = 20000;
+    sendmaxpendingmsgs_ = XMN_SEND_MAX_PENDING_MSGS;
+    streammaxpendingchunks_ = XMN_STREAM_MAX_PENDING_CHUNKS;
+    recvpausecount_ = 0;
+    isrecvpausedtimer_ = false;
+    sendzerocopyenable_ = false;
+    sendzerocopythreshold_ = 16384;
+    senddirectenable_ = false;
+    sendthreadcount_ = 1;
+    reactorthreadcount_ = 0;
+    reactordispatchmode_ = XMN_REACTOR_DISPATCH_ROUNDROBIN;
+    reactornext_ = 0;
+    busypollspinns_ = 0;
+    busypollsocketus_ = 0;
     //pool_connsock_count_ = 0;
     //pool_free_connsock_count_ = 0;
     pool_recyconnsock_count_ = 0;
     queue_senddata_count_ = 0;
-    recyconnsockinfowaittime_ = 0;
-    memset(wait_events_, 0, sizeof(struct epoll_event) * XMN_EPOLL_WAIT_MAX_EVENTS);
 
     /**
      * 心跳监控相关变量。
     */
     pingenable_ = false;
     pingwaittime_ = 0;
-    ping_multimap_count_ = 0;
+    ptimerconnsockinfo_ = nullptr;
+
+    /**
+     * UDP 心跳相关的变量。
+    */
+    udpport_ = 0;
+    pudpconnsockinfo_ = nullptr;
+    pudpbatch_ = nullptr;
+    udppingcount_ = 0;
+    udpdropcount_ = 0;
 
     /**
      * 在线用户相关的变量。
@@ -76,9 +134,29 @@ int XMNSocket::Initialize()
     }
 
     /**
-     * 开启指定的端口号。
+     * accept 互斥量需要在 fork 之前创建于共享内存中，以便所有的 worker 进程共享。
     */
-    return OpenListenSocket();
+    if (acceptbalancemode_ == XMN_ACCEPT_BALANCE_MUTEX)
+    {
+        void *pshm = mmap(nullptr, sizeof(XMNAcceptMutex), PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_SHARED, -1, 0);
+        if (pshm == MAP_FAILED)
+        {
+            XMNLogInfo(XMN_LOG_EMERG, errno, "XMNSocket::Initialize 中 mmap 创建 accept 互斥量失败。");
+            return -12;
+        }
+        paccept_mutex_ = new (pshm) XMNAcceptMutex();
+        paccept_mutex_->lock = 0;
+    }
+
+    /**
+     * 开启指定的端口号以及接收 UDP 心跳的端口。
+    */
+    r = OpenListenSocket();
+    if (r != 0)
+    {
+        return r;
+    }
+    return OpenUdpSocket();
 }
 
 int XMNSocket::InitializeWorker()
@@ -87,8 +165,7 @@ int XMNSocket::InitializeWorker()
      * （1）初始化互斥量。
      * a、与连接池操作相关的互斥量。
      * b、与回收连接池相关的互斥量。
-     * c、与发送消息相关的互斥量。
-     * d、与心跳包收发监控相关的互斥量。
+     * c、与暂停接收的连接的列表相关的互斥量。
     */
     if (pthread_mutex_init(&connsock_pool_mutex_, nullptr) != 0)
     {
@@ -100,43 +177,51 @@ int XMNSocket::InitializeWorker()
         XMNLogStdErr(0, "XMNSocket::InitializeWorker 中 pthread_mutex_init(&connsock_pool_recycle_mutex_) 执行失败。");
         return -2;
     }
-    if (pthread_mutex_init(&senddata_queue_mutex_, nullptr) != 0)
+    if (pthread_mutex_init(&recvpausedmutex_, nullptr) != 0)
     {
-        XMNLogStdErr(0, "XMNSocket::InitializeWorker 中 pthread_mutex_init(&senddata_queue_mutex_) 执行失败。");
+        XMNLogStdErr(0, "XMNSocket::InitializeWorker 中 pthread_mutex_init(&recvpausedmutex_) 执行失败。");
         return -3;
     }
-    if (pthread_mutex_init(&ping_multimap_mutex_, nullptr) != 0)
+
+    /**
+     * （2）初始化各个发送数据线程的发送连接队列。
+    */
+    for (size_t i = 0; i < sendthreadcount_; i++)
     {
-        XMNLogStdErr(0, "XMNSocket::InitializeWorker 中 pthread_mutex_init(&ping_multimap_mutex_) 执行失败。");
-        return -3;
+        SendShard *psendshard = new SendShard(this);
+        if (pthread_mutex_init(&psendshard->connqueue_mutex_, nullptr) != 0)
+        {
+            XMNLogStdErr(0, "XMNSocket::InitializeWorker 中 pthread_mutex_init(&connqueue_mutex_) 执行失败。");
+            delete psendshard;
+            return -4;
+        }
+        psendshard->eventfd_ = eventfd(0, EFD_CLOEXEC);
+        if (psendshard->eventfd_ == -1)
+        {
+            XMNLogStdErr(errno, "XMNSocket::InitializeWorker()中eventfd()执行失败。");
+            pthread_mutex_destroy(&psendshard->connqueue_mutex_);
+            delete psendshard;
+            return -4;
+        }
+        vsendshard_.push_back(psendshard);
     }
 
     /**
-     * （2）初始化信号量。
+     * （3）创建定时器时间轮，心跳监控和连接回收都由其驱动，在 EpollInit 中加入事件后端。
     */
-    if (sem_init(&senddata_queue_sem_, 0, 0) != 0)
+    if (timerwheel_.Create(XMN_TIMER_WHEEL_SLOTS, XMN_TIMER_WHEEL_TICK_MS) != 0)
     {
-        XMNLogStdErr(0, "XMNSocket::InitializeWorker()中sem_init()执行失败。");
-        return -4;
+        XMNLogStdErr(0, "XMNSocket::InitializeWorker()中创建定时器时间轮失败。");
+        return -5;
     }
 
     /**
-     * （3）创建线程。
-     * a、创建用于回收连接的线程。
-     * b、创建用于发送数据的线程。
-     * c、创建用于监控心跳包收发的线程。
+     * （4）创建用于发送数据的线程，每个发送连接队列一个。
     */
-    ThreadInfo *pthreadinfo_recyclesockinfo = new ThreadInfo(this);
-    pthread_create(&pthreadinfo_recyclesockinfo->threadhandle_, nullptr, ConnSockInfoRecycleThread, (void *)pthreadinfo_recyclesockinfo);
-    vthreadinfo_.push_back(pthreadinfo_recyclesockinfo);
-
-    ThreadInfo *pthreadinfo_senddata = new ThreadInfo(this);
-    pthread_create(&pthreadinfo_senddata->threadhandle_, nullptr, SendDataThread, (void *)pthreadinfo_senddata);
-    vthreadinfo_.push_back(pthreadinfo_senddata);
-
-    ThreadInfo *pthreadinfo_ping = new ThreadInfo(this);
-    pthread_create(&pthreadinfo_ping->threadhandle_, nullptr, PingThread, (void *)pthreadinfo_ping);
-    vthreadinfo_.push_back(pthreadinfo_ping);
+    for (const auto &x : vsendshard_)
+    {
+        pthread_create(&x->threadhandle_, nullptr, SendDataThread, (void *)x);
+    }
     return 0;
 }
 
@@ -146,9 +231,21 @@ int XMNSocket::EndWorker()
      * （1）终止线程。
      * 在执行该函数之前，全局变量 g_isquit 应该置为 true 。
     */
-    if (sem_post(&senddata_queue_sem_) != 0)
+    uint64_t wakeup = 1;
+    for (const auto &x : vsendshard_)
+    {
+        if (write(x->eventfd_, &wakeup, sizeof(wakeup)) != sizeof(wakeup))
+        {
+            XMNLogStdErr(errno, "XMNSocket::EndWorker()中write(eventfd)执行失败。");
+        }
+    }
+    WakeupReactors();
+    for (const auto &x : vreactor_)
     {
-        XMNLogStdErr(0, "XMNSocket::EndWorker()中sem_post()执行失败。");
+        if (x->threadhandle_ != 0)
+        {
+            pthread_join(x->threadhandle_, nullptr);
+        }
     }
 
     for (const auto &x : vthreadinfo_)
@@ -158,136 +255,403 @@ int XMNSocket::EndWorker()
     vthreadinfo_.clear();
     std::vector<ThreadInfo *>().swap(vthreadinfo_);
 
+    for (const auto &x : vsendshard_)
+    {
+        pthread_join(x->threadhandle_, nullptr);
+    }
+
     /**
-     * （2）回收线程池、发送消息队列和心跳监控 multimap 。
+     * （2）丢弃尚未到期的定时器，回收发送消息队列和等待回收的连接。
     */
+    timerwheel_.Destroy();
     FreeSendDataQueue();
-    FreePingMultiMap();
+    FreeRecycleConnSockInfo();
 
     /**
-     * （3）销毁所有的互斥量、信号量。
+     * （3）释放各个 reactor 的事件后端，所有的线程都已经退出，不会再使用它。
+    */
+    for (const auto &x : vreactor_)
+    {
+        if (x->peventbackend_ != nullptr)
+        {
+            delete x->peventbackend_;
+        }
+        if (x->wakeupfd_ != -1)
+        {
+            close(x->wakeupfd_);
+        }
+        delete x;
+    }
+    vreactor_.clear();
+    std::vector<Reactor *>().swap(vreactor_);
+
+    /**
+     * （4）销毁所有的互斥量和发送连接队列。
     */
     pthread_mutex_destroy(&connsock_pool_mutex_);
     pthread_mutex_destroy(&connsock_pool_recycle_mutex_);
-    pthread_mutex_destroy(&senddata_queue_mutex_);
-    pthread_mutex_destroy(&ping_multimap_mutex_);
-    sem_destroy(&senddata_queue_sem_);
+    pthread_mutex_destroy(&recvpausedmutex_);
+    for (const auto &x : vsendshard_)
+    {
+        close(x->eventfd_);
+        pthread_mutex_destroy(&x->connqueue_mutex_);
+        delete x;
+    }
+    vsendshard_.clear();
+    std::vector<SendShard *>().swap(vsendshard_);
     return 0;
 }
 
 int XMNSocket::OpenListenSocket()
 {
-    int exitcode = 0;
-    int r = 0;
-
-    /**
-     * 存放创建的监听 socket 。
-    */
-    int *psocksum = new int[listenport_count_]();
-
-    struct sockaddr_in addr;
-    addr.sin_family = AF_INET;
-
-    /**
-     * 0,0,0,0 该地址代表本机所有 IP 。
-    */
-    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    int sockfd = -1;
 
     /**
      * 对每一个 port 创建一个 socket 。
+     * 开启了 SO_REUSEPORT 模式时，对每一个 port 为每一个 worker 进程各创建一个 socket ，
+     * 由内核在这些 socket 之间分配新连接，从而避免所有 worker 进程都在同一个监听队列上被唤醒。
     */
     for (size_t i = 0; i < listenport_count_; i++)
     {
-        /**
-         *  创建连接 socket 。
-        */
-        psocksum[i] = socket(AF_INET, SOCK_STREAM, 0);
-        if (psocksum[i] <= 0)
+        if (!reuseportenable_)
         {
-            XMNLogInfo(XMN_LOG_EMERG, errno, "OpenListenSocket create listen socket failed.");
-            exitcode = -1;
-            goto exitlabel;
+            sockfd = OpenOneListenSocket(vportsum_[i], -1, &vsocketprofile_[vportprofile_[i]]);
+            if (sockfd < 0)
+            {
+                goto exitlabel;
+            }
+            continue;
         }
 
         /**
-         * 设置 server 关闭之后可以立刻重启 server 的功能，即：地址重用功能。
+         * 在 master 进程中按 worker 编号的顺序创建，保证 socket 在 reuseport 组中的下标就是 worker 编号，
+         * 这样 CBPF 程序返回的下标才能对应到指定的 worker 进程。
         */
-        int reuseaddr = 1;
-        r = setsockopt(psocksum[i], SOL_SOCKET, SO_REUSEADDR, (const void *)&reuseaddr, sizeof(int));
-        if (r != 0)
+        for (size_t w = 0; w < worker_process_count_; ++w)
         {
-            XMNLogInfo(XMN_LOG_EMERG, errno, "OpenListenSocket setsockopt failed.");
-            exitcode = -2;
-            goto exitlabel;
+            sockfd = OpenOneListenSocket(vportsum_[i], w, &vsocketprofile_[vportprofile_[i]]);
+            if (sockfd < 0)
+            {
+                goto exitlabel;
+            }
         }
 
         /**
-         * 设置 socket 为非堵塞模式。
+         * 按照接收数据包的 CPU 选择 socket ，组内任意一个 socket 挂载即可对整个组生效。
         */
-        r = SetNonBlocking(psocksum[i]);
-        if (r != 0)
+        if (reuseportcpusteering_ && AttachReusePortCpuProgram(sockfd) != 0)
         {
-            XMNLogInfo(XMN_LOG_EMERG, errno, "OpenListenSocket SetNonBlocking failed.");
-            exitcode = -3;
-            goto exitlabel;
+            XMNLogInfo(XMN_LOG_WARN, errno, "OpenListenSocket 挂载 reuseport CBPF 程序失败，将由内核按照哈希分配连接。");
         }
+    }
 
-        /**
-         * 绑定 IP 和 port 。
-        */
-        addr.sin_port = htons(vportsum_[i]);
-        r = bind(psocksum[i], (struct sockaddr *)&addr, sizeof(struct sockaddr));
-        if (r != 0)
+    /**
+     * Unix 域 socket 不支持 SO_REUSEPORT 分组，总是由所有 worker 进程共享。
+    */
+    for (size_t i = 0; i < vunixpath_.size(); ++i)
+    {
+        sockfd = OpenUnixListenSocket(vunixpath_[i], &vsocketprofile_[vunixprofile_[i]]);
+        if (sockfd < 0)
         {
-            XMNLogInfo(XMN_LOG_EMERG, errno, "OpenListenSocket bind failed.");
-            exitcode = -4;
             goto exitlabel;
         }
+    }
+    return 0;
 
-        /**
-         * 开始监听。
-        */
-        r = listen(psocksum[i], XMN_LISTEN_BACKLOG);
+exitlabel:
+    CloseListenSocket();
+    for (auto &x : vlistenportsockinfolist_)
+    {
+        delete x;
+    }
+    vlistenportsockinfolist_.clear();
+    return sockfd;
+}
+
+int XMNSocket::OpenOneListenSocket(const size_t &kPort, const int &kWorkerIndex, const XMNSocketProfile *pprofile)
+{
+    int r = 0;
+    int exitcode = 0;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(struct sockaddr_in));
+    addr.sin_family = AF_INET;
+
+    /**
+     * 0,0,0,0 该地址代表本机所有 IP 。
+    */
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    /**
+     *  创建连接 socket 。
+    */
+    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd <= 0)
+    {
+        XMNLogInfo(XMN_LOG_EMERG, errno, "OpenListenSocket create listen socket failed.");
+        return -1;
+    }
+
+    /**
+     * 设置 server 关闭之后可以立刻重启 server 的功能，即：地址重用功能。
+    */
+    int reuseaddr = 1;
+    r = setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, (const void *)&reuseaddr, sizeof(int));
+    if (r != 0)
+    {
+        XMNLogInfo(XMN_LOG_EMERG, errno, "OpenListenSocket setsockopt failed.");
+        exitcode = -2;
+        goto exitlabel;
+    }
+
+    /**
+     * 每个 worker 独占的 socket 需要开启端口复用功能。
+    */
+    if (kWorkerIndex >= 0)
+    {
+        int reuseport = 1;
+        r = setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, (const void *)&reuseport, sizeof(int));
         if (r != 0)
         {
-            XMNLogInfo(XMN_LOG_EMERG, errno, "OpenListenSocket listen failed.");
-            exitcode = -5;
+            XMNLogInfo(XMN_LOG_EMERG, errno, "OpenListenSocket setsockopt(SO_REUSEPORT) failed.");
+            exitcode = -2;
             goto exitlabel;
         }
 
         /**
-         * 将 port 和 soket 插入 vector 中。
+         * 告诉内核该 socket 所在的 worker 进程绑定的 CPU 。
+         * 挂载了 CBPF 程序时由该程序选择 socket ，该选项只在挂载失败、由内核按照哈希分配连接时作为参考，失败时不影响监听。
         */
+        if (reuseportcpusteering_)
+        {
+            int cpu = kWorkerIndex;
+            if (setsockopt(sockfd, SOL_SOCKET, SO_INCOMING_CPU, (const void *)&cpu, sizeof(int)) != 0)
+            {
+                XMNLogInfo(XMN_LOG_WARN, errno, "OpenListenSocket setsockopt(SO_INCOMING_CPU) failed.");
+            }
+        }
+    }
+
+    /**
+     * 按照 socket 配置方案设置监听 socket 的选项，缓冲区的大小需要在 listen 之前设置。
+    */
+    if ((pprofile->sendbuf > 0 && setsockopt(sockfd, SOL_SOCKET, SO_SNDBUF, (const void *)&pprofile->sendbuf, sizeof(int)) != 0) ||
+        (pprofile->recvbuf > 0 && setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, (const void *)&pprofile->recvbuf, sizeof(int)) != 0) ||
+        (pprofile->deferaccept > 0 && setsockopt(sockfd, IPPROTO_TCP, TCP_DEFER_ACCEPT, (const void *)&pprofile->deferaccept, sizeof(int)) != 0) ||
+        (pprofile->fastopen > 0 && setsockopt(sockfd, IPPROTO_TCP, TCP_FASTOPEN, (const void *)&pprofile->fastopen, sizeof(int)) != 0))
+    {
+        XMNLogInfo(XMN_LOG_EMERG, errno, "OpenListenSocket setsockopt of socket profile %s failed.", pprofile->name.c_str());
+        exitcode = -2;
+        goto exitlabel;
+    }
+
+    /**
+     * 设置 socket 为非堵塞模式。
+    */
+    r = SetNonBlocking(sockfd);
+    if (r != 0)
+    {
+        XMNLogInfo(XMN_LOG_EMERG, errno, "OpenListenSocket SetNonBlocking failed.");
+        exitcode = -3;
+        goto exitlabel;
+    }
+
+    /**
+     * 绑定 IP 和 port 。
+    */
+    addr.sin_port = htons(kPort);
+    r = bind(sockfd, (struct sockaddr *)&addr, sizeof(struct sockaddr));
+    if (r != 0)
+    {
+        XMNLogInfo(XMN_LOG_EMERG, errno, "OpenListenSocket bind failed.");
+        exitcode = -4;
+        goto exitlabel;
+    }
+
+    /**
+     * 开始监听。
+    */
+    r = listen(sockfd, pprofile->backlog);
+    if (r != 0)
+    {
+        XMNLogInfo(XMN_LOG_EMERG, errno, "OpenListenSocket listen failed.");
+        exitcode = -5;
+        goto exitlabel;
+    }
+
+    /**
+     * 将 port 和 soket 插入 vector 中。
+    */
+    {
         XMNListenSockInfo *pitem = new XMNListenSockInfo();
-        pitem->fd = psocksum[i];
-        pitem->port = vportsum_[i];
+        pitem->family = AF_INET;
+        pitem->fd = sockfd;
+        pitem->port = kPort;
+        pitem->workerindex = kWorkerIndex;
+        pitem->pprofile = pprofile;
         pitem->pconnsockinfo = nullptr;
         vlistenportsockinfolist_.push_back(pitem);
+    }
 
-        XMNLogInfo(XMN_LOG_INFO, 0, "监听端口 %d 的socket 创建成功！", vportsum_[i]);
+    if (kWorkerIndex >= 0)
+    {
+        XMNLogInfo(XMN_LOG_INFO, 0, "监听端口 %d 的 socket（worker %d 独占）创建成功！", kPort, kWorkerIndex);
     }
-    return 0;
+    else
+    {
+        XMNLogInfo(XMN_LOG_INFO, 0, "监听端口 %d 的socket 创建成功！", kPort);
+    }
+    return sockfd;
 
 exitlabel:
-    for (size_t i = 0; i < listenport_count_; i++)
+    close(sockfd);
+    return exitcode;
+}
+
+int XMNSocket::OpenUnixListenSocket(const std::string &kstrPath, const XMNSocketProfile *pprofile)
+{
+    int exitcode = 0;
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(struct sockaddr_un));
+    addr.sun_family = AF_UNIX;
+    if (kstrPath.size() >= sizeof(addr.sun_path))
+    {
+        XMNLogInfo(XMN_LOG_EMERG, 0, "OpenUnixListenSocket path %s is too long.", kstrPath.c_str());
+        return -4;
+    }
+    memcpy(addr.sun_path, kstrPath.c_str(), kstrPath.size());
+
+    int sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sockfd < 0)
     {
-        close(psocksum[i]);
+        XMNLogInfo(XMN_LOG_EMERG, errno, "OpenUnixListenSocket create listen socket failed.");
+        return -1;
     }
-    delete[] psocksum;
-    psocksum = nullptr;
+
+    /**
+     * Unix 域 socket 没有 TCP 的选项，只设置缓冲区的大小。
+    */
+    if ((pprofile->sendbuf > 0 && setsockopt(sockfd, SOL_SOCKET, SO_SNDBUF, (const void *)&pprofile->sendbuf, sizeof(int)) != 0) ||
+        (pprofile->recvbuf > 0 && setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, (const void *)&pprofile->recvbuf, sizeof(int)) != 0))
+    {
+        XMNLogInfo(XMN_LOG_EMERG, errno, "OpenUnixListenSocket setsockopt of socket profile %s failed.", pprofile->name.c_str());
+        exitcode = -2;
+        goto exitlabel;
+    }
+
+    if (SetNonBlocking(sockfd) != 0)
+    {
+        XMNLogInfo(XMN_LOG_EMERG, errno, "OpenUnixListenSocket SetNonBlocking failed.");
+        exitcode = -3;
+        goto exitlabel;
+    }
+
+    /**
+     * 上次运行残留的 socket 文件会导致 bind 失败，先删除。
+    */
+    unlink(kstrPath.c_str());
+    if (bind(sockfd, (struct sockaddr *)&addr, sizeof(struct sockaddr_un)) != 0)
+    {
+        XMNLogInfo(XMN_LOG_EMERG, errno, "OpenUnixListenSocket bind %s failed.", kstrPath.c_str());
+        exitcode = -4;
+        goto exitlabel;
+    }
+
+    if (listen(sockfd, pprofile->backlog) != 0)
+    {
+        XMNLogInfo(XMN_LOG_EMERG, errno, "OpenUnixListenSocket listen failed.");
+        exitcode = -5;
+        goto exitlabel;
+    }
+
+    {
+        XMNListenSockInfo *pitem = new XMNListenSockInfo();
+        pitem->family = AF_UNIX;
+        pitem->fd = sockfd;
+        pitem->port = 0;
+        pitem->path = kstrPath;
+        pitem->workerindex = -1;
+        pitem->pprofile = pprofile;
+        pitem->pconnsockinfo = nullptr;
+        vlistenportsockinfolist_.push_back(pitem);
+    }
+    XMNLogInfo(XMN_LOG_INFO, 0, "监听 Unix 域 socket %s 创建成功！", kstrPath.c_str());
+    return sockfd;
+
+exitlabel:
+    close(sockfd);
     return exitcode;
 }
 
+int XMNSocket::AttachReusePortCpuProgram(const int &kSockFd)
+{
+    /**
+     * A = 当前处理该数据包的 CPU 编号；
+     * A = A % worker 进程数量；
+     * return A ，即：reuseport 组中 socket 的下标。
+     * 下标只在所有 worker 进程都存活时与 worker 编号一致：某个 worker 退出后，其 socket 被关闭，
+     * 内核将组中最后一个 socket 移到空出的位置，此后部分 CPU 上的连接会被分配给其他 worker ，
+     * 下标超出组的大小时由内核按照哈希分配。连接仍然只会分配给存活的 worker ，只是不再按 CPU 对应。
+    */
+    struct sock_filter code[] = {
+        {BPF_LD | BPF_W | BPF_ABS, 0, 0, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU)},
+        {BPF_ALU | BPF_MOD | BPF_K, 0, 0, (uint32_t)worker_process_count_},
+        {BPF_RET | BPF_A, 0, 0, 0},
+    };
+    struct sock_fprog prog;
+    prog.len = sizeof(code) / sizeof(struct sock_filter);
+    prog.filter = code;
+
+    return setsockopt(kSockFd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, (const void *)&prog, sizeof(prog));
+}
+
 int XMNSocket::CloseListenSocket()
 {
     for (const auto &x : vlistenportsockinfolist_)
     {
         close(x->fd);
+        if (x->family == AF_UNIX)
+        {
+            unlink(x->path.c_str());
+            XMNLogInfo(XMN_LOG_INFO, 0, "监听 Unix 域 socket %s 已经关闭！", x->path.c_str());
+            continue;
+        }
         XMNLogInfo(XMN_LOG_INFO, 0, "监听端口 %d 的 socket 已经关闭！", x->port);
     }
     return 0;
 }
 
+int XMNSocket::CloseWorkerListenSocket(const int &kWorkerIndex)
+{
+    std::vector<XMNListenSockInfo *>::iterator it;
+    for (it = vlistenportsockinfolist_.begin(); it != vlistenportsockinfolist_.end();)
+    {
+        /**
+         * 共享的监听 socket 以及本进程独占的监听 socket 保留。
+        */
+        if ((*it)->workerindex < 0 || (*it)->workerindex == kWorkerIndex)
+        {
+            ++it;
+            continue;
+        }
+        close((*it)->fd);
+        delete *it;
+        it = vlistenportsockinfolist_.erase(it);
+    }
+
+    /**
+     * UDP socket 总是每个 worker 进程独占一个。
+    */
+    for (size_t i = 0; i < vudpsockfd_.size(); ++i)
+    {
+        if ((int)i != kWorkerIndex && vudpsockfd_[i] != -1)
+        {
+            close(vudpsockfd_[i]);
+            vudpsockfd_[i] = -1;
+        }
+    }
+    return 0;
+}
+
 int XMNSocket::SetNonBlocking(const int &sockfd)
 {
     int setnoblock = 1;
@@ -313,8 +677,11 @@ int XMNSocket::ReadConf()
     std::string str = "";
     std::stringstream s;
     int portcount = listenport_count_;
+    std::vector<size_t> vportconfindex;
     for (size_t i = 0; i < portcount; ++i)
     {
+        s.clear();
+        s.str("");
         s << i;
         str = "ListenPort" + s.str();
         int tmp = std::stoi(config.GetConfigItem(str));
@@ -324,8 +691,7 @@ int XMNSocket::ReadConf()
             continue;
         }
         vportsum_.push_back(tmp);
-        s.clear();
-        s.str("");
+        vportconfindex.push_back(i);
     }
     if (listenport_count_ == 0)
     {
@@ -342,79 +708,436 @@ int XMNSocket::ReadConf()
     }
 
     /**
-     * （4）获取连接回收的等待时间。
-    */
-    recyconnsockinfowaittime_ = std::stoi(config.GetConfigItem("RecyConnSockInfoWaitTime", "60"));
-    if (recyconnsockinfowaittime_ <= 0)
-    {
-        return -4;
-    }
-
-    /**
-     * （5）是否开启心跳监控。
+     * （4）是否开启心跳监控。
     */
     pingenable_ = std::stoi(config.GetConfigItem("PingEnable", "0"));
     if (pingenable_ <= 0)
     {
-        return -5;
+        return -4;
     }
 
     /**
-     * （6）心跳间隔时间。
+     * （5）心跳间隔时间。
     */
     pingwaittime_ = std::stoi(config.GetConfigItem("PingWaitTime", "30"));
     if (pingwaittime_ <= 0)
     {
-        return -6;
+        return -5;
     }
     pingwaittime_ = pingwaittime_ >= 5 ? pingwaittime_ : 5;
 
     /**
-     * （7）Flood 攻击检测是否开启的标志。
+     * （6）Flood 攻击检测是否开启的标志。
     */
     floodattackmonitorenable_ = std::stoi(config.GetConfigItem("FloodAttackMonitorEnable", "0"));
     if (floodattackmonitorenable_ <= 0)
     {
-        return -7;
+        return -6;
     }
 
     /**
-     * （8）相邻两次接收到数据包的最小时间间隔。
+     * （7）相邻两次接收到数据包的最小时间间隔。
     */
     floodtimeinterval_ = std::stoi(config.GetConfigItem("FloodTimeInterval", "100"));
     if (floodtimeinterval_ <= 0)
     {
-        return -8;
+        return -7;
     }
 
     /**
-     * （9）允许连续恶意包的最小数量。
+     * （8）允许连续恶意包的最小数量。
     */
     floodcount_ = std::stoi(config.GetConfigItem("FloodCount", "10"));
     if (floodcount_ <= 0)
     {
-        return -9;
+        return -8;
+    }
+
+    /**
+     * （9）是否开启 epoll 的边缘触发模式。
+    */
+    epolletenable_ = std::stoi(config.GetConfigItem("EpollEtEnable", "0")) > 0;
+
+    /**
+     * （10）worker 进程的数量以及是否为每个 worker 进程创建独占的 SO_REUSEPORT 监听 socket 。
+    */
+    worker_process_count_ = std::stoi(config.GetConfigItem("WorkerProcesses", "4"));
+    if (worker_process_count_ <= 0)
+    {
+        return -10;
+    }
+    reuseportenable_ = std::stoi(config.GetConfigItem("ReusePortEnable", "0")) > 0;
+    reuseportcpusteering_ = reuseportenable_ && (std::stoi(config.GetConfigItem("ReusePortCpuSteering", "0")) > 0);
+
+    /**
+     * CPU 分配策略要求 worker n 绑定在 CPU n 上，worker 进程的数量与在线的 CPU 数量不相等时，
+     * 某些 CPU 上没有 worker 进程，或者 CPU k 上收到的连接会被分配给不在 CPU k 上的 worker ，故不启用。
+    */
+    if (reuseportcpusteering_ && worker_process_count_ != (size_t)sysconf(_SC_NPROCESSORS_ONLN))
+    {
+        XMNLogStdErr(0, "worker 进程的数量（%d）与在线的 CPU 数量（%d）不相等，不启用 ReusePortCpuSteering 。",
+                     (int)worker_process_count_, (int)sysconf(_SC_NPROCESSORS_ONLN));
+        reuseportcpusteering_ = false;
+    }
+
+    /**
+     * （11）accept 负载均衡的方式以及暂停 accept 的在线人数的比例。
+     * 每个 worker 进程独占监听 socket 时，连接由内核分配，暂停 accept 只会使连接堆积在本进程的队列中，故不启用。
+    */
+    if (!reuseportenable_)
+    {
+        acceptbalancemode_ = std::stoi(config.GetConfigItem("AcceptBalanceMode", "0"));
+        if (acceptbalancemode_ < XMN_ACCEPT_BALANCE_NONE || acceptbalancemode_ > XMN_ACCEPT_BALANCE_MUTEX)
+        {
+            return -11;
+        }
+        int acceptstoppercent = std::stoi(config.GetConfigItem("AcceptStopPercent", "0"));
+        if (acceptstoppercent < 0 || acceptstoppercent > 100)
+        {
+            return -11;
+        }
+        if (acceptstoppercent > 0)
+        {
+            acceptstopcount_ = (size_t)worker_connection_count_ * acceptstoppercent / 100;
+            acceptresumecount_ = acceptstopcount_ - acceptstopcount_ / 32;
+        }
+        acceptmutexdelay_ = std::stoi(config.GetConfigItem("AcceptMutexDelay", "500"));
+        if (acceptmutexdelay_ <= 0)
+        {
+            return -11;
+        }
+    }
+
+    /**
+     * （12）事件后端的类型以及 io_uring 后端的参数。
+     * provided buffer ring 中缓冲区的数量必须是 2 的幂。
+    */
+    eventbackend_ = std::stoi(config.GetConfigItem("EventBackend", "0"));
+    if (eventbackend_ != XMN_EVENT_BACKEND_EPOLL && eventbackend_ != XMN_EVENT_BACKEND_URING)
+    {
+        return -12;
+    }
+    uringentries_ = std::stoi(config.GetConfigItem("UringEntries", "1024"));
+    uringrecvbuffcount_ = std::stoi(config.GetConfigItem("UringRecvBuffCount", "1024"));
+    uringrecvbuffsize_ = std::stoi(config.GetConfigItem("UringRecvBuffSize", "4096"));
+    if (uringentries_ == 0 || uringrecvbuffsize_ == 0 ||
+        uringrecvbuffcount_ == 0 || uringrecvbuffcount_ > 32768 ||
+        (uringrecvbuffcount_ & (uringrecvbuffcount_ - 1)) != 0)
+    {
+        return -12;
+    }
+
+    /**
+     * （13）每个连接的接收缓冲区的大小。
+     * 必须是 2 的幂，且至少能够容纳一个最大的包。
+    */
+    recvbuffsize_ = std::stoi(config.GetConfigItem("RecvBuffSize", "16384"));
+    if (recvbuffsize_ < PKG_MAX_LEN || (recvbuffsize_ & (recvbuffsize_ - 1)) != 0)
+    {
+        return -13;
+    }
+
+    /**
+     * （14）零拷贝发送的开关以及使用零拷贝的阈值。
+     * 内核为每次零拷贝发送锁定页面并产生完成通知，数据量太小时反而不如直接拷贝。
+    */
+    sendzerocopyenable_ = std::stoi(config.GetConfigItem("SendZeroCopyEnable", "0")) > 0;
+    sendzerocopythreshold_ = std::stoi(config.GetConfigItem("SendZeroCopyThreshold", "16384"));
+    if (sendzerocopyenable_ && sendzerocopythreshold_ == 0)
+    {
+        return -14;
+    }
+
+    /**
+     * （15）业务逻辑线程是否直接发送数据。
+    */
+    senddirectenable_ = std::stoi(config.GetConfigItem("SendDirectEnable", "0")) > 0;
+
+    /**
+     * （16）发送数据线程的数量。
+    */
+    int sendthreadcount = std::stoi(config.GetConfigItem("SendThreadCount", "1"));
+    if (sendthreadcount <= 0)
+    {
+        return -16;
+    }
+    sendthreadcount_ = sendthreadcount;
+
+    /**
+     * （17）reactor 线程的数量以及新连接的分配方式。
+     * 为 0 时所有的连接都由主事件循环处理；否则主事件循环只负责 accept 和定时器，
+     * 连接分配给各个 reactor 线程，由其各自的事件后端处理。
+    */
+    int reactorthreadcount = std::stoi(config.GetConfigItem("ReactorThreadCount", "0"));
+    reactordispatchmode_ = std::stoi(config.GetConfigItem("ReactorDispatchMode", "0"));
+    if (reactorthreadcount < 0 || reactorthreadcount > UINT16_MAX - 1 ||
+        (reactordispatchmode_ != XMN_REACTOR_DISPATCH_ROUNDROBIN && reactordispatchmode_ != XMN_REACTOR_DISPATCH_LEASTCONN))
+    {
+        return -17;
+    }
+    reactorthreadcount_ = reactorthreadcount;
+
+    /**
+     * （18）忙轮询：取到事件之后自旋的时间（us），以及为新连接设置的 SO_BUSY_POLL（us）。
+     * 用空闲时的 CPU 换取更低的唤醒延迟，空闲超过自旋时间之后恢复堵塞等待。
+    */
+    int busypollspinus = std::stoi(config.GetConfigItem("BusyPollSpinUs", "0"));
+    busypollsocketus_ = std::stoi(config.GetConfigItem("BusyPollSocketUs", "0"));
+    if (busypollspinus < 0 || busypollsocketus_ < 0)
+    {
+        return -18;
+    }
+    busypollspinns_ = (uint64_t)busypollspinus * 1000;
+
+    /**
+     * （19）各个监听端口使用的 socket 配置方案，ListenProfileN 与 ListenPortN 对应，不配置时使用缺省的方案。
+    */
+    for (const auto &x : vportconfindex)
+    {
+        /**
+         * 配置文件读取时行尾的空白字符被替换成了 '\0' ，这里截掉。
+        */
+        std::string strname = config.GetConfigItem("ListenProfile" + std::to_string(x), "").c_str();
+        int index = ReadSocketProfile(strname);
+        if (index < 0)
+        {
+            XMNLogStdErr(0, "socket 配置方案 %s 中的选项非法。", strname.c_str());
+            return -19;
+        }
+        vportprofile_.push_back(index);
+    }
+
+    /**
+     * （20）Unix 域监听 socket ，供同一台主机上的 client 使用，与 TCP 端口采用相同的协议和处理函数。
+    */
+    int unixlistencount = std::stoi(config.GetConfigItem("UnixListenCount", "0"));
+    if (unixlistencount < 0)
+    {
+        return -20;
+    }
+    for (int i = 0; i < unixlistencount; ++i)
+    {
+        std::string strpath = config.GetConfigItem("UnixListenPath" + std::to_string(i), "").c_str();
+        if (strpath.empty())
+        {
+            return -20;
+        }
+        std::string strname = config.GetConfigItem("UnixListenProfile" + std::to_string(i), "").c_str();
+        int index = ReadSocketProfile(strname);
+        if (index < 0)
+        {
+            XMNLogStdErr(0, "socket 配置方案 %s 中的选项非法。", strname.c_str());
+            return -20;
+        }
+        vunixpath_.push_back(strpath);
+        vunixprofile_.push_back(index);
+    }
+
+    /**
+     * （21）接收 UDP 心跳的端口，0 表示不开启。
+    */
+    int udpport = std::stoi(config.GetConfigItem("UdpPingPort", "0"));
+    if (udpport < 0 || udpport > 65535)
+    {
+        return -21;
+    }
+    udpport_ = udpport;
+
+    /**
+     * （22）扩展包头允许的最大包体长度，0 表示不接收扩展包头。
+    */
+    long long pkgmaxbodylen = std::stoll(config.GetConfigItem("PkgMaxBodyLen", "16777216"));
+    if (pkgmaxbodylen < 0 || pkgmaxbodylen > (long long)UINT32_MAX)
+    {
+        return -22;
+    }
+    pkgmaxbodylen_ = pkgmaxbodylen;
+
+    /**
+     * （23）流式发送的高水位和低水位，高水位一般与 socket 的发送缓冲区相当。
+     * 待发送的字节数用 32 位记录，高水位不能超过 64 MB 。
+    */
+    streamhighwater_ = std::stoi(config.GetConfigItem("StreamSendHighWater", "262144"));
+    streamlowwater_ = std::stoi(config.GetConfigItem("StreamSendLowWater", "65536"));
+    if (streamlowwater_ >= streamhighwater_ || streamhighwater_ > ((size_t)64 << 20))
+    {
+        return -23;
+    }
+
+    /**
+     * （24）背压：连接或者 worker 进程的积压达到高水位时暂停连接的接收，降到低水位以下时恢复。
+     * 每一对水位都要求低水位小于高水位。
+    */
+    backpressureenable_ = std::stoi(config.GetConfigItem("BackpressureEnable", "1")) != 0;
+    connrecvhighwater_ = std::stoi(config.GetConfigItem("ConnRecvHighWater", "256"));
+    connrecvlowwater_ = std::stoi(config.GetConfigItem("ConnRecvLowWater", "64"));
+    connsendhighwater_ = std::stoi(config.GetConfigItem("ConnSendHighWater", "1048576"));
+    connsendlowwater_ = std::stoi(config.GetConfigItem("ConnSendLowWater", "262144"));
+    recvqueuehighwater_ = std::stoi(config.GetConfigItem("RecvQueueHighWater", "100000"));
+    recvqueuelowwater_ = std::stoi(config.GetConfigItem("RecvQueueLowWater", "50000"));
+    sendqueuehighwater_ = std::stoi(config.GetConfigItem("SendQueueHighWater", "40000"));
+    sendqueuelowwater_ = std::stoi(config.GetConfigItem("SendQueueLowWater", "20000"));
+    if (connrecvlowwater_ >= connrecvhighwater_ ||
+        connsendlowwater_ >= connsendhighwater_ || connsendhighwater_ > ((size_t)64 << 20) ||
+        recvqueuelowwater_ >= recvqueuehighwater_ ||
+        sendqueuelowwater_ >= sendqueuehighwater_)
+    {
+        return -24;
+    }
+
+    /**
+     * 开启背压时，暂停接收之后已经收到的数据仍会被解析：epoll 后端最多为两次 recv 的数据，
+     * io_uring 后端撤销 multishot recv 之前已经完成的数据最多占满所有的接收缓冲区。
+     * 按每个包只有包头、每次 recv 最多多产生 2 个数据块估算这部分数据产生的回复和大包的数据块，
+     * 在此基础上留出余量，遵守流量控制的连接不会因为积压过多而被断开。
+    */
+    sendmaxpendingmsgs_ = XMN_SEND_MAX_PENDING_MSGS;
+    streammaxpendingchunks_ = XMN_STREAM_MAX_PENDING_CHUNKS;
+    if (backpressureenable_)
+    {
+        size_t inflightlen = 2 * recvbuffsize_;
+        size_t inflightchunks = 2 * (recvbuffsize_ / XMN_STREAM_CHUNK_SIZE + 2);
+        if (eventbackend_ == XMN_EVENT_BACKEND_URING)
+        {
+            inflightlen += uringrecvbuffcount_ * uringrecvbuffsize_;
+            inflightchunks += uringrecvbuffcount_ * (uringrecvbuffsize_ / XMN_STREAM_CHUNK_SIZE + 2);
+        }
+        sendmaxpendingmsgs_ += connrecvhighwater_ + inflightlen / kPkgHeaderLen_;
+        streammaxpendingchunks_ += inflightchunks;
+    }
+
+    /**
+     * （25）进入 EBR 临界区的线程：业务逻辑线程、发送数据线程、reactor 线程以及主事件循环，
+     * 每个线程占用一个槽，超过 XMN_EPOCH_MAX_THREADS 时多出的线程没有保护，连接可能在使用中被回收，故不允许启动。
+    */
+    const size_t kEpochThreadCount = std::stoi(config.GetConfigItem("ThreadPoolSize", "100")) + sendthreadcount_ + reactorthreadcount_ + 1;
+    if (kEpochThreadCount > XMN_EPOCH_MAX_THREADS)
+    {
+        XMNLogStdErr(0, "ThreadPoolSize + SendThreadCount + ReactorThreadCount + 1（%d）超过了 %d 。",
+                     (int)kEpochThreadCount, XMN_EPOCH_MAX_THREADS);
+        return -25;
     }
 
     return 0;
 }
 
-int XMNSocket::EpollInit()
+int XMNSocket::ReadSocketProfile(const std::string &kstrName)
 {
+    for (size_t i = 0; i < vsocketprofile_.size(); ++i)
+    {
+        if (vsocketprofile_[i].name == kstrName)
+        {
+            return i;
+        }
+    }
+
     /**
-     * （1）创建 epoll 对象。
+     * 缺省的方案不读取配置文件，与之前的行为一致。
     */
-    epoll_handle_ = epoll_create(worker_connection_count_);
-    if (epoll_handle_ <= 0)
+    XMNSocketProfile profile;
+    profile.name = kstrName;
+    profile.backlog = XMN_LISTEN_BACKLOG;
+    profile.fastopen = 0;
+    profile.deferaccept = 0;
+    profile.sendbuf = 0;
+    profile.recvbuf = 0;
+    profile.nodelay = 0;
+    profile.notsentlowat = 0;
+    profile.keepalive = 0;
+    profile.keepidle = 0;
+    profile.keepintvl = 0;
+    profile.keepcnt = 0;
+    if (!kstrName.empty())
+    {
+        XMNConfig &config = SingletonBase<XMNConfig>::GetInstance();
+        const std::string kstrPrefix = kstrName + ".";
+        profile.backlog = std::stoi(config.GetConfigItem(kstrPrefix + "Backlog", std::to_string(XMN_LISTEN_BACKLOG)));
+        profile.fastopen = std::stoi(config.GetConfigItem(kstrPrefix + "FastOpen", "0"));
+        profile.deferaccept = std::stoi(config.GetConfigItem(kstrPrefix + "DeferAccept", "0"));
+        profile.sendbuf = std::stoi(config.GetConfigItem(kstrPrefix + "SendBuf", "0"));
+        profile.recvbuf = std::stoi(config.GetConfigItem(kstrPrefix + "RecvBuf", "0"));
+        profile.nodelay = std::stoi(config.GetConfigItem(kstrPrefix + "NoDelay", "0"));
+        profile.notsentlowat = std::stoi(config.GetConfigItem(kstrPrefix + "NotSentLowat", "0"));
+        profile.keepalive = std::stoi(config.GetConfigItem(kstrPrefix + "KeepAlive", "0"));
+        profile.keepidle = std::stoi(config.GetConfigItem(kstrPrefix + "KeepIdle", "0"));
+        profile.keepintvl = std::stoi(config.GetConfigItem(kstrPrefix + "KeepIntvl", "0"));
+        profile.keepcnt = std::stoi(config.GetConfigItem(kstrPrefix + "KeepCnt", "0"));
+    }
+    if (profile.backlog <= 0 || profile.fastopen < 0 || profile.deferaccept < 0 ||
+        profile.sendbuf < 0 || profile.recvbuf < 0 || profile.notsentlowat < 0 ||
+        profile.keepidle < 0 || profile.keepintvl < 0 || profile.keepcnt < 0)
     {
-        XMNLogStdErr(errno, "EpollInit 中的 epoll_create()执行失败！");
         return -1;
     }
+    vsocketprofile_.push_back(profile);
+    return vsocketprofile_.size() - 1;
+}
+
+XMNEventBackend *XMNSocket::CreateEventBackend()
+{
+    XMNEventBackend *peventbackend = nullptr;
+    if (eventbackend_ == XMN_EVENT_BACKEND_URING)
+    {
+        peventbackend = new XMNUringBackend(uringentries_, uringrecvbuffcount_, uringrecvbuffsize_);
+        if (peventbackend->Init() != 0)
+        {
+            XMNLogInfo(XMN_LOG_WARN, 0, "CreateEventBackend 中 io_uring 后端初始化失败，改用 epoll 后端。");
+            delete peventbackend;
+            peventbackend = nullptr;
+            eventbackend_ = XMN_EVENT_BACKEND_EPOLL;
+        }
+    }
+    if (peventbackend == nullptr)
+    {
+        peventbackend = new XMNEpollBackend(worker_connection_count_);
+        if (peventbackend->Init() != 0)
+        {
+            XMNLogStdErr(errno, "CreateEventBackend 中的事件后端初始化失败！");
+            delete peventbackend;
+            return nullptr;
+        }
+    }
+    return peventbackend;
+}
+
+int XMNSocket::EpollInit()
+{
+    /**
+     * （1）为主事件循环和每个 reactor 线程创建事件后端，io_uring 不可用（内核版本过低、被禁用等）时退回到 epoll 。
+    */
+    for (size_t i = 0; i <= reactorthreadcount_; ++i)
+    {
+        Reactor *preactor = new Reactor(this, i);
+        vreactor_.push_back(preactor);
+        preactor->peventbackend_ = CreateEventBackend();
+        if (preactor->peventbackend_ == nullptr)
+        {
+            return -1;
+        }
+    }
+    XMNLogInfo(XMN_LOG_NOTICE, 0, "worker 进程使用的事件后端为 %s ，reactor 线程 %d 个。",
+               vreactor_[0]->peventbackend_->Name(), (int)reactorthreadcount_);
+
+    /**
+     * 零拷贝发送的完成通知通过 EPOLLERR 读取，io_uring 后端中没有该事件。
+    */
+    if (sendzerocopyenable_ && eventbackend_ == XMN_EVENT_BACKEND_URING)
+    {
+        XMNLogInfo(XMN_LOG_WARN, 0, "EpollInit 中 io_uring 后端不支持零拷贝发送，已关闭零拷贝发送。");
+        sendzerocopyenable_ = false;
+    }
 
     /**
      * （2）连接池初始化。
+     * 关闭的连接要等到没有线程能够访问时才会被重新使用，所以槽的数量为最大连接数的两倍，
+     * 另外再加上监听 socket 、定时器、UDP socket 以及唤醒 reactor 线程的 eventfd 使用的连接。
     */
-    //InitConnSockInfoPool();
+    if (SingletonBase<XMNConnSlotTable>::GetInstance().Create((size_t)worker_connection_count_ * 2 + vlistenportsockinfolist_.size() + 2 + reactorthreadcount_) != 0)
+    {
+        XMNLogStdErr(0, "EpollInit 中创建连接槽表失败，WorkerConnections 过大。");
+        return -5;
+    }
+    SingletonBase<XMNRingBufferPool>::GetInstance().Init(recvbuffsize_);
 
     /**
      * （2）创建指定数量的连接池和空闲连接的单向链表。
@@ -451,7 +1174,15 @@ int XMNSocket::EpollInit()
     */
 
     /**
-     * （3）循环遍历所有监听 socket ，为每个 socket 绑定一个连接池中的连接，用于记录相关信息。
+     * （3）关闭其他 worker 进程独占的监听 socket 和 UDP socket ，只保留共享的和本进程独占的。
+    */
+    if (reuseportenable_ || !vudpsockfd_.empty())
+    {
+        CloseWorkerListenSocket(g_xmn_worker_index);
+    }
+
+    /**
+     * （4）循环遍历所有监听 socket ，为每个 socket 绑定一个连接池中的连接，用于记录相关信息。
     */
     XMNConnSockInfo *pconnsockinfo = nullptr;
     for (auto &x : vlistenportsockinfolist_)
@@ -476,12 +1207,68 @@ int XMNSocket::EpollInit()
         */
         pconnsockinfo->r_ready = 1;
         pconnsockinfo->rhandler = &XMNSocket::EventAcceptHandler;
+    }
+
+    /**
+     * （5）将定时器时间轮的 timerfd 加入事件后端中，与 socket 的事件一起处理。
+    */
+    ptimerconnsockinfo_ = PutOutConnSockInfofromPool(timerwheel_.GetFd());
+    ptimerconnsockinfo_->rhandler = &XMNSocket::TimerRequestHandler;
+    if (vreactor_[0]->peventbackend_->AddReadableFd(timerwheel_.GetFd(), ptimerconnsockinfo_) != 0)
+    {
+        return -4;
+    }
+
+    /**
+     * 本 worker 进程的 UDP socket 同样由主事件循环处理。
+    */
+    if (!vudpsockfd_.empty())
+    {
+        pudpbatch_ = new UdpBatch();
+        pudpconnsockinfo_ = PutOutConnSockInfofromPool(vudpsockfd_[g_xmn_worker_index]);
+        pudpconnsockinfo_->rhandler = &XMNSocket::UdpRequestHandler;
+        if (vreactor_[0]->peventbackend_->AddReadableFd(vudpsockfd_[g_xmn_worker_index], pudpconnsockinfo_) != 0)
+        {
+            return -4;
+        }
+    }
 
-        if (EpollOperationEvent(x->fd,
-                                EPOLL_CTL_ADD,
-                                EPOLLIN | EPOLLRDHUP,
-                                0,
-                                pconnsockinfo) != 0)
+    /**
+     * （6）启动 reactor 线程，每个线程的 eventfd 加入其自己的事件后端中。
+     * 必须在开始 accept 之前完成，io_uring 后端据此判断提交请求的线程是否为其事件线程。
+    */
+    for (size_t i = 1; i < vreactor_.size(); ++i)
+    {
+        Reactor *preactor = vreactor_[i];
+        preactor->wakeupfd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (preactor->wakeupfd_ == -1)
+        {
+            XMNLogStdErr(errno, "EpollInit 中 eventfd 执行失败。");
+            return -6;
+        }
+        XMNConnSockInfo *pwakeupconnsockinfo = PutOutConnSockInfofromPool(preactor->wakeupfd_);
+        pwakeupconnsockinfo->reactorindex = (uint16_t)i;
+        pwakeupconnsockinfo->rhandler = &XMNSocket::ReactorWakeupHandler;
+        if (preactor->peventbackend_->AddReadableFd(preactor->wakeupfd_, pwakeupconnsockinfo) != 0)
+        {
+            return -6;
+        }
+        if (pthread_create(&preactor->threadhandle_, nullptr, ReactorThread, (void *)preactor) != 0)
+        {
+            XMNLogStdErr(0, "EpollInit 中 pthread_create 执行失败。");
+            preactor->threadhandle_ = 0;
+            return -6;
+        }
+        preactor->peventbackend_->SetEventThread(preactor->threadhandle_);
+    }
+
+    /**
+     * （7）将监听 socket 加入 epoll 中。
+     * 采用 accept 互斥量时，只有获取到互斥量的 worker 进程才将监听 socket 加入 epoll 中。
+    */
+    if (acceptbalancemode_ != XMN_ACCEPT_BALANCE_MUTEX)
+    {
+        if (EnableAcceptEvents() != 0)
         {
             return -3;
         }
@@ -568,14 +1355,15 @@ int XMNSocket::EpollOperationEvent(const int &kSockFd,
             /**
              * 删除该标记。
             */
-            ev.events ^= ~kFlag;
+            ev.events &= ~kEvents;
         }
         else if (kFlag == 2)
         {
             /**
              * 覆盖该标记。
+             * 连接注册时带有的 EPOLLET 需要保留，否则 ET 模式下修改事件后会退化为 LT 模式。
             */
-            ev.events = kFlag;
+            ev.events = kEvents | (pconnsockinfo->events & EPOLLET);
         }
         else
         {
@@ -594,12 +1382,11 @@ int XMNSocket::EpollOperationEvent(const int &kSockFd,
     }
 
     /**
-     * （2）epoll_ctl()函数的调用。
+     * （2）交由事件后端执行。
     */
-    ev.data.ptr = (void *)pconnsockinfo;
-    if (epoll_ctl(epoll_handle_, kOption, kSockFd, &ev) != 0)
+    if (EventBackend(pconnsockinfo)->Ctl(kSockFd, kOption, ev.events, pconnsockinfo) != 0)
     {
-        XMNLogStdErr(0, "XMNSocket::EpollOperationEvent 中 epoll_ctl 执行失败。");
+        XMNLogStdErr(0, "XMNSocket::EpollOperationEvent 中事件后端的 Ctl 执行失败。");
         return -2;
     }
 
@@ -607,16 +1394,46 @@ int XMNSocket::EpollOperationEvent(const int &kSockFd,
 }
 
 int XMNSocket::EpollProcessEvents(const int &kTimer)
+{
+    return ReactorProcessEvents(vreactor_[0], kTimer);
+}
+
+int XMNSocket::ReactorProcessEvents(Reactor *preactor, const int &kTimer)
 {
     int eventcount = 0;
+    XMNEventBackend *peventbackend = preactor->peventbackend_;
+    struct epoll_event *pwaitevents = preactor->wait_events_;
+
+    /**
+     * 忙轮询：距离上次取到事件不超过自旋时间时不堵塞，以超时时间 0 调用 Wait 。
+    */
+    int timer = kTimer;
+    uint64_t nowns = 0;
+    if (busypollspinns_ > 0)
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        nowns = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+        if (nowns - preactor->lastactivens_ < busypollspinns_)
+        {
+            timer = 0;
+        }
+    }
+
+    /**
+     * 事件线程在等待和处理事件期间处于 epoch 临界区中，期间取出的连接不会被归还至连接池。
+     * reactor 线程堵塞在 Wait 中时会阻止全局 epoch 的推进，有待回收的连接时由 WakeupReactors 唤醒。
+    */
+    XMNEpochGuard epochguard;
+
     /**
      * （1）取出发生的事件信息。
     */
     /**
      * @function    从双向链表中获取 XMN_EPOLL_WAIT_MAX_EVENTS 个 epoll_event 对象。
-     * @paras   epoll_handle_ epoll 对象，相当于事件代理。
-     *          wait_events_   epoll_event 对象存储池。
-     *          XMN_EPOLL_WAIT_MAX_EVENTS   wait_events_ 大小。
+     * @paras   peventbackend 事件后端（epoll 或者 io_uring），相当于事件代理。
+     *          pwaitevents   epoll_event 对象存储池。
+     *          XMN_EPOLL_WAIT_MAX_EVENTS   pwaitevents 大小。
      *          timer   超时时间，若为-1，则一直堵塞，直至有事件到来。
      * @ret  > 0  实际返回的 epoll_event 对象的数量，即：事件的数量。
      *          = 0  等待超时。
@@ -626,12 +1443,39 @@ int XMNSocket::EpollProcessEvents(const int &kTimer)
      * （2）有事件发生。
      * （3）有信号发生。                                                                 
     */
-    eventcount = epoll_wait(epoll_handle_, wait_events_, XMN_EPOLL_WAIT_MAX_EVENTS, kTimer);
+    eventcount = peventbackend->Wait(pwaitevents, XMN_EPOLL_WAIT_MAX_EVENTS, timer);
+    if (busypollspinns_ > 0)
+    {
+        if (timer == 0 && kTimer != 0)
+        {
+            ++preactor->spinpollcount_;
+            if (eventcount > 0)
+            {
+                ++preactor->spinhitcount_;
+            }
+        }
+        else
+        {
+            ++preactor->blockwaitcount_;
+        }
+        /**
+         * 堵塞等待返回时 nowns 已经过时，重新取时间。
+        */
+        if (eventcount > 0)
+        {
+            if (timer != 0)
+            {
+                struct timespec ts;
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                nowns = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+            }
+            preactor->lastactivens_ = nowns;
+        }
+    }
 
     /**
-     * TODO：这里有惊群效应，后续对该问题进行处理。
-     * 由于多个进程同时监控 port ，导致客户端来了连接，多个进程的 epoll_wait 会部分返回，
-     * 然后只有一个进程的 accept 会获取到该连接，其他的进程白走一遭，浪费了 CPU 资源。
+     * 多个 worker 进程监听同一个 port 时的惊群问题，由 ReusePortEnable（每个 worker 独占监听 socket ），
+     * 或者 AcceptBalanceMode（EPOLLEXCLUSIVE 或 accept 互斥量）处理，见 EnableAcceptEvents 以及 ProcessAcceptBalance 。
     */
 
     /**
@@ -660,8 +1504,9 @@ int XMNSocket::EpollProcessEvents(const int &kTimer)
     {
         /**
          * 正常超时返回。
+         * io_uring 后端中取到的完成事件可能全部被过滤掉（过期、被撤销等），此时也返回 0 。
         */
-        if (kTimer != -1)
+        if (timer != -1 || eventbackend_ == XMN_EVENT_BACKEND_URING)
         {
             return 0;
         }
@@ -681,52 +1526,41 @@ int XMNSocket::EpollProcessEvents(const int &kTimer)
     /**
      * 执行到这里说明收到了事件。
     */
+    XMNConnSlotTable &slottable = SingletonBase<XMNConnSlotTable>::GetInstance();
     XMNConnSockInfo *pconnsockinfo = nullptr;
     uint32_t eventstmp;
-    //int instance = 0;
     for (size_t i = 0; i < eventcount; ++i)
     {
         /**
-         *  获取该事件对应的连接的相关信息。
-        */
-        pconnsockinfo = (XMNConnSockInfo *)((wait_events_ + i)->data.ptr);
-
-        /*
-        instance = (uintptr_t)pconnsockinfo & 1;
-        pconnsockinfo = (XMNConnSockInfo *)((uintptr_t)pconnsockinfo & (uintptr_t)~1);
-        */
-        /**
-         * 处理过期事件。
+         *  根据事件中的句柄获取对应的连接，同时过滤掉过期事件。
+         *  例如：同一批事件中，第 1 个事件关闭了连接，之后该连接的事件都是过期事件；
+         *  即使该连接的槽已经被新的连接使用，代数也不会相同。
         */
-        /*
-        if (pconnsockinfo->fd == -1)
-        {
-            //来了3个事件，
-            //第1个事件关闭连接，fd == -1 。
-            //第2个事件正常处理。
-            //第3个事件则是第1个连接的事件，为过期事件。
-            XMNLogInfo(XMN_LOG_DEBUG, 0, "EpollProcessEvents 遇到了 fd == -1 的过期事件 %p", pconnsockinfo);
-            continue;
-        }
-        
-        if (pconnsockinfo->instance != instance)
+        pconnsockinfo = slottable.Get(pwaitevents[i].data.u64);
+        if (pconnsockinfo == nullptr)
         {
-            //来了3个事件。
-            //第1个事件关闭连接，fd == -1。
-            //第2个事件建立连接，该新连接恰好用到了线程池中第1个事件释放的连接。
-            //第3个事件是第1个事件对应的连接的事件，为过期事件。
-            //判断的原理就是每次从连接池中获取连接时，instance 都会取反。
-            XMNLogInfo(XMN_LOG_DEBUG, 0, "EpollProcessEvents 遇到了 instance 改变的过期事件 %p", pconnsockinfo);
+            XMNLogInfo(XMN_LOG_DEBUG, 0, "EpollProcessEvents 遇到了过期事件，槽 %ud ，代数 %ud 。",
+                       (uint32_t)(pwaitevents[i].data.u64 >> 32), (uint32_t)pwaitevents[i].data.u64);
+            peventbackend->FinishEvent(i);
             continue;
         }
-        */
 
         /**
-         * 因为采用了延时回收连接的方案，所以该事件对应的连接肯定是原来的连接。
-         * 程序走到这里，可以认为事件是非过期事件。
          * 确定事件类型，根据不同的类型来调用不同的处理函数。
         */
-        eventstmp = wait_events_[i].events;
+        eventstmp = pwaitevents[i].events;
+
+        /**
+         * 零拷贝发送的完成通知放在 socket 的错误队列中，由 EPOLLERR 通知。
+         * 若读到了完成通知且连接并没有被挂起，则该 EPOLLERR 不是真正的错误。
+        */
+        if ((eventstmp & EPOLLERR) && pconnsockinfo->iszerocopy)
+        {
+            if (RecvZeroCopyCompletion(pconnsockinfo) > 0 && !(eventstmp & EPOLLHUP))
+            {
+                eventstmp &= ~EPOLLERR;
+            }
+        }
         /**
          * TODO：正常关闭连接，具体代码是不是这么写，后续确认！
         */
@@ -747,6 +1581,7 @@ int XMNSocket::EpollProcessEvents(const int &kTimer)
          * （3）对端正常关闭，执行的函数是 WaitReadRequestHandler，通过 recv 的返回值，即：0，来判断是否对端是否已经断开。
         */
         XMNLogInfo(XMN_LOG_ALERT, 0, (std::string("events = ") + std::to_string(eventstmp)).c_str());
+        peventbackend->PrepareEvent(i);
         if (eventstmp & EPOLLIN)
         {
             (this->*(pconnsockinfo->rhandler))(pconnsockinfo);
@@ -779,6 +1614,7 @@ int XMNSocket::EpollProcessEvents(const int &kTimer)
                 (this->*(pconnsockinfo->whandler))(pconnsockinfo);
             }
         }
+        peventbackend->FinishEvent(i);
     }
 
     return 0;
@@ -786,87 +1622,306 @@ int XMNSocket::EpollProcessEvents(const int &kTimer)
 
 int XMNSocket::PutInSendDataQueue(char *psenddata)
 {
-    XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
-    XMNLockMutex lockmutex_senddata(&senddata_queue_mutex_);
     XMNMsgHeader *pmsgheader = (XMNMsgHeader *)psenddata;
-    XMNConnSockInfo *pconnsockinfo = pmsgheader->pconnsockinfo;
+    XMNConnSockInfo *pconnsockinfo = GetConnSockInfo(pmsgheader->connhandle);
+    if (pconnsockinfo == nullptr)
+    {
+        ++discardsendpkgcount_;
+        XMNConnSockInfo::FreeSendDataMem(psenddata);
+        return -1;
+    }
+
+    {
+        XMNLockMutex sendmutex(&pconnsockinfo->sendmutex_);
+
+        /**
+         * （1）安全防范以及判断消息是否过期，加锁之后连接仍可能已经被关闭。
+        */
+        if (queue_senddata_count_ > 50000 || pconnsockinfo->Handle() != pmsgheader->connhandle)
+        {
+            ++discardsendpkgcount_;
+            pconnsockinfo->FreeSendDataMem(psenddata);
+            return -1;
+        }
+        if (pconnsockinfo->nosendmsgcount > sendmaxpendingmsgs_)
+        {
+            XMNLogStdErr(0, "XMNSocket::PutInSendDataQueue()发现某用户（%d）挤压了太多待发送的数据，需切断与他的连接！",
+                         pconnsockinfo->fd);
+            ++discardsendpkgcount_;
+            pconnsockinfo->FreeSendDataMem(psenddata);
+            goto lblclose;
+        }
+
+        /**
+         * （2）将消息放入该连接的待发送消息链表的尾部，保证同一个连接的消息按顺序发送。
+        */
+        ++pconnsockinfo->nosendmsgcount;
+        ++queue_senddata_count_;
+        pconnsockinfo->sendqueuebytes += ntohs(((XMNPkgHeader *)(psenddata + kMsgHeaderLen_))->pkglen);
+        pmsgheader->pnext = nullptr;
+        if (pconnsockinfo->psendqueuetail == nullptr)
+        {
+            pconnsockinfo->psendqueuehead = psenddata;
+        }
+        else
+        {
+            ((XMNMsgHeader *)pconnsockinfo->psendqueuetail)->pnext = psenddata;
+        }
+        pconnsockinfo->psendqueuetail = psenddata;
+
+        /**
+         * 回复积压过多时暂停该连接的接收，避免积压继续增长直至超过上限而断开连接。
+        */
+        if (backpressureenable_ && !pconnsockinfo->isrecvpaused)
+        {
+            PauseRecv(pconnsockinfo);
+        }
+
+        /**
+         * （3）该连接已经在发送连接队列中，或者正由 epoll 驱动发送时，消息会随链表一起发出。
+        */
+        if (pconnsockinfo->issendscheduled || pconnsockinfo->throwepollsendcount > 0)
+        {
+            return 0;
+        }
+
+        /**
+         * （4）链表中只有该消息时，直接在当前线程中发送，省去唤醒发送数据线程的开销。
+         * 发送在 sendmutex_ 的保护下进行，不会打乱该连接的消息的顺序。
+         * 没有发完的部分留在链表中，由 epoll 驱动发送。
+        */
+        if (senddirectenable_ && pconnsockinfo->psendqueuehead == psenddata)
+        {
+            if (FlushSendQueue(pconnsockinfo) == 1)
+            {
+                pconnsockinfo->throwepollsendcount = 1;
+                if (EpollOperationEvent(pconnsockinfo->fd, EPOLL_CTL_MOD, EPOLLOUT, 0, pconnsockinfo) != 0)
+                {
+                    XMNLogStdErr(0, "XMNSocket::PutInSendDataQueue()中执行EpollOperationEvent()失败。");
+                }
+            }
+            return 0;
+        }
+        pconnsockinfo->issendscheduled = true;
+    }
+
+    /**
+     * （5）将连接放入负责它的发送数据线程的发送连接队列中。
+    */
+    PutInSendShard(pconnsockinfo);
+    return 0;
+
+lblclose:
+    ActivelyCloseSocket(pconnsockinfo);
+    return -2;
+}
+
+void XMNSocket::PutInSendShard(XMNConnSockInfo *pconnsockinfo)
+{
+    SendShard *psendshard = vsendshard_[pconnsockinfo->sendshardindex];
+    bool iswakeup = false;
+    {
+        XMNLockMutex lockmutex_connqueue(&psendshard->connqueue_mutex_);
+        iswakeup = psendshard->connqueue_.empty();
+        psendshard->connqueue_.push_back(pconnsockinfo->Handle());
+    }
 
     /**
-     * 安全防范。
+     * 队列原本不为空时，发送数据线程必然还会再取一次队列，无需再次唤醒。
     */
-    if (queue_senddata_count_ > 50000)
+    if (iswakeup)
     {
-        ++discardsendpkgcount_;
-        pconnsockinfo->FreeSendDataMem(psenddata);
+        uint64_t wakeup = 1;
+        if (write(psendshard->eventfd_, &wakeup, sizeof(wakeup)) != sizeof(wakeup))
+        {
+            XMNLogStdErr(errno, "XMNSocket::PutInSendShard()中write(eventfd)执行失败。");
+        }
+    }
+}
+
+int XMNSocket::StartStreamWriter(const XMNConnHandle &kConnHandle, XMNStreamWriter *pwriter)
+{
+    XMNConnSockInfo *pconnsockinfo = GetConnSockInfo(kConnHandle);
+    if (pconnsockinfo == nullptr)
+    {
+        delete pwriter;
         return -1;
     }
-    if (pconnsockinfo->nosendmsgcount > 400)
+
+    /**
+     * 流式发送对象保存在冷数据中，由投递的内部消息驱动，同一时刻只有一个线程调用它。
+    */
+    XMNConnColdInfo *pcoldinfo = pconnsockinfo->GetColdInfo();
+    {
+        XMNLockMutex sendmutex(&pconnsockinfo->sendmutex_);
+        if (pcoldinfo->pstreamwriter != nullptr)
+        {
+            delete pwriter;
+            return -2;
+        }
+        pcoldinfo->pstreamwriter = pwriter;
+    }
+
+    /**
+     * 投递失败时没有任何消息会再调用该对象，直接释放。
+    */
+    if (PutInInnerMsg(pconnsockinfo, XMN_INNER_MSG_WRITABLE) != 0)
+    {
+        XMNLockMutex sendmutex(&pconnsockinfo->sendmutex_);
+        pcoldinfo->pstreamwriter = nullptr;
+        delete pwriter;
+        return -3;
+    }
+    return 0;
+}
+
+int XMNSocket::StreamWrite(const XMNConnHandle &kConnHandle, const uint16_t &kMsgCode, const char *pdata, const size_t &kDataLen)
+{
+    /**
+     * 超过 PKG_MAX_LEN 的普通包会被 client 当作畸形包，并且长度为 XMN_PKG_EXT_MARK 时会被当作扩展包头。
+    */
+    const size_t kPkgLen = kPkgHeaderLen_ + kDataLen;
+    if (kPkgLen > PKG_MAX_LEN)
     {
-        XMNLogStdErr(0, "XMNSocket::PutInSendDataQueue()发现某用户（%d）挤压了太多待发送的数据，需切断与他的连接！",
-                     pconnsockinfo->fd);
-        ++discardsendpkgcount_;
-        pconnsockinfo->FreeSendDataMem(psenddata);
-        ActivelyCloseSocket(pconnsockinfo);
         return -2;
     }
+    XMNConnSockInfo *pconnsockinfo = GetConnSockInfo(kConnHandle);
+    if (pconnsockinfo == nullptr)
+    {
+        return -1;
+    }
 
-    ++pconnsockinfo->nosendmsgcount;
-    senddata_queue_.push(psenddata);
-    ++queue_senddata_count_;
+    /**
+     * （1）组合消息：消息头 + 包头 + 包体。
+    */
+    char *psenddata = (char *)SingletonBase<XMNMemory>::GetInstance().AllocMemory(kMsgHeaderLen_ + kPkgLen, false);
+    if (psenddata == nullptr)
+    {
+        XMNLogStdErr(0, "XMNSocket::StreamWrite 中申请内存失败。");
+        return -1;
+    }
+    XMNMsgHeader *pmsgheader = (XMNMsgHeader *)psenddata;
+    pmsgheader->connhandle = kConnHandle;
+    pmsgheader->memmode = XMNConnSockInfo::GENERALMODE;
+    XMNPkgHeader *ppkgheader = (XMNPkgHeader *)(psenddata + kMsgHeaderLen_);
+    ppkgheader->pkglen = htons(kPkgLen);
+    ppkgheader->msgcode = htons(kMsgCode);
+    ppkgheader->crc32 = 0;
+    if (kDataLen > 0)
+    {
+        char *ppkgbody = psenddata + kMsgHeaderLen_ + kPkgHeaderLen_;
+        memcpy(ppkgbody, pdata, kDataLen);
+        ppkgheader->crc32 = htonl(SingletonBase<XMNCRC32>::GetInstance().GetCRC32((unsigned char *)ppkgbody, kDataLen));
+    }
 
-    if (sem_post(&senddata_queue_sem_) != 0)
+    /**
+     * （2）发送之后判断是否达到了高水位。
+     * 除了字节数，消息的数量也不能接近 XMN_SEND_MAX_PENDING_MSGS ，否则很多小包会导致连接被断开。
+    */
+    if (PutInSendDataQueue(psenddata) != 0)
+    {
+        return -1;
+    }
+    XMNLockMutex sendmutex(&pconnsockinfo->sendmutex_);
+    if (pconnsockinfo->sendqueuebytes >= streamhighwater_ || pconnsockinfo->nosendmsgcount >= XMN_SEND_MAX_PENDING_MSGS / 2)
     {
-        XMNLogStdErr(0, "XMNSocket::SendData()中sem_post()执行失败。");
+        return 1;
     }
     return 0;
 }
 
-char *XMNSocket::PutOutSendDataFromQueue()
+void XMNSocket::ProcessWritable(XMNConnSockInfo *pconnsockinfo)
+{
+    XMNConnColdInfo *pcoldinfo = pconnsockinfo->pcoldinfo;
+    XMNStreamWriter *pwriter = pcoldinfo->pstreamwriter;
+    if (pwriter == nullptr)
+    {
+        return;
+    }
+
+    /**
+     * （1）调用流式发送对象，发送完毕或者出错时释放该对象。
+    */
+    const XMNConnHandle kConnHandle = pconnsockinfo->Handle();
+    int r = pwriter->OnWritable(this, kConnHandle);
+    XMNLockMutex sendmutex(&pconnsockinfo->sendmutex_);
+    if (r != 0)
+    {
+        pcoldinfo->pstreamwriter = nullptr;
+        delete pwriter;
+        return;
+    }
+
+    /**
+     * （2）还有数据要发送时，等待待发送的数据降到低水位以下。
+     * 在 sendmutex_ 的保护下设置标志，不会错过发送线程的检查；已经在低水位以下时直接投递。
+    */
+    pconnsockinfo->iswritewaiting = true;
+    CheckStreamWritable(pconnsockinfo);
+}
+
+void XMNSocket::CheckStreamWritable(XMNConnSockInfo *pconnsockinfo)
 {
-    XMNLockMutex lockmutex_senddata(&senddata_queue_mutex_);
-    char *psenddata = nullptr;
-    if (queue_senddata_count_ != 0)
+    if (pconnsockinfo->iswritewaiting &&
+        pconnsockinfo->sendqueuebytes <= streamlowwater_ &&
+        pconnsockinfo->nosendmsgcount < XMN_SEND_MAX_PENDING_MSGS / 2)
     {
-        psenddata = senddata_queue_.front();
-        senddata_queue_.pop();
-        --queue_senddata_count_;
+        pconnsockinfo->iswritewaiting = false;
+        if (PutInInnerMsg(pconnsockinfo, XMN_INNER_MSG_WRITABLE) == 0)
+        {
+            return;
+        }
+
+        /**
+         * 投递失败时保持等待。待发送的数据可能已经发完，不会再有发送线程来检查，所以由定时器重试。
+        */
+        pconnsockinfo->iswritewaiting = true;
+        const XMNConnHandle kConnHandle = pconnsockinfo->Handle();
+        AddTimer(XMN_TIMER_WHEEL_TICK_MS, [this, kConnHandle]() {
+            XMNConnSockInfo *pconnsockinfo_retry = GetConnSockInfo(kConnHandle);
+            if (pconnsockinfo_retry == nullptr)
+            {
+                return;
+            }
+            XMNLockMutex sendmutex(&pconnsockinfo_retry->sendmutex_);
+            if (pconnsockinfo_retry->Handle() == kConnHandle)
+            {
+                CheckStreamWritable(pconnsockinfo_retry);
+            }
+        });
     }
-    return psenddata;
 }
 
-void *XMNSocket::SendDataThread(void *pthreadinfo)
+void *XMNSocket::SendDataThread(void *psendshard)
 {
-    if (pthreadinfo == nullptr)
+    if (psendshard == nullptr)
     {
-        XMNLogStdErr(0, "XMNSocket::SendDataThread() 中形参 pthreadinfo 为 nullptr 。");
+        XMNLogStdErr(0, "XMNSocket::SendDataThread() 中形参 psendshard 为 nullptr 。");
         return nullptr;
     }
 
     /**
      * （1）定义变量。
     */
-    ThreadInfo *pthreadinfo_new = (ThreadInfo *)pthreadinfo;
-    XMNSocket *psocket = pthreadinfo_new->pthis_;
-    XMNMsgHeader *pmsgheader = nullptr;
-    XMNPkgHeader *ppkgheader = nullptr;
-    char *psendalldata = nullptr;
-    XMNConnSockInfo *pconnsockinfo = nullptr;
-    XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
-    int err = 0;
-    ssize_t sendsize = 0;
+    SendShard *psendshard_new = (SendShard *)psendshard;
+    XMNSocket *psocket = psendshard_new->pthis_;
+    XMNConnSlotTable &slottable = SingletonBase<XMNConnSlotTable>::GetInstance();
+    std::vector<XMNConnHandle> vconnhandle;
+    uint64_t wakeup = 0;
+    int r = 0;
 
     while (!g_isquit)
     {
         /**
-         * （2）等待队列中有待发送的消息。
+         * （2）等待发送连接队列中有待发送数据的连接，多次唤醒在 eventfd 中合并为一次。
         */
-        if (sem_wait(&psocket->senddata_queue_sem_) != 0)
+        if (read(psendshard_new->eventfd_, &wakeup, sizeof(wakeup)) != sizeof(wakeup))
         {
             if (errno == EINTR)
             {
                 continue;
             }
-            XMNLogStdErr(0, "XMNSocket::SendDataThread() 中 sem_wait 执行失败。");
+            XMNLogStdErr(errno, "XMNSocket::SendDataThread() 中 read(eventfd) 执行失败。");
             continue;
         }
         if (g_isquit)
@@ -875,132 +1930,73 @@ void *XMNSocket::SendDataThread(void *pthreadinfo)
         }
 
         /**
-         * 将发送消息队列中的消息全部发送完毕。
+         * （3）一次取走队列中所有的连接，减少对队列互斥量的争用。
         */
-        while (true)
         {
-            psendalldata = psocket->PutOutSendDataFromQueue();
-            if (psendalldata == nullptr)
-            {
-                break;
-            }
-
-            pmsgheader = (XMNMsgHeader *)psendalldata;
-            ppkgheader = (XMNPkgHeader *)(psendalldata + psocket->kMsgHeaderLen_);
-            pconnsockinfo = pmsgheader->pconnsockinfo;
+            XMNLockMutex lockmutex_connqueue(&psendshard_new->connqueue_mutex_);
+            vconnhandle.swap(psendshard_new->connqueue_);
+        }
 
+        /**
+         * （4）逐个连接发送其待发送消息链表中的消息，
+         * 连接在队列中等待期间新到的消息也会在这一次一起发出。
+        */
+        XMNEpochGuard epochguard;
+        for (const auto &kConnHandle : vconnhandle)
+        {
             /**
-             * （3）判断消息是否过期。
+             * 连接在发送连接队列中时不会被回收，所以槽中仍然是该连接，只是可能已经关闭。
             */
-            if (pconnsockinfo->currsequence != pmsgheader->currsequence)
-            {
-                pconnsockinfo->FreeSendDataMem(psendalldata);
-                psendalldata = nullptr;
-                pconnsockinfo->psenddata = nullptr;
-                pconnsockinfo->senddatalen = 0;
-                pconnsockinfo->throwepollsendcount = 0;
-                continue;
-            }
+            XMNConnSockInfo *pconnsockinfo = slottable.GetSlot(kConnHandle);
+            XMNLockMutex sendmutex(&pconnsockinfo->sendmutex_);
+            pconnsockinfo->issendscheduled = false;
 
             /**
-             * （4）发送消息。
+             * 连接已经关闭，丢弃其待发送的消息。
             */
-            if (pconnsockinfo->throwepollsendcount > 0)
+            if (pconnsockinfo->Handle() != kConnHandle)
             {
-                /**
-                 * 说明该消息已经确定靠 epoll 驱动发送了，所以程序不用再向下执行了。
-                */
-                //PutInSendDataQueue(psenddata);
+                psocket->queue_senddata_count_ -= pconnsockinfo->FreeSendQueue();
                 continue;
             }
-
-            --pconnsockinfo->nosendmsgcount;
-            pconnsockinfo->psendalldataforfree = psendalldata;
-            pconnsockinfo->psenddata = psendalldata + psocket->kMsgHeaderLen_;
-            pconnsockinfo->senddatalen = (size_t)ntohs(ppkgheader->pkglen);
-
-            sendsize = psocket->SendData(pconnsockinfo);
-            if (sendsize > 0)
+            if (pconnsockinfo->psendqueuehead == nullptr)
             {
-                if (sendsize == pconnsockinfo->senddatalen)
-                {
-                    /**
-                     * 全部正常发送成功。
-                    */
-                    pconnsockinfo->FreeSendDataMem();
-                    pconnsockinfo->psendalldataforfree = nullptr;
-                    pconnsockinfo->psenddata = nullptr;
-                    pconnsockinfo->senddatalen = 0;
-                    pconnsockinfo->throwepollsendcount = 0;
-                }
-                else
-                {
-                    /**
-                     * 数据不能全部发送，说明发送缓冲区已经满了。
-                    */
-                    pconnsockinfo->psenddata = pconnsockinfo->psenddata + sendsize;
-                    pconnsockinfo->senddatalen = pconnsockinfo->senddatalen - sendsize;
-                    ++pconnsockinfo->throwepollsendcount;
-                    if (psocket->EpollOperationEvent(pconnsockinfo->fd, EPOLL_CTL_MOD, EPOLLOUT, 0, pconnsockinfo) != 0)
-                    {
-                        XMNLogStdErr(0, "XMNSocket::SendDataThread()中执行EpollOperationEvent()失败。");
-                    }
-                    XMNLogStdErr(0,
-                                 "XMNSocket::SendDataThread()中理论发送 %d 个字节，实际发送 %d 个字节。",
-                                 pconnsockinfo->senddatalen,
-                                 sendsize);
-                }
                 continue;
             }
+
             /**
-             * 程序运行到这里说明发送数据时出现了问题。
+             * 已经由 epoll 驱动发送了，只需把消息留在链表中，由 WaitWriteRequestHandler 发送。
             */
-            else if (sendsize == 0)
+            if (pconnsockinfo->throwepollsendcount > 0)
             {
-                /**
-                 * 发送端已断开连接。
-                */
-                pconnsockinfo->FreeSendDataMem();
-                pconnsockinfo->psendalldataforfree = nullptr;
-                pconnsockinfo->psenddata = nullptr;
-                pconnsockinfo->senddatalen = 0;
-                pconnsockinfo->throwepollsendcount = 0;
                 continue;
             }
-            else if (sendsize == -1)
+
+            r = psocket->FlushSendQueue(pconnsockinfo);
+            if (r == 1)
             {
                 /**
-                 * 发送缓冲区已满。
+                 * 发送缓冲区已满，剩下的数据由 epoll 驱动发送，不会影响其他连接的发送。
                 */
-                ++pconnsockinfo->throwepollsendcount;
+                pconnsockinfo->throwepollsendcount = 1;
                 if (psocket->EpollOperationEvent(pconnsockinfo->fd, EPOLL_CTL_MOD, EPOLLOUT, 0, pconnsockinfo) != 0)
                 {
                     XMNLogStdErr(0, "XMNSocket::SendDataThread()中执行EpollOperationEvent()失败。");
                 }
-                continue;
-            }
-            else
-            {
-                pconnsockinfo->FreeSendDataMem();
-                pconnsockinfo->psendalldataforfree = nullptr;
-                pconnsockinfo->psenddata = nullptr;
-                pconnsockinfo->senddatalen = 0;
-                pconnsockinfo->throwepollsendcount = 0;
-                continue;
             }
-
-        } //end while (true)
+        }
+        vconnhandle.clear();
 
     } //end while (!g_isquit)
     return nullptr;
 }
 
-int XMNSocket::SendData(XMNConnSockInfo *pconnsockinfo)
+ssize_t XMNSocket::SendData(XMNConnSockInfo *pconnsockinfo, const struct iovec *piov, const int &kIovCnt, const int &kFlags)
 {
-    size_t n = 0;
+    ssize_t n = 0;
     while (true)
     {
-        n = send(pconnsockinfo->fd, pconnsockinfo->psenddata, pconnsockinfo->senddatalen, 0);
+        n = EventBackend(pconnsockinfo)->Send(pconnsockinfo, piov, kIovCnt, kFlags);
         if (n < 0)
         {
             int err = errno;
@@ -1008,6 +2004,10 @@ int XMNSocket::SendData(XMNConnSockInfo *pconnsockinfo)
             {
                 return -1;
             }
+            else if (err == ENOBUFS && (kFlags & MSG_ZEROCOPY))
+            {
+                return -3;
+            }
             else if (err == EINTR)
             {
                 /**
@@ -1032,19 +2032,166 @@ int XMNSocket::SendData(XMNConnSockInfo *pconnsockinfo)
     return n;
 }
 
+int XMNSocket::FlushSendQueue(XMNConnSockInfo *pconnsockinfo)
+{
+    struct iovec iov[XMN_SEND_IOV_MAX];
+    int iovcnt = 0;
+    size_t iovbytes = 0;
+    size_t pkglen = 0;
+    size_t offset = 0;
+    ssize_t sendsize = 0;
+    int sendflags = 0;
+    char *pmsg = nullptr;
+
+    while (pconnsockinfo->psendqueuehead != nullptr)
+    {
+        /**
+         * （1）将链表中的消息组成 iovec ，链表头部的消息可能已经发送了一部分。
+        */
+        iovcnt = 0;
+        iovbytes = 0;
+        offset = pconnsockinfo->sendheadoffset;
+        for (pmsg = pconnsockinfo->psendqueuehead;
+             pmsg != nullptr && iovcnt < XMN_SEND_IOV_MAX;
+             pmsg = ((XMNMsgHeader *)pmsg)->pnext)
+        {
+            pkglen = ntohs(((XMNPkgHeader *)(pmsg + kMsgHeaderLen_))->pkglen);
+            iov[iovcnt].iov_base = pmsg + kMsgHeaderLen_ + offset;
+            iov[iovcnt].iov_len = pkglen - offset;
+            iovbytes += iov[iovcnt].iov_len;
+            ++iovcnt;
+            offset = 0;
+        }
+
+        /**
+         * （2）一次系统调用发出所有的消息。
+         * 数据量达到阈值时使用 MSG_ZEROCOPY ，内核直接引用消息的内存，消息要等到完成通知到达之后才能释放。
+        */
+        sendflags = (pconnsockinfo->iszerocopy && iovbytes >= sendzerocopythreshold_) ? MSG_ZEROCOPY : 0;
+        sendsize = SendData(pconnsockinfo, iov, iovcnt, sendflags);
+        if (sendsize == -3)
+        {
+            sendflags = 0;
+            sendsize = SendData(pconnsockinfo, iov, iovcnt, sendflags);
+        }
+        if (sendsize == -1)
+        {
+            return 1;
+        }
+        if (sendsize <= 0)
+        {
+            /**
+             * 对端已关闭或者未知错误，丢弃所有待发送的消息。
+            */
+            queue_senddata_count_ -= pconnsockinfo->FreeSendQueue();
+            return -1;
+        }
+
+        if (sendflags & MSG_ZEROCOPY)
+        {
+            ++pconnsockinfo->pcoldinfo.load()->zerocopysendseq;
+        }
+
+        /**
+         * （3）释放已经完整发送的消息，发送的字节数可能止于某个消息的中间。
+        */
+        pconnsockinfo->sendqueuebytes -= sendsize;
+        size_t sendleft = (size_t)sendsize;
+        for (int i = 0; i < iovcnt && sendleft > 0; ++i)
+        {
+            if (sendleft < iov[i].iov_len)
+            {
+                pconnsockinfo->sendheadoffset += sendleft;
+                break;
+            }
+            sendleft -= iov[i].iov_len;
+            pmsg = pconnsockinfo->psendqueuehead;
+            pconnsockinfo->psendqueuehead = ((XMNMsgHeader *)pmsg)->pnext;
+            pconnsockinfo->sendheadoffset = 0;
+            pconnsockinfo->ReleaseSentData(pmsg);
+            --queue_senddata_count_;
+        }
+        if (pconnsockinfo->psendqueuehead == nullptr)
+        {
+            pconnsockinfo->psendqueuetail = nullptr;
+        }
+        CheckStreamWritable(pconnsockinfo);
+        ResumeRecv(pconnsockinfo);
+
+        /**
+         * （4）没有全部发出，说明发送缓冲区已满。
+        */
+        if ((size_t)sendsize < iovbytes)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int XMNSocket::RecvZeroCopyCompletion(XMNConnSockInfo *pconnsockinfo)
+{
+    char control[256];
+    struct msghdr msg;
+    struct cmsghdr *pcmsg = nullptr;
+    struct sock_extended_err *pserr = nullptr;
+    int count = 0;
+    XMNConnColdInfo *pcoldinfo = pconnsockinfo->pcoldinfo;
+
+    XMNLockMutex sendmutex(&pconnsockinfo->sendmutex_);
+    /**
+     * （1）读取错误队列中所有的完成通知，每个通知表示编号为 [ee_info, ee_data] 的发送已经完成。
+     * TCP 的完成通知是按顺序到达的，所以只需记录最大的已完成的编号。
+    */
+    while (true)
+    {
+        memset(&msg, 0, sizeof(struct msghdr));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(pconnsockinfo->fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1)
+        {
+            break;
+        }
+        for (pcmsg = CMSG_FIRSTHDR(&msg); pcmsg != nullptr; pcmsg = CMSG_NXTHDR(&msg, pcmsg))
+        {
+            pserr = (struct sock_extended_err *)CMSG_DATA(pcmsg);
+            if (pserr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || pserr->ee_errno != 0)
+            {
+                continue;
+            }
+            if ((int32_t)(pserr->ee_data + 1 - pcoldinfo->zerocopydoneseq) > 0)
+            {
+                pcoldinfo->zerocopydoneseq = pserr->ee_data + 1;
+            }
+            ++count;
+        }
+    }
+
+    /**
+     * （2）释放已经完成发送的消息。
+    */
+    pconnsockinfo->FreeZeroCopyQueue(false);
+    CheckStreamWritable(pconnsockinfo);
+    ResumeRecv(pconnsockinfo);
+    return count;
+}
+
 int XMNSocket::FreeSendDataQueue()
 {
-    XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
-    char *ptmp = nullptr;
-    while (!senddata_queue_.empty())
+    for (const auto &x : vsendshard_)
     {
-        ptmp = senddata_queue_.front();
-        senddata_queue_.pop();
-        XMNMsgHeader *pmsgheader = (XMNMsgHeader *)ptmp;
-        XMNConnSockInfo *pconnsockinfo = pmsgheader->pconnsockinfo;
-        pconnsockinfo->FreeSendDataMem(ptmp);
+        XMNLockMutex lockmutex_connqueue(&x->connqueue_mutex_);
+        for (const auto &kConnHandle : x->connqueue_)
+        {
+            XMNConnSockInfo *pconnsockinfo = SingletonBase<XMNConnSlotTable>::GetInstance().GetSlot(kConnHandle);
+            XMNLockMutex sendmutex(&pconnsockinfo->sendmutex_);
+            pconnsockinfo->issendscheduled = false;
+            queue_senddata_count_ -= pconnsockinfo->FreeSendQueue();
+        }
+        x->connqueue_.clear();
+        std::vector<XMNConnHandle>().swap(x->connqueue_);
     }
-    std::queue<char *>().swap(senddata_queue_);
     return 0;
 }
 
@@ -1055,13 +2202,9 @@ int XMNSocket::ActivelyCloseSocket(XMNConnSockInfo *pconnsockinfo)
         return -1;
     }
 
-    if (pingenable_)
-    {
-        PutOutMsgHeaderFromMultiMap(pconnsockinfo);
-    }
     if (pconnsockinfo->fd != -1)
     {
-        close(pconnsockinfo->fd);
+        EventBackend(pconnsockinfo)->Close(pconnsockinfo);
         pconnsockinfo->fd = -1;
     }
     if (pconnsockinfo->throwepollsendcount > 0)
@@ -1123,9 +2266,67 @@ void XMNSocket::PrintInfo()
         XMNLogStdErr(0, "\n--------------------  begin --------------------");
         XMNLogStdErr(0, "当前在线人数 / 总人数（%d，%d）", onlineusercount, worker_connection_count_);
         XMNLogStdErr(0, "连接池中当前连接数量 / 要释放的连接（%d，%d）。",
-                     SingletonBase<XMNMemPool<XMNConnSockInfo>>::GetInstance().UsedMemBlockCount(),
+                     SingletonBase<XMNConnSlotTable>::GetInstance().UsedSlotCount(),
                      recycleconnsock_pool_.size());
-        XMNLogStdErr(0, "当前时间队列的大小（%d）", ping_multimap_.size());
+        XMNLogStdErr(0, "当前定时器的数量（%d）", timerwheel_.TimerCount());
+        if (vreactor_.size() > 1)
+        {
+            std::string strreactorconn;
+            for (size_t i = 1; i < vreactor_.size(); ++i)
+            {
+                strreactorconn += (i > 1 ? "，" : "") + std::to_string(vreactor_[i]->conncount_);
+            }
+            XMNLogStdErr(0, "各个 reactor 线程负责的连接数量（%s）", strreactorconn.c_str());
+        }
+        /**
+         * 忙轮询：自旋（超时时间为 0）的 Wait 占全部 Wait 的比例，以及自旋时取到事件的比例，按事件循环输出后清零。
+        */
+        if (busypollspinns_ > 0)
+        {
+            std::string strbusypoll;
+            for (size_t i = 0; i < vreactor_.size(); ++i)
+            {
+                size_t spinpoll = vreactor_[i]->spinpollcount_.exchange(0);
+                size_t spinhit = vreactor_[i]->spinhitcount_.exchange(0);
+                size_t blockwait = vreactor_[i]->blockwaitcount_.exchange(0);
+                strbusypoll += (i > 0 ? "，" : "") + std::to_string(i) + ": " + std::to_string(spinpoll) + " / " +
+                               std::to_string(spinpoll + blockwait) + " / " + std::to_string(spinhit);
+            }
+            XMNLogStdErr(0, "各个事件循环自旋的次数 / 等待的总次数 / 自旋时取到事件的次数（%s）", strbusypoll.c_str());
+        }
+        if (!vudpsockfd_.empty())
+        {
+            XMNLogStdErr(0, "处理的 UDP 心跳包 / 丢弃的数据报（%d，%d）", (int)udppingcount_, (int)udpdropcount_);
+            udppingcount_ = 0;
+            udpdropcount_ = 0;
+        }
+        /**
+         * 空闲连接只占用连接结构体，冷数据在注册等业务逻辑之后才申请，按在线人数平均。
+        */
+        XMNRingBufferPool &ringbuffpool = SingletonBase<XMNRingBufferPool>::GetInstance();
+        size_t coldinfocount = SingletonBase<XMNMemPool<XMNConnColdInfo>>::GetInstance().UsedMemBlockCount();
+        size_t idlebytes = sizeof(XMNConnSockInfo);
+        if (onlineusercount > 0)
+        {
+            idlebytes += coldinfocount * sizeof(XMNConnColdInfo) / onlineusercount;
+        }
+        XMNLogStdErr(0, "每个空闲连接常驻的内存为（%d）字节，持有接收缓冲区的连接 / 缓冲池中空闲的缓冲区（%d，%d）",
+                     idlebytes,
+                     ringbuffpool.UsedCount(),
+                     ringbuffpool.FreeCount());
+        XMNLogStdErr(0, "待业务逻辑处理的大包的数据块的数量（%d）",
+                     SingletonBase<XMNMemPool<XMNStreamChunk>>::GetInstance().UsedMemBlockCount());
+        if (backpressureenable_)
+        {
+            size_t recvpausedcount = 0;
+            {
+                XMNLockMutex recvpausedmutex(&recvpausedmutex_);
+                recvpausedcount = vrecvpaused_.size();
+            }
+            XMNLogStdErr(0, "背压：暂停接收的次数（%d），当前暂停接收的连接的数量（%d）",
+                         (size_t)recvpausecount_.exchange(0),
+                         recvpausedcount);
+        }
         XMNLogStdErr(0, "当前接收消息队列和发送消息队列的大小分别为（%d，%d），被丢弃的待发送的消息的数量为（%d）",
                      recvmsgcount,
                      sendmsgcount_,
@@ -1,5 +1,7 @@
 #include "sys/socket.h"
 #include "sys/types.h"
+#include "netinet/in.h"
+#include "netinet/tcp.h"
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
@@ -7,6 +9,7 @@
 #include "comm/xmn_socket.h"
 #include "xmn_macro.h"
 #include "xmn_func.h"
+#include "xmn_global.h"
 
 void XMNSocket::EventAcceptHandler(XMNConnSockInfo *pconnsockinfo)
 {
@@ -18,7 +21,6 @@ void XMNSocket::EventAcceptHandler(XMNConnSockInfo *pconnsockinfo)
     memset(&addr, 0, addrlen * 1);
     static bool isuseaccept4 = true;
     int linkfd = -1;
-    int listenfd = pconnsockinfo->plistensockinfo->fd;
     XMNConnSockInfo *pconnsockinfo_new = nullptr;
     /**
      * 用于临时存储 errno 的值，防止在对不同的错误进行处理时，其他代码修改了该值。
@@ -33,15 +35,9 @@ void XMNSocket::EventAcceptHandler(XMNConnSockInfo *pconnsockinfo)
     {
         /**
          * 创建 listenfd 时，设置为非堵塞，故该函数会立刻返回。
+         * io_uring 后端中，新连接已经由 multishot accept 取出，这里只是领取。
         */
-        if (isuseaccept4)
-        {
-            linkfd = accept4(listenfd, &addr, &addrlen, SOCK_NONBLOCK);
-        }
-        else
-        {
-            linkfd = accept(listenfd, &addr, &addrlen);
-        }
+        linkfd = EventBackend(pconnsockinfo)->Accept(pconnsockinfo, &addr, &addrlen, isuseaccept4 ? SOCK_NONBLOCK : 0);
 
         /**
          * （3）对 accept4 或者 accept 的返回值进行判断处理。
@@ -88,8 +84,9 @@ void XMNSocket::EventAcceptHandler(XMNConnSockInfo *pconnsockinfo)
             if (errnotmp == ECONNABORTED)
             {
                 /**
-                 * 该错误可以忽略，不做处理。
+                 * 该错误可以忽略，继续 accept 下一个连接。
                 */
+                continue;
             }
 
             if ((errnotmp == EMFILE) || (errnotmp == ENFILE))
@@ -110,8 +107,16 @@ void XMNSocket::EventAcceptHandler(XMNConnSockInfo *pconnsockinfo)
         */
         if (++onlineuser_count_ > worker_connection_count_)
         {
+            --onlineuser_count_;
             close(linkfd);
             XMNLogStdErr(0, "XMNSocket::EventAcceptHandler()中新连入的连接将被关闭，因为已经超过了指定的在线用户数量的上限。");
+            /**
+             * ET 模式下必须把已完成连接队列取空，否则剩余的连接不会再触发事件。
+            */
+            if (epolletenable_)
+            {
+                continue;
+            }
             return;
         }
         /**
@@ -124,6 +129,7 @@ void XMNSocket::EventAcceptHandler(XMNConnSockInfo *pconnsockinfo)
             /**
              *  连接池中的连接不够用，那么直接将 linkfd 关闭即可。
             */
+            --onlineuser_count_;
             if (close(linkfd) == -1)
             {
                 XMNLogInfo(XMN_LOG_ALERT, errno, "EventAcceptHandler 中 close (%d) 失败！", linkfd);
@@ -132,9 +138,8 @@ void XMNSocket::EventAcceptHandler(XMNConnSockInfo *pconnsockinfo)
         }
         /**
          * 执行到这里说明已经成功地从连接池中拿到了一个连接。
-         * 将 client 信息拷贝到 clientsockaddrinfo 中。
+         * client 的地址存放在冷数据中，需要时通过 GetColdInfo 获取，此处不再保存。
         */
-        memcpy(&pconnsockinfo_new->clientsockaddrinfo, &addr, sizeof(struct sockaddr) * 1);
 
         if (!isuseaccept4)
         {
@@ -143,10 +148,52 @@ void XMNSocket::EventAcceptHandler(XMNConnSockInfo *pconnsockinfo)
                 /**
                  * 立即回收连接至连接池并关闭 socket 。
                 */
+                --onlineuser_count_;
                 CloseConnection(pconnsockinfo_new);
                 return;
             }
         }
+        /**
+         * 按照监听端口的 socket 配置方案设置连接 socket 的选项。
+         * Unix 域 socket 没有 TCP 的选项，也不经过网卡，以下的选项只对 TCP 连接设置。
+        */
+        const bool kIsTcp = pconnsockinfo->plistensockinfo->family == AF_INET;
+        if (kIsTcp)
+        {
+            ApplyConnSocketProfile(linkfd, *pconnsockinfo->plistensockinfo->pprofile);
+        }
+
+        /**
+         * 开启零拷贝发送，内核不支持时该连接仍然使用普通方式发送。
+        */
+        if (sendzerocopyenable_ && kIsTcp)
+        {
+            int zerocopy = 1;
+            if (setsockopt(linkfd, SOL_SOCKET, SO_ZEROCOPY, &zerocopy, sizeof(zerocopy)) == 0)
+            {
+                pconnsockinfo_new->iszerocopy = true;
+                pconnsockinfo_new->GetColdInfo();
+            }
+            else
+            {
+                XMNLogInfo(XMN_LOG_WARN, errno, "EventAcceptHandler 中 setsockopt(SO_ZEROCOPY) 失败！");
+            }
+        }
+
+        /**
+         * 开启 socket 级别的忙轮询，读取时在网卡队列上自旋，内核不支持时关闭该选项，只提示一次。
+        */
+        if (busypollsocketus_ > 0 && kIsTcp)
+        {
+            int prefer = 1;
+            if (setsockopt(linkfd, SOL_SOCKET, SO_BUSY_POLL, &busypollsocketus_, sizeof(busypollsocketus_)) != 0 ||
+                setsockopt(linkfd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer)) != 0)
+            {
+                XMNLogInfo(XMN_LOG_WARN, errno, "EventAcceptHandler 中 setsockopt(SO_BUSY_POLL) 失败，关闭 socket 级别的忙轮询！");
+                busypollsocketus_ = 0;
+            }
+        }
+
         /**
          * 连接 socket 对应的连接对象和监听对象关联。
         */
@@ -164,27 +211,197 @@ void XMNSocket::EventAcceptHandler(XMNConnSockInfo *pconnsockinfo)
         pconnsockinfo_new->rhandler = &XMNSocket::WaitReadRequestHandler;
         pconnsockinfo_new->whandler = &XMNSocket::WaitWriteRequestHandler;
         /**
-        * （5）将新建立的连接加入到 epoll 的红黑树中。
+        * （5）为新建立的连接选择 reactor ，并将其加入到该 reactor 的 epoll 的红黑树中。
+        * 之后该连接的事件都由该 reactor 处理。
         */
+        pconnsockinfo_new->reactorindex = (uint16_t)SelectReactor();
+        ++vreactor_[pconnsockinfo_new->reactorindex]->conncount_;
         int r = EpollOperationEvent(linkfd,
                                     EPOLL_CTL_ADD,
-                                    EPOLLIN | EPOLLRDHUP,
+                                    EPOLLIN | EPOLLRDHUP | (epolletenable_ ? EPOLLET : 0),
                                     0,
                                     pconnsockinfo_new);
         if (r != 0)
         {
+            --onlineuser_count_;
+            --vreactor_[pconnsockinfo_new->reactorindex]->conncount_;
             CloseConnection(pconnsockinfo_new);
             return;
         }
         /**
-        * （6）将该连接信息放入心跳监控 multimap 中。
+        * （6）为该连接添加心跳监控定时器。
         */
         if (pingenable_)
         {
-            PutInConnSockInfo2PingMultiMap(pconnsockinfo_new);
+            PutInConnSockInfo2PingTimer(pconnsockinfo_new);
+        }
+
+        /**
+         * LT 模式下每次只 accept 一个连接，剩余的连接由下一次 epoll_wait 驱动。
+         * ET 模式下需要一直 accept 直至返回 EAGAIN 。
+        */
+        if (!epolletenable_)
+        {
+            break;
         }
-        break;
     } while (true);
 
     return;
+}
+
+int XMNSocket::EnableAcceptEvents()
+{
+    if (acceptenabled_)
+    {
+        return 0;
+    }
+
+    /**
+     * EPOLLEXCLUSIVE 只能和 EPOLLIN、EPOLLOUT、EPOLLWAKEUP、EPOLLET 一起使用，
+     * 故该方式下不能带有 EPOLLRDHUP 。
+    */
+    uint32_t events = EPOLLIN | (epolletenable_ ? EPOLLET : 0);
+    if (acceptbalancemode_ == XMN_ACCEPT_BALANCE_EXCLUSIVE)
+    {
+        events |= EPOLLEXCLUSIVE;
+    }
+    else
+    {
+        events |= EPOLLRDHUP;
+    }
+
+    /**
+     * ET 模式下，监听 socket 也采用边缘触发，由 EventAcceptHandler 循环 accept 直至 EAGAIN 。
+    */
+    for (const auto &x : vlistenportsockinfolist_)
+    {
+        if (EpollOperationEvent(x->fd, EPOLL_CTL_ADD, events, 0, x->pconnsockinfo) != 0)
+        {
+            return -1;
+        }
+    }
+    acceptenabled_ = true;
+    return 0;
+}
+
+int XMNSocket::DisableAcceptEvents()
+{
+    if (!acceptenabled_)
+    {
+        return 0;
+    }
+
+    /**
+     * EPOLLEXCLUSIVE 注册的事件不能通过 EPOLL_CTL_MOD 修改，所以统一采用删除的方式。
+    */
+    for (const auto &x : vlistenportsockinfolist_)
+    {
+        if (EpollOperationEvent(x->fd, EPOLL_CTL_DEL, 0, 0, x->pconnsockinfo) != 0)
+        {
+            return -1;
+        }
+    }
+    acceptenabled_ = false;
+    return 0;
+}
+
+int XMNSocket::ProcessAcceptBalance()
+{
+    /**
+     * （1）判断本进程是否已经接近满负荷。
+    */
+    bool isoverload = false;
+    if (acceptstopcount_ > 0)
+    {
+        isoverload = acceptenabled_ ? (onlineuser_count_ >= acceptstopcount_)
+                                    : (onlineuser_count_ >= acceptresumecount_);
+    }
+
+    /**
+     * （2）不采用 accept 互斥量时，满负荷则暂停 accept ，否则恢复 accept 。
+     * 暂停期间连接可能由其他线程关闭，所以 epoll_wait 不能一直堵塞，需要定时检查。
+    */
+    if (acceptbalancemode_ != XMN_ACCEPT_BALANCE_MUTEX)
+    {
+        if (isoverload)
+        {
+            DisableAcceptEvents();
+            return acceptmutexdelay_;
+        }
+        EnableAcceptEvents();
+        return -1;
+    }
+
+    /**
+     * （3）采用 accept 互斥量时，满负荷的进程不参与竞争，其他进程尝试获取互斥量，
+     * 获取到则监听共享的 socket ，否则不再监听。
+    */
+    pid_t expected = 0;
+    if (!isoverload && paccept_mutex_->lock.compare_exchange_strong(expected, g_xmn_pid))
+    {
+        EnableAcceptEvents();
+        acceptmutexheld_ = true;
+    }
+    else
+    {
+        DisableAcceptEvents();
+        acceptmutexheld_ = false;
+    }
+    return acceptmutexdelay_;
+}
+
+void XMNSocket::ReleaseAcceptMutex()
+{
+    if (!acceptmutexheld_)
+    {
+        return;
+    }
+
+    /**
+     * 仅仅释放互斥量，监听 socket 仍保留在 epoll 中，直到下一次 ProcessAcceptBalance 没有获取到互斥量为止。
+    */
+    pid_t expected = g_xmn_pid;
+    paccept_mutex_->lock.compare_exchange_strong(expected, 0);
+}
+
+void XMNSocket::ForceReleaseAcceptMutex(const pid_t &kPid)
+{
+    if (paccept_mutex_ == nullptr)
+    {
+        return;
+    }
+    pid_t expected = kPid;
+    if (paccept_mutex_->lock.compare_exchange_strong(expected, 0))
+    {
+        XMNLogInfo(XMN_LOG_ALERT, 0, "pid = %d 退出时持有 accept 互斥量，已强制释放。", kPid);
+    }
+}
+
+void XMNSocket::ApplyConnSocketProfile(const int &kSockFd, const XMNSocketProfile &kProfile)
+{
+    /**
+     * （1）关闭 Nagle 算法，小包立即发送；限制 socket 中尚未发送的数据量，发送缓冲区中积压的数据更少。
+    */
+    if (kProfile.nodelay > 0 && setsockopt(kSockFd, IPPROTO_TCP, TCP_NODELAY, &kProfile.nodelay, sizeof(int)) != 0)
+    {
+        XMNLogInfo(XMN_LOG_WARN, errno, "ApplyConnSocketProfile 中 setsockopt(TCP_NODELAY) 失败！");
+    }
+    if (kProfile.notsentlowat > 0 && setsockopt(kSockFd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &kProfile.notsentlowat, sizeof(int)) != 0)
+    {
+        XMNLogInfo(XMN_LOG_WARN, errno, "ApplyConnSocketProfile 中 setsockopt(TCP_NOTSENT_LOWAT) 失败！");
+    }
+
+    /**
+     * （2）TCP 保活，各个参数为 0 时使用系统的默认值。
+    */
+    if (kProfile.keepalive > 0)
+    {
+        if (setsockopt(kSockFd, SOL_SOCKET, SO_KEEPALIVE, &kProfile.keepalive, sizeof(int)) != 0 ||
+            (kProfile.keepidle > 0 && setsockopt(kSockFd, IPPROTO_TCP, TCP_KEEPIDLE, &kProfile.keepidle, sizeof(int)) != 0) ||
+            (kProfile.keepintvl > 0 && setsockopt(kSockFd, IPPROTO_TCP, TCP_KEEPINTVL, &kProfile.keepintvl, sizeof(int)) != 0) ||
+            (kProfile.keepcnt > 0 && setsockopt(kSockFd, IPPROTO_TCP, TCP_KEEPCNT, &kProfile.keepcnt, sizeof(int)) != 0))
+        {
+            XMNLogInfo(XMN_LOG_WARN, errno, "ApplyConnSocketProfile 中设置 TCP 保活参数失败！");
+        }
+    }
 }
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "comm/xmn_socket.h"
+#include "xmn_global.h"
+#include "xmn_func.h"
+#include "xmn_macro.h"
+#include "xmn_lockmutex.hpp"
+
+#include <sys/epoll.h>
+
+void XMNSocket::RecvMsgDone(const XMNConnHandle &kConnHandle)
+{
+    XMNConnSockInfo *pconnsockinfo = GetConnSockInfo(kConnHandle);
+    if (pconnsockinfo == nullptr)
+    {
+        return;
+    }
+
+    /**
+     * 只有暂停了接收的连接、且积压降到低水位时才需要加锁检查。
+    */
+    if (--pconnsockinfo->recvmsgcount > connrecvlowwater_ || !pconnsockinfo->isrecvpaused)
+    {
+        return;
+    }
+    XMNLockMutex sendmutex(&pconnsockinfo->sendmutex_);
+    ResumeRecv(pconnsockinfo);
+}
+
+bool XMNSocket::IsRecvOverloaded(XMNConnSockInfo *pconnsockinfo)
+{
+    /**
+     * （1）连接本身的积压：尚未处理完的消息、待发送的字节和消息。
+    */
+    if (pconnsockinfo->recvmsgcount >= connrecvhighwater_ ||
+        pconnsockinfo->sendqueuebytes >= connsendhighwater_ ||
+        pconnsockinfo->nosendmsgcount >= XMN_SEND_MAX_PENDING_MSGS / 2)
+    {
+        return true;
+    }
+
+    /**
+     * （2）worker 进程的积压：接收消息队列和发送消息队列。
+    */
+    if (g_threadpool.RecvDataQueueSize() >= recvqueuehighwater_ || queue_senddata_count_ >= sendqueuehighwater_)
+    {
+        return true;
+    }
+
+    /**
+     * （3）业务逻辑尚未处理的大包的数据块。
+    */
+    XMNConnColdInfo *pcoldinfo = pconnsockinfo->pcoldinfo;
+    if (pcoldinfo != nullptr)
+    {
+        XMNLockMutex streammutex(&pcoldinfo->streammutex_);
+        return pcoldinfo->streamchunkcount >= XMN_STREAM_MAX_PENDING_CHUNKS;
+    }
+    return false;
+}
+
+bool XMNSocket::IsRecvDrained(XMNConnSockInfo *pconnsockinfo)
+{
+    if (pconnsockinfo->recvmsgcount > connrecvlowwater_ ||
+        pconnsockinfo->sendqueuebytes > connsendlowwater_ ||
+        pconnsockinfo->nosendmsgcount > XMN_SEND_MAX_PENDING_MSGS / 4)
+    {
+        return false;
+    }
+    if (g_threadpool.RecvDataQueueSize() > recvqueuelowwater_ || queue_senddata_count_ > sendqueuelowwater_)
+    {
+        return false;
+    }
+    XMNConnColdInfo *pcoldinfo = pconnsockinfo->pcoldinfo;
+    if (pcoldinfo != nullptr)
+    {
+        XMNLockMutex streammutex(&pcoldinfo->streammutex_);
+        return pcoldinfo->streamchunkcount <= XMN_STREAM_RESUME_CHUNKS;
+    }
+    return true;
+}
+
+bool XMNSocket::PauseRecv(XMNConnSockInfo *pconnsockinfo)
+{
+    if (pconnsockinfo->isrecvpaused)
+    {
+        return true;
+    }
+    if (pconnsockinfo->fd == -1 || !IsRecvOverloaded(pconnsockinfo))
+    {
+        return false;
+    }
+
+    /**
+     * （1）去掉 EPOLLIN ，内核的接收缓冲区填满之后 client 的发送窗口会降为 0 。
+    */
+    if (EpollOperationEvent(pconnsockinfo->fd, EPOLL_CTL_MOD, EPOLLIN, 1, pconnsockinfo) != 0)
+    {
+        XMNLogStdErr(0, "XMNSocket::PauseRecv()中执行EpollOperationEvent()失败。");
+        return false;
+    }
+    pconnsockinfo->isrecvpaused = true;
+    ++recvpausecount_;
+
+    /**
+     * （2）记录该连接，定时器没有运行时启动它。
+    */
+    XMNLockMutex recvpausedmutex(&recvpausedmutex_);
+    vrecvpaused_.push_back(pconnsockinfo->Handle());
+    if (!isrecvpausedtimer_)
+    {
+        isrecvpausedtimer_ = true;
+        AddTimer(XMN_TIMER_WHEEL_TICK_MS, [this]() {
+            ResumePausedConns();
+        });
+    }
+    return true;
+}
+
+bool XMNSocket::ResumeRecv(XMNConnSockInfo *pconnsockinfo)
+{
+    if (!pconnsockinfo->isrecvpaused)
+    {
+        return false;
+    }
+
+    /**
+     * 已经关闭的连接不再恢复，由 ResumePausedConns 将其移出列表。
+    */
+    if (pconnsockinfo->fd == -1 || !IsRecvDrained(pconnsockinfo))
+    {
+        return true;
+    }
+
+    /**
+     * 先清除标记再加上 EPOLLIN ，否则事件循环可能在两者之间读取数据，并因为标记仍在而跳过暂停的检查。
+    */
+    pconnsockinfo->isrecvpaused = false;
+    if (EpollOperationEvent(pconnsockinfo->fd, EPOLL_CTL_MOD, EPOLLIN, 0, pconnsockinfo) != 0)
+    {
+        XMNLogStdErr(0, "XMNSocket::ResumeRecv()中执行EpollOperationEvent()失败。");
+        pconnsockinfo->isrecvpaused = true;
+        return true;
+    }
+    return false;
+}
+
+void XMNSocket::ResumePausedConns()
+{
+    /**
+     * （1）取出整个列表，检查时不持有 recvpausedmutex_ ，PauseRecv 在持有 sendmutex_ 时会获取它。
+    */
+    std::vector<XMNConnHandle> vhandles;
+    {
+        XMNLockMutex recvpausedmutex(&recvpausedmutex_);
+        vhandles.swap(vrecvpaused_);
+    }
+
+    /**
+     * （2）已经关闭或者已经恢复的连接移出列表，其余的连接尝试恢复接收。
+    */
+    std::vector<XMNConnHandle> vstillpaused;
+    for (const auto &x : vhandles)
+    {
+        XMNConnSockInfo *pconnsockinfo = GetConnSockInfo(x);
+        if (pconnsockinfo == nullptr)
+        {
+            continue;
+        }
+        XMNLockMutex sendmutex(&pconnsockinfo->sendmutex_);
+        if (ResumeRecv(pconnsockinfo) && pconnsockinfo->fd != -1)
+        {
+            vstillpaused.push_back(x);
+        }
+    }
+
+    /**
+     * （3）放回仍然暂停的连接，列表不为空时下一个 tick 继续。
+    */
+    XMNLockMutex recvpausedmutex(&recvpausedmutex_);
+    vrecvpaused_.insert(vrecvpaused_.end(), vstillpaused.begin(), vstillpaused.end());
+    if (vrecvpaused_.empty())
+    {
+        isrecvpausedtimer_ = false;
+        return;
+    }
+    AddTimer(XMN_TIMER_WHEEL_TICK_MS, [this]() {
+        ResumePausedConns();
+    });
+}
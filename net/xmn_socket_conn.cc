@@ -5,10 +5,13 @@
 #include "xmn_macro.h"
 #include "xmn_global.h"
 #include "xmn_mempool.hpp"
+#include "xmn_epoch.h"
 
+#include <errno.h>
 #include <pthread.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/mman.h>
 
 /**************************************************************************************
  * 
@@ -18,7 +21,7 @@
 XMNConnSockInfo::XMNConnSockInfo()
 {
     memset(this, 0, sizeof(struct XMNConnSockInfo));
-    int r = pthread_mutex_init(&logicprocmutex_, nullptr);
+    int r = pthread_mutex_init(&sendmutex_, nullptr);
     if (r != 0)
     {
         XMNLogStdErr(0, "XMNConnSockInfo::XMNConnSockInfo() 调用 pthread_mutex_init 失败，错误代码：%d", r);
@@ -27,7 +30,7 @@ XMNConnSockInfo::XMNConnSockInfo()
 
 XMNConnSockInfo::~XMNConnSockInfo()
 {
-    int r = pthread_mutex_destroy(&logicprocmutex_);
+    int r = pthread_mutex_destroy(&sendmutex_);
     if (r != 0)
     {
         XMNLogStdErr(0, "XMNConnSockInfo::~XMNConnSockInfo() 调用 pthread_mutex_destroy 失败，错误代码：%d", r);
@@ -37,48 +40,55 @@ XMNConnSockInfo::~XMNConnSockInfo()
 void XMNConnSockInfo::InitConnSockInfo()
 {
     /**
-     * （1）序号 + 1，用于判断消息是否过期。
+     * （1）代数 + 1，之前的句柄全部失效。
     */
-    ++currsequence;
+    ++generation;
 
     /**
-     * （2）收包状态机变为初始化状态。
+     * （2）其他变量初始化。
+     * 接收缓冲区在第一次收到数据时才申请内存，此处不必处理。
     */
-    recvstatus = PKG_HD_INIT;
-    precvdatastart = dataheader;
-    recvdatalen = sizeof(XMNPkgHeader);
+    psendqueuehead = nullptr;
+    psendqueuetail = nullptr;
+    sendheadoffset = 0;
+    sendqueuebytes = 0;
+    issendscheduled = false;
+    iszerocopy = false;
+    iswritewaiting = false;
+    isrecvpaused = false;
+    recvmsgcount = 0;
+    udpnonce = 0;
+    reactorindex = 0;
+    events = 0;
+    throwepollsendcount = 0;
 
     /**
-     * （3）其他变量初始化。
+     * （3）io_uring 后端相关的变量初始化，readyres 为 0 会被当作对端已关闭。
     */
-    precvalldata = nullptr;
-    psendalldataforfree = nullptr;
-    psenddata = nullptr;
-    events = 0;
-    throwepollsendcount = 0;
+    preadydata = nullptr;
+    readydatalen = 0;
+    readyres = -EAGAIN;
+    uringflags = 0;
 }
 
 void XMNConnSockInfo::ClearConnSockInfo()
 {
     /**
-     * 序号 + 1，用于判断消息是否过期。
+     * 代数 + 1，之前的句柄全部失效。
     */
-    ++currsequence;
+    ++generation;
 
     /**
      * 释放内存。
     */
-    XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
-    if (precvalldata != nullptr)
-    {
-        memory.FreeMemory((void *)precvalldata);
-        precvalldata = nullptr;
-    }
+    recvringbuff.Destroy();
 
-    if (psendalldataforfree != nullptr)
     {
-        FreeSendDataMem();
+        XMNLockMutex sendmutex(&sendmutex_);
+        FreeSendQueue();
+        FreeZeroCopyQueue(true);
     }
+    FreeColdInfo();
 
     /**
      * 其他变量清零。
@@ -86,49 +96,272 @@ void XMNConnSockInfo::ClearConnSockInfo()
     throwepollsendcount = 0;
 }
 
-void XMNConnSockInfo::FreeSendDataMem()
+void XMNConnSockInfo::FreeSendDataMem(char *pdata)
 {
+    const uint8_t memmode = ((XMNMsgHeader *)pdata)->memmode;
     if (memmode == GENERALMODE)
     {
         XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
-        memory.FreeMemory((void *)psendalldataforfree);
+        memory.FreeMemory((void *)pdata);
     }
     else if (memmode == REGISTERMODE)
     {
-        SingletonBase<XMNMemPool<RegisterInfoAll>>::GetInstance().DeAllocate(psendalldataforfree);
+        SingletonBase<XMNMemPool<RegisterInfoAll>>::GetInstance().DeAllocate(pdata);
     }
     else if (memmode == PINGMODE)
     {
-        SingletonBase<XMNMemPool<NoBodyInfoAll>>::GetInstance().DeAllocate(psendalldataforfree);
+        SingletonBase<XMNMemPool<NoBodyInfoAll>>::GetInstance().DeAllocate(pdata);
     }
     else if (memmode == LOGINMODE)
     {
-        SingletonBase<XMNMemPool<LoginInfoAll>>::GetInstance().DeAllocate(psendalldataforfree);
+        SingletonBase<XMNMemPool<LoginInfoAll>>::GetInstance().DeAllocate(pdata);
+    }
+    else if (memmode == UDPTOKENMODE)
+    {
+        SingletonBase<XMNMemPool<UdpTokenInfoAll>>::GetInstance().DeAllocate(pdata);
     }
-    psendalldataforfree = nullptr;
 }
 
-void XMNConnSockInfo::FreeSendDataMem(char *pdata)
+size_t XMNConnSockInfo::FreeSendQueue()
 {
-    if (memmode == GENERALMODE)
+    char *pnext = nullptr;
+    size_t count = 0;
+    while (psendqueuehead != nullptr)
     {
-        XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
-        memory.FreeMemory((void *)pdata);
+        pnext = ((XMNMsgHeader *)psendqueuehead)->pnext;
+        FreeSendDataMem(psendqueuehead);
+        psendqueuehead = pnext;
+        --nosendmsgcount;
+        ++count;
     }
-    else if (memmode == REGISTERMODE)
+    psendqueuetail = nullptr;
+    sendheadoffset = 0;
+    sendqueuebytes = 0;
+    return count;
+}
+
+void XMNConnSockInfo::ReleaseSentData(char *pdata)
+{
+    XMNConnColdInfo *pcoldinfo_now = pcoldinfo;
+    if (!iszerocopy || pcoldinfo_now->zerocopysendseq == pcoldinfo_now->zerocopydoneseq)
     {
-        SingletonBase<XMNMemPool<RegisterInfoAll>>::GetInstance().DeAllocate(pdata);
+        FreeSendDataMem(pdata);
+        --nosendmsgcount;
+        return;
     }
-    else if (memmode == PINGMODE)
+
+    /**
+     * 该消息可能被尚未完成的零拷贝发送引用（包括只发送了一部分的情况），
+     * 等最近一次零拷贝发送完成之后再释放。
+    */
+    XMNMsgHeader *pmsgheader = (XMNMsgHeader *)pdata;
+    pmsgheader->pnext = nullptr;
+    pmsgheader->zerocopyid = pcoldinfo_now->zerocopysendseq - 1;
+    if (pcoldinfo_now->pzerocopytail == nullptr)
     {
-        SingletonBase<XMNMemPool<NoBodyInfoAll>>::GetInstance().DeAllocate(pdata);
+        pcoldinfo_now->pzerocopyhead = pdata;
     }
-    else if (memmode == LOGINMODE)
+    else
     {
-        SingletonBase<XMNMemPool<LoginInfoAll>>::GetInstance().DeAllocate(pdata);
+        ((XMNMsgHeader *)pcoldinfo_now->pzerocopytail)->pnext = pdata;
+    }
+    pcoldinfo_now->pzerocopytail = pdata;
+}
+
+void XMNConnSockInfo::FreeZeroCopyQueue(const bool &isall)
+{
+    XMNConnColdInfo *pcoldinfo_now = pcoldinfo;
+    if (pcoldinfo_now == nullptr)
+    {
+        return;
+    }
+    XMNMsgHeader *pmsgheader = nullptr;
+    while (pcoldinfo_now->pzerocopyhead != nullptr)
+    {
+        pmsgheader = (XMNMsgHeader *)pcoldinfo_now->pzerocopyhead;
+        /**
+         * 编号会回绕，所以用差值的符号来比较大小。
+        */
+        if (!isall && (int32_t)(pmsgheader->zerocopyid - pcoldinfo_now->zerocopydoneseq) >= 0)
+        {
+            break;
+        }
+        pcoldinfo_now->pzerocopyhead = pmsgheader->pnext;
+        FreeSendDataMem((char *)pmsgheader);
+        --nosendmsgcount;
+    }
+    if (pcoldinfo_now->pzerocopyhead == nullptr)
+    {
+        pcoldinfo_now->pzerocopytail = nullptr;
+    }
+}
+
+XMNConnColdInfo *XMNConnSockInfo::GetColdInfo()
+{
+    XMNConnColdInfo *pcoldinfo_now = pcoldinfo;
+    if (pcoldinfo_now != nullptr)
+    {
+        return pcoldinfo_now;
+    }
+
+    /**
+     * 多个线程可能同时申请，只有一个能够设置成功，其他的线程释放自己申请的冷数据。
+    */
+    XMNMemPool<XMNConnColdInfo> &coldpool = SingletonBase<XMNMemPool<XMNConnColdInfo>>::GetInstance();
+    XMNConnColdInfo *pcoldinfo_new = new (coldpool.Allocate()) XMNConnColdInfo(fd);
+    if (!pcoldinfo.compare_exchange_strong(pcoldinfo_now, pcoldinfo_new))
+    {
+        pcoldinfo_new->~XMNConnColdInfo();
+        coldpool.DeAllocate(pcoldinfo_new);
+        return pcoldinfo_now;
+    }
+    return pcoldinfo_new;
+}
+
+void XMNConnSockInfo::FreeColdInfo()
+{
+    XMNConnColdInfo *pcoldinfo_now = pcoldinfo.exchange(nullptr);
+    if (pcoldinfo_now != nullptr)
+    {
+        pcoldinfo_now->~XMNConnColdInfo();
+        SingletonBase<XMNMemPool<XMNConnColdInfo>>::GetInstance().DeAllocate(pcoldinfo_now);
+    }
+}
+
+XMNConnColdInfo::XMNConnColdInfo(const int &kSockFd)
+{
+    memset(this, 0, sizeof(struct XMNConnColdInfo));
+    socklen_t addrlen = sizeof(clientsockaddrinfo);
+    getpeername(kSockFd, &clientsockaddrinfo, &addrlen);
+    int r = pthread_mutex_init(&logicprocmutex_, nullptr);
+    if (r != 0)
+    {
+        XMNLogStdErr(0, "XMNConnColdInfo::XMNConnColdInfo() 调用 pthread_mutex_init 失败，错误代码：%d", r);
+    }
+    r = pthread_mutex_init(&streammutex_, nullptr);
+    if (r != 0)
+    {
+        XMNLogStdErr(0, "XMNConnColdInfo::XMNConnColdInfo() 调用 pthread_mutex_init 失败，错误代码：%d", r);
+    }
+}
+
+XMNConnColdInfo::~XMNConnColdInfo()
+{
+    /**
+     * 连接关闭时业务逻辑尚未处理的大包的包体块归还内存池。
+    */
+    XMNMemPool<XMNStreamChunk> &chunkpool = SingletonBase<XMNMemPool<XMNStreamChunk>>::GetInstance();
+    while (pstreamhead != nullptr)
+    {
+        char *pnext = ((XMNMsgHeader *)pstreamhead)->pnext;
+        chunkpool.DeAllocate(pstreamhead);
+        pstreamhead = pnext;
+    }
+    delete pstreamwriter;
+    int r = pthread_mutex_destroy(&logicprocmutex_);
+    if (r != 0)
+    {
+        XMNLogStdErr(0, "XMNConnColdInfo::~XMNConnColdInfo() 调用 pthread_mutex_destroy 失败，错误代码：%d", r);
+    }
+    r = pthread_mutex_destroy(&streammutex_);
+    if (r != 0)
+    {
+        XMNLogStdErr(0, "XMNConnColdInfo::~XMNConnColdInfo() 调用 pthread_mutex_destroy 失败，错误代码：%d", r);
     }
 }
 
+/**************************************************************************************
+ * 
+ ***************** XMNConnSlotTable 相关函数 **************** 
+ * 
+**************************************************************************************/
+XMNConnSlotTable::XMNConnSlotTable()
+{
+    pslots_ = nullptr;
+    slotcount_ = 0;
+    usedslotcount_ = 0;
+    nextunusedslot_ = 0;
+    pthread_mutex_init(&mutex_, nullptr);
+}
+
+XMNConnSlotTable::~XMNConnSlotTable()
+{
+    if (pslots_ != nullptr)
+    {
+        munmap(pslots_, slotcount_ * sizeof(XMNConnSockInfo));
+        pslots_ = nullptr;
+    }
+    pthread_mutex_destroy(&mutex_);
+}
+
+int XMNConnSlotTable::Create(const size_t &kSlotCount)
+{
+    if (kSlotCount == 0 || kSlotCount > XMN_CONN_SLOT_MAX || pslots_ != nullptr)
+    {
+        return -1;
+    }
+
+    /**
+     * 匿名映射的内存按页对齐，满足连接按 cache line 对齐的要求；
+     * 内容全部为 0 ，即：所有槽的代数均为 0 ；没有用到的槽不会被写入，也就不会占用物理内存。
+    */
+    void *pmem = mmap(nullptr, kSlotCount * sizeof(XMNConnSockInfo), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pmem == MAP_FAILED)
+    {
+        XMNLogStdErr(errno, "XMNConnSlotTable::Create 中 mmap 执行失败。");
+        return -1;
+    }
+    pslots_ = (XMNConnSockInfo *)pmem;
+    slotcount_ = kSlotCount;
+    return 0;
+}
+
+XMNConnSockInfo *XMNConnSlotTable::Allocate()
+{
+    /**
+     * （1）优先使用已经归还的槽，其次使用从未使用过的槽。
+    */
+    size_t index = 0;
+    {
+        XMNLockMutex slotmutex(&mutex_);
+        if (!vfreeslots_.empty())
+        {
+            index = vfreeslots_.back();
+            vfreeslots_.pop_back();
+        }
+        else if (nextunusedslot_ < slotcount_)
+        {
+            index = nextunusedslot_++;
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+    ++usedslotcount_;
+
+    /**
+     * （2）构造连接，代数在重新使用时继续递增，而不是随着构造函数清零。
+    */
+    XMNConnSockInfo *pconnsockinfo = pslots_ + index;
+    uint32_t generation = pconnsockinfo->generation;
+    pconnsockinfo = new (pconnsockinfo) XMNConnSockInfo();
+    pconnsockinfo->generation = generation;
+    pconnsockinfo->slotindex = (uint32_t)index;
+    return pconnsockinfo;
+}
+
+void XMNConnSlotTable::DeAllocate(XMNConnSockInfo *pconnsockinfo)
+{
+    if (pconnsockinfo == nullptr)
+    {
+        return;
+    }
+    XMNLockMutex slotmutex(&mutex_);
+    vfreeslots_.push_back(pconnsockinfo->slotindex);
+    --usedslotcount_;
+}
+
 /**************************************************************************************
  * 
  ***************** XMNSocket 相关函数 **************** 
@@ -139,11 +372,15 @@ XMNConnSockInfo *XMNSocket::PutOutConnSockInfofromPool(const int &kSockFd)
 {
     XMNLockMutex connsockpoolmutex(&connsock_pool_mutex_);
 
-    XMNConnSockInfo *pconnsockinfo = (XMNConnSockInfo *)SingletonBase<XMNMemPool<XMNConnSockInfo>>::GetInstance().Allocate();
-    pconnsockinfo = new (pconnsockinfo) XMNConnSockInfo();
+    XMNConnSockInfo *pconnsockinfo = SingletonBase<XMNConnSlotTable>::GetInstance().Allocate();
+    if (pconnsockinfo == nullptr)
+    {
+        return nullptr;
+    }
 
     pconnsockinfo->InitConnSockInfo();
     pconnsockinfo->fd = kSockFd;
+    pconnsockinfo->sendshardindex = kSockFd % sendthreadcount_;
 
     return pconnsockinfo;
 }
@@ -151,102 +388,119 @@ XMNConnSockInfo *XMNSocket::PutOutConnSockInfofromPool(const int &kSockFd)
 void XMNSocket::PutInConnSockInfo2Pool(XMNConnSockInfo *pconnsockinfo)
 {
     XMNLockMutex connsockinfomutex(&connsock_pool_mutex_);
+    {
+        XMNLockMutex sendmutex(&pconnsockinfo->sendmutex_);
+        queue_senddata_count_ -= pconnsockinfo->FreeSendQueue();
+    }
     pconnsockinfo->ClearConnSockInfo();
-    SingletonBase<XMNMemPool<XMNConnSockInfo>>::GetInstance().DeAllocate(pconnsockinfo);
+    SingletonBase<XMNConnSlotTable>::GetInstance().DeAllocate(pconnsockinfo);
     return;
 }
 
 void XMNSocket::PutInConnSockInfo2RecyList(XMNConnSockInfo *pconnsockinfo)
 {
-    XMNLockMutex connsockinfomutex(&connsock_pool_recycle_mutex_);
-
     /**
      * 防止连接被重复地放入连接回收池中。
     */
-    for (const auto &x : recycleconnsock_pool_)
+    if (pconnsockinfo->isretired.exchange(true))
+    {
+        return;
+    }
+
+    /**
+     * 连接关闭之后不再需要心跳监控。
+    */
+    if (pingenable_)
     {
-        if (x == pconnsockinfo)
+        CancelTimer(pconnsockinfo->pingtimerid);
+    }
+
+    ++pconnsockinfo->generation;
+    --vreactor_[pconnsockinfo->reactorindex]->conncount_;
+    {
+        XMNLockMutex connsockinfomutex(&connsock_pool_recycle_mutex_);
+        pconnsockinfo->retireepoch = SingletonBase<XMNEpoch>::GetInstance().CurrEpoch();
+        recycleconnsock_pool_.push_back(pconnsockinfo);
+
+        /**
+         * 回收链表由空变为非空时启动回收定时器。
+        */
+        if (pool_recyconnsock_count_++ == 0)
         {
-            return;
+            AddTimer(XMN_TIMER_WHEEL_TICK_MS, [this]() {
+                RecycleConnSockInfo();
+            });
         }
     }
 
-    pconnsockinfo->putinrecylisttime = time(nullptr);
-    ++pconnsockinfo->currsequence;
-    recycleconnsock_pool_.push_back(pconnsockinfo);
-    ++pool_recyconnsock_count_;
-
     --onlineuser_count_;
     return;
 }
 
-void *XMNSocket::ConnSockInfoRecycleThread(void *pthreadinfo)
+void XMNSocket::RecycleConnSockInfo()
 {
-    if (pthreadinfo == nullptr)
-    {
-        return nullptr;
-    }
-    ThreadInfo *pthreadinfo_n = (ThreadInfo *)pthreadinfo;
-    XMNSocket *pthis = pthreadinfo_n->pthis_;
-    XMNConnSockInfo *pconnsockinfo = nullptr;
-    while (true)
+    /**
+     * （1）尝试推进全局 epoch 。
+    */
+    const uint64_t kCurrEpoch = SingletonBase<XMNEpoch>::GetInstance().TryAdvance();
+
+    /**
+     * （2）归还所有已经没有线程能够访问的连接。
+    */
+    XMNLockMutex connsockinfomutex(&connsock_pool_recycle_mutex_);
+    std::list<XMNConnSockInfo *>::iterator it;
+    for (it = recycleconnsock_pool_.begin(); it != recycleconnsock_pool_.end();)
     {
-        usleep(200 * 1000);
-        if (pthis->pool_recyconnsock_count_)
+        XMNConnSockInfo *pconnsockinfo = *it;
+        if (pconnsockinfo->retireepoch + 2 > kCurrEpoch)
         {
-            time_t curtime = time(nullptr);
-            pthread_mutex_lock(&pthis->connsock_pool_recycle_mutex_);
-            std::list<XMNConnSockInfo *>::iterator it;
-            for (it = pthis->recycleconnsock_pool_.begin(); it != pthis->recycleconnsock_pool_.end();)
-            {
-                pconnsockinfo = *it;
-                if (!g_isquit && (curtime - pconnsockinfo->putinrecylisttime) < pthis->recyconnsockinfowaittime_)
-                {
-                    /**
-                     * 没有到时间 ，继续等待。
-                    */
-                    ++it;
-                    continue;
-                }
-                /**
-                 * 有到达等待时间的连接则回收。
-                */
-                if (pconnsockinfo->throwepollsendcount != 0)
-                {
-                    /**
-                     * 这种情况不应该发生，记录一下，以备寻找错误。
-                    */
-                    XMNLogStdErr(0, "XMNSocket::ConnSockInfoRecycleThread() 连接回收了throwepollsendcount!=0，不应该发生。");
-                }
-
-                it = pthis->recycleconnsock_pool_.erase(it);
-                --pthis->pool_recyconnsock_count_;
-                pthis->PutInConnSockInfo2Pool(pconnsockinfo);
-
-                //XMNLogStdErr(0,"connsockinfo is recycled.");
-            }
-            pthread_mutex_unlock(&pthis->connsock_pool_recycle_mutex_);
+            break;
         }
-        if (g_isquit)
+
+        /**
+         * 仍在发送连接队列中的连接，等发送数据线程将其取出之后再回收。
+        */
         {
-            if (pthis->pool_recyconnsock_count_)
+            XMNLockMutex sendmutex(&pconnsockinfo->sendmutex_);
+            if (pconnsockinfo->issendscheduled)
             {
-                pthread_mutex_lock(&pthis->connsock_pool_recycle_mutex_);
-                std::list<XMNConnSockInfo *>::iterator it;
-                for (it = pthis->recycleconnsock_pool_.begin(); it != pthis->recycleconnsock_pool_.end();)
-                {
-                    pconnsockinfo = *it;
-                    it = pthis->recycleconnsock_pool_.erase(it);
-                    --pthis->pool_recyconnsock_count_;
-                    pthis->PutInConnSockInfo2Pool(pconnsockinfo);
-                }
-                pthread_mutex_unlock(&pthis->connsock_pool_recycle_mutex_);
+                ++it;
+                continue;
             }
-            break;
         }
+        if (pconnsockinfo->throwepollsendcount != 0)
+        {
+            /**
+             * 这种情况不应该发生，记录一下，以备寻找错误。
+            */
+            XMNLogStdErr(0, "XMNSocket::RecycleConnSockInfo() 连接回收了throwepollsendcount!=0，不应该发生。");
+        }
+        it = recycleconnsock_pool_.erase(it);
+        --pool_recyconnsock_count_;
+        PutInConnSockInfo2Pool(pconnsockinfo);
     }
 
-    return nullptr;
+    /**
+     * （3）还有连接没有回收，下一个 tick 继续。
+    */
+    if (pool_recyconnsock_count_ > 0)
+    {
+        AddTimer(XMN_TIMER_WHEEL_TICK_MS, [this]() {
+            RecycleConnSockInfo();
+        });
+        WakeupReactors();
+    }
+}
+
+void XMNSocket::FreeRecycleConnSockInfo()
+{
+    XMNLockMutex connsockinfomutex(&connsock_pool_recycle_mutex_);
+    for (const auto &x : recycleconnsock_pool_)
+    {
+        PutInConnSockInfo2Pool(x);
+    }
+    recycleconnsock_pool_.clear();
+    pool_recyconnsock_count_ = 0;
 }
 
 void XMNSocket::CloseConnection(XMNConnSockInfo *pconnsockinfo)
@@ -255,7 +509,7 @@ void XMNSocket::CloseConnection(XMNConnSockInfo *pconnsockinfo)
      * 先回收连接的目的是防止 close 失败导致连接无法回收。
     */
     PutInConnSockInfo2Pool(pconnsockinfo);
-    if (close(pconnsockinfo->fd) == -1)
+    if (EventBackend(pconnsockinfo)->Close(pconnsockinfo) == -1)
     {
         XMNLogInfo(XMN_LOG_ALERT, errno, "CloseConnection 中 close (%d) 失败！", pconnsockinfo->fd);
     }
@@ -265,5 +519,5 @@ void XMNSocket::CloseConnection(XMNConnSockInfo *pconnsockinfo)
 
 size_t XMNSocket::ConnectPoolSize()
 {
-    return SingletonBase<XMNMemPool<XMNConnSockInfo>>::GetInstance().MemBlockCount();
+    return SingletonBase<XMNConnSlotTable>::GetInstance().SlotCount();
 }
\ No newline at end of file
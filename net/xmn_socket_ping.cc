@@ -1,176 +1,53 @@
 #include "comm/xmn_socket.h"
-#include "xmn_memory.h"
-#include "xmn_mempool.hpp"
-#include "xmn_lockmutex.hpp"
 #include "xmn_global.h"
 #include "xmn_func.h"
 
-int XMNSocket::PutInConnSockInfo2PingMultiMap(XMNConnSockInfo *pconnsockinfo)
+void XMNSocket::PutInConnSockInfo2PingTimer(XMNConnSockInfo *pconnsockinfo)
 {
-    XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
-    time_t nexttime = time(nullptr) + pingwaittime_;
-
-    XMNLockMutex pinglock(&ping_multimap_mutex_);
-    XMNMsgHeader *pmsgheader = (XMNMsgHeader *)SingletonBase<XMNMemPool<XMNMsgHeader>>::GetInstance().Allocate();
-    pmsgheader->currsequence = pconnsockinfo->currsequence;
-    pmsgheader->pconnsockinfo = pconnsockinfo;
-
-    ping_multimap_.insert(std::make_pair(nexttime, pmsgheader));
-    ++ping_multimap_count_;
-
-    ping_multimap_headtime_ = GetEarliestTime();
-    return 0;
-}
-
-time_t XMNSocket::GetEarliestTime()
-{
-    std::multimap<time_t, XMNMsgHeader *>::iterator it;
-    it = ping_multimap_.begin();
-    return it->first;
-}
-
-void *XMNSocket::PingThread(void *pthreadinfo)
-{
-    ThreadInfo *pthreadinfo_new = (ThreadInfo *)pthreadinfo;
-    XMNSocket *psocket = pthreadinfo_new->pthis_;
-
-    time_t current_time;
-    int err = 0;
-    while (!g_isquit)
-    {
-        if (psocket->ping_multimap_count_ > 0)
-        {
-            current_time = time(nullptr);
-            if (psocket->ping_multimap_headtime_ < current_time)
-            {
-                /**
-                 * 初步判断出存在某个连接有心跳通信超时的情况。
-                */
-                std::list<XMNMsgHeader *> timeoutpinglist;
-                XMNMsgHeader *pmsgheadertmp = nullptr;
-
-                err = pthread_mutex_lock(&psocket->ping_multimap_mutex_);
-                if (err != 0)
-                {
-                    XMNLogStdErr(err, "XMNSocket::PingThread()中pthread_mutex_lock()执行失败，返回值是 %d 。", err);
-                }
-                /**
-                 * 通过互斥量，将所有的心跳通信超时的连接揪出来。
-                */
-                while ((pmsgheadertmp = psocket->GetOverTimeMsgHeader(current_time)) != nullptr)
-                {
-                    timeoutpinglist.push_back(pmsgheadertmp);
-                }
-                err = pthread_mutex_unlock(&psocket->ping_multimap_mutex_);
-                if (err != 0)
-                {
-                    XMNLogStdErr(err, "XMNSocket::PingThread()pthread_mutex_unlock()执行失败，返回值是 %d 。", err);
-                }
-                while (!timeoutpinglist.empty())
-                {
-                    pmsgheadertmp = timeoutpinglist.front();
-                    timeoutpinglist.pop_front();
-                    /**
-                     * 具体的判断一下该连接是否通信超时并超过指定的时间，若是如此，则断开该连接。
-                    */
-                    psocket->PingTimeOutChecking(pmsgheadertmp, current_time);
-                }
-            }
-        }
-    }
-
-    return nullptr;
+    const XMNConnHandle kConnHandle = pconnsockinfo->Handle();
+    pconnsockinfo->pingtimerid = AddTimer(pingwaittime_ * 1000, [this, kConnHandle]() {
+        PingTimerHandler(kConnHandle);
+    });
 }
 
-XMNMsgHeader *XMNSocket::GetOverTimeMsgHeader(const time_t &currenttime)
+void XMNSocket::PingTimerHandler(const XMNConnHandle &kConnHandle)
 {
-    if (ping_multimap_count_ == 0)
+    /**
+     * （1）连接已经关闭，不再监控。
+    */
+    XMNConnSockInfo *pconnsockinfo = GetConnSockInfo(kConnHandle);
+    if (pconnsockinfo == nullptr)
     {
-        return nullptr;
+        return;
     }
-    XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
-    time_t earliesttime = GetEarliestTime();
-    XMNMsgHeader *pmsgheadertmp = nullptr;
-
-    if (earliesttime < currenttime)
-    {
-        /**
-         * 确实存在超时的连接，即：没有在指定的时间间隔内
-         * 完成心跳包的收发。
-        */
-        pmsgheadertmp = RemoveFirstMsgHeader();
 
-        /**
-         * 下次超时的时间依然需要判断，故需要更新时间并
-         * 重新加入到监控 multimap 中。
-        */
-        time_t newputinmultimaptime = currenttime + pingwaittime_;
-        XMNMsgHeader *pmsgheadertmp_new = (XMNMsgHeader *)SingletonBase<XMNMemPool<XMNMsgHeader>>::GetInstance().Allocate();
-        pmsgheadertmp_new->currsequence = pmsgheadertmp->currsequence;
-        pmsgheadertmp_new->pconnsockinfo = pmsgheadertmp->pconnsockinfo;
-        ping_multimap_.insert(std::make_pair(newputinmultimaptime, pmsgheadertmp_new));
-        ++ping_multimap_count_;
+    /**
+     * （2）先添加下一次的定时器，若本次检查关闭了该连接，关闭时会将其取消。
+    */
+    PutInConnSockInfo2PingTimer(pconnsockinfo);
 
-        if (ping_multimap_count_ > 0)
-        {
-            ping_multimap_headtime_ = GetEarliestTime();
-        }
-    }
-    return pmsgheadertmp;
+    /**
+     * （3）具体的判断一下该连接是否通信超时并超过指定的时间，若是如此，则断开该连接。
+    */
+    PingTimeOutChecking(pconnsockinfo, kConnHandle, time(nullptr));
 }
 
-XMNMsgHeader *XMNSocket::RemoveFirstMsgHeader()
+int XMNSocket::PingTimeOutChecking(XMNConnSockInfo *pconnsockinfo, const XMNConnHandle &kConnHandle, const time_t &kCurrentTime)
 {
-    if (ping_multimap_count_ == 0)
-    {
-        return nullptr;
-    }
-    XMNMsgHeader *pmsgheadertmp = nullptr;
-    std::multimap<time_t, XMNMsgHeader *>::iterator it;
-
-    it = ping_multimap_.begin();
-    pmsgheadertmp = it->second;
-    it = ping_multimap_.erase(it);
-    --ping_multimap_count_;
-    return pmsgheadertmp;
+    return 0;
 }
 
-int XMNSocket::PingTimeOutChecking(XMNMsgHeader *pmsgheader, time_t currenttime)
+uint64_t XMNSocket::AddTimer(const uint32_t &kDelayMs, const XMNTimerWheel::TimerHandler &kHandler)
 {
-    // XMNMemory *pmemory = SingletonBase<XMNMemory>::GetInstance();
-    // pmemory->FreeMemory(pmemory);
-    return 0;
+    return timerwheel_.AddTimer(kDelayMs, kHandler);
 }
 
-int XMNSocket::PutOutMsgHeaderFromMultiMap(XMNConnSockInfo *pconnsockinfo)
+int XMNSocket::CancelTimer(const uint64_t &kTimerId)
 {
-    XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
-    XMNLockMutex pinglock(&ping_multimap_mutex_);
-
-    std::multimap<time_t, XMNMsgHeader *>::iterator it;
-    for (it = ping_multimap_.begin(); it != ping_multimap_.end();)
-    {
-        if (it->second->pconnsockinfo == pconnsockinfo)
-        {
-            SingletonBase<XMNMemPool<XMNMsgHeader>>::GetInstance().DeAllocate(it->second);
-            it = ping_multimap_.erase(it);
-            --ping_multimap_count_;
-        }
-        ++it;
-    }
-
-    if (ping_multimap_count_ > 0)
-    {
-        ping_multimap_headtime_ = GetEarliestTime();
-    }
-
-    return 0;
+    return timerwheel_.CancelTimer(kTimerId);
 }
 
-void XMNSocket::FreePingMultiMap()
+void XMNSocket::TimerRequestHandler(XMNConnSockInfo *pconnsockinfo)
 {
-    // 由系统回收 SingletonBase<XMNMemPool<XMNMsgHeader>>::GetInstance() 的内存。
-    ping_multimap_count_ = 0;
-    ping_multimap_.clear();
-    std::multimap<time_t, XMNMsgHeader *>().swap(ping_multimap_);
-}
\ No newline at end of file
+    timerwheel_.ProcessExpired();
+}
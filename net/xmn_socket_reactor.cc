@@ -0,0 +1,102 @@
+#include "comm/xmn_socket.h"
+#include "xmn_global.h"
+#include "xmn_func.h"
+#include "xmn_epoch.h"
+#include "xmn_cpuaffinity.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+void *XMNSocket::ReactorThread(void *preactor)
+{
+    if (preactor == nullptr)
+    {
+        XMNLogStdErr(0, "XMNSocket::ReactorThread() 中形参 preactor 为 nullptr 。");
+        return nullptr;
+    }
+
+    Reactor *preactor_new = (Reactor *)preactor;
+    XMNSocket *psocket = preactor_new->pthis_;
+
+    /**
+     * 开启了 CPU 绑定时，将本线程从继承的业务逻辑的核上移到该事件循环的核上。
+    */
+    XMNCpuAffinity &cpuaffinity = SingletonBase<XMNCpuAffinity>::GetInstance();
+    if (cpuaffinity.IsEnabled())
+    {
+        cpuaffinity.BindEventLoop(preactor_new->index_);
+    }
+
+    /**
+     * 一直堵塞直至有事件发生，退出时由 EndWorker 通过 eventfd 唤醒。
+    */
+    while (!g_isquit)
+    {
+        if (psocket->ReactorProcessEvents(preactor_new, -1) < 0)
+        {
+            XMNLogStdErr(0, "XMNSocket::ReactorThread() 中编号为 %d 的 reactor 处理事件失败。", (int)preactor_new->index_);
+        }
+    }
+    return nullptr;
+}
+
+void XMNSocket::ReactorWakeupHandler(XMNConnSockInfo *pconnsockinfo)
+{
+    uint64_t wakeup = 0;
+    if (read(pconnsockinfo->fd, &wakeup, sizeof(wakeup)) != sizeof(wakeup) && errno != EAGAIN)
+    {
+        XMNLogStdErr(errno, "XMNSocket::ReactorWakeupHandler() 中 read(eventfd) 执行失败。");
+    }
+}
+
+size_t XMNSocket::SelectReactor()
+{
+    /**
+     * （1）没有 reactor 线程时，连接由主事件循环处理。
+    */
+    if (vreactor_.size() <= 1)
+    {
+        return 0;
+    }
+
+    /**
+     * （2）按照最少连接数分配，连接数相同时取下标最小的。
+    */
+    if (reactordispatchmode_ == XMN_REACTOR_DISPATCH_LEASTCONN)
+    {
+        size_t index = 1;
+        size_t mincount = vreactor_[1]->conncount_;
+        for (size_t i = 2; i < vreactor_.size(); ++i)
+        {
+            const size_t kCount = vreactor_[i]->conncount_;
+            if (kCount < mincount)
+            {
+                mincount = kCount;
+                index = i;
+            }
+        }
+        return index;
+    }
+
+    /**
+     * （3）轮流分配，只在主事件循环中调用，不需要加锁。
+    */
+    reactornext_ = reactornext_ % (vreactor_.size() - 1) + 1;
+    return reactornext_;
+}
+
+void XMNSocket::WakeupReactors()
+{
+    uint64_t wakeup = 1;
+    for (const auto &x : vreactor_)
+    {
+        if (x->wakeupfd_ == -1)
+        {
+            continue;
+        }
+        if (write(x->wakeupfd_, &wakeup, sizeof(wakeup)) != sizeof(wakeup) && errno != EAGAIN)
+        {
+            XMNLogStdErr(errno, "XMNSocket::WakeupReactors() 中 write(eventfd) 执行失败。");
+        }
+    }
+}
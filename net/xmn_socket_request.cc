@@ -6,118 +6,97 @@
 #include "xmn_lockmutex.hpp"
 #include "xmn_global.h"
 #include "xmn_mempool.hpp"
+#include "xmn_crc32.h"
 
 #include <errno.h>
 #include <arpa/inet.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 void XMNSocket::WaitReadRequestHandler(XMNConnSockInfo *pconnsockinfo)
 {
     /**
-     * （1）从接收缓冲区中取数据。
+     * （1）连接第一次收到数据时为其申请接收缓冲区。
     */
-    ssize_t recvcount = RecvData(pconnsockinfo);
-    if (recvcount <= 0)
+    if (!pconnsockinfo->recvringbuff.IsCreated())
     {
-        return;
+        if (pconnsockinfo->recvringbuff.Create(recvbuffsize_) != 0)
+        {
+            /**
+             * TODO：申请内存失败的情况怎么处理暂时没有想好，先返回。
+            */
+            XMNLogStdErr(0, "XMNSocket::WaitReadRequestHandler 中申请接收缓冲区失败。");
+            return;
+        }
     }
 
-    /****************************************************
-     * 
-     * 程序走到了这里，说明确实收到了数据。
-     * 下面是一组状态机的实现，用于保证接收到的数据是完整的。
-     * 
-    ****************************************************/
     /**
-     * （2）开始接收包头数据。
+     * ET 模式下，需要循环接收直至 RecvData 返回 EAGAIN ，否则剩余的数据不会再触发 epoll 事件。
+     * LT 模式下，每次只接收一次，剩余的数据由下一次 epoll_wait 驱动。
+     * io_uring 后端中，完成事件携带的数据必须在本次全部取走。
     */
-    //XMNLogStdErr(0, "Data is arrived.");
-    if (pconnsockinfo->recvstatus == PKG_HD_INIT)
+    ssize_t recvcount = 0;
+    do
     {
         /**
-         * 完整地接收到了包头数据。
+         * （2）一次 recv 尽量填满接收缓冲区。
         */
-        if (recvcount == kPkgHeaderLen_)
+        recvcount = RecvData(pconnsockinfo);
+        if (recvcount <= 0)
         {
-            WaitRequestHandlerHeader(pconnsockinfo);
+            break;
         }
+
         /**
-         * 接收的数据不足一个包头的长度，需要为下次接收数据做准备。
+         * （3）取出接收缓冲区中所有完整的包，不完整的包留待下次接收。
         */
-        else
-        {
-            pconnsockinfo->recvstatus = PKG_HD_RECVING;
-            pconnsockinfo->precvdatastart += recvcount;
-            pconnsockinfo->recvdatalen -= recvcount;
-        }
-    }
+        ParseRecvRingBuffer(pconnsockinfo);
 
-    /**
-     * （2）上回包头数据没有接收完整，现在继续接收包头数据。
-    */
-    else if (pconnsockinfo->recvstatus == PKG_HD_RECVING)
-    {
         /**
-         * 包头接收完毕。
+         * 处理包时可能因为 flood 攻击等原因关闭了连接，此时不能再继续接收。
+         * 暂停接收之后 ET 模式下也不再继续 recv ，但 io_uring 后端已经完成的数据仍需取走。
         */
-        if (pconnsockinfo->recvdatalen == recvcount)
-        {
-            WaitRequestHandlerHeader(pconnsockinfo);
-        }
-        else
-        {
-            pconnsockinfo->recvstatus = PKG_HD_RECVING;
-            pconnsockinfo->precvdatastart += recvcount;
-            pconnsockinfo->recvdatalen -= recvcount;
-        }
-    }
-
-    /**
-     * （3）包头数据接收完整了，现在开始接收包体数据。
-    */
-    else if (pconnsockinfo->recvstatus == PKG_BD_INIT)
-    {
-        if (pconnsockinfo->recvdatalen == recvcount)
-        {
-            WaitRequestHandlerBody(pconnsockinfo);
-        }
-        else
-        {
-            pconnsockinfo->recvstatus = PKG_BD_RECVING;
-            pconnsockinfo->precvdatastart += recvcount;
-            pconnsockinfo->recvdatalen -= recvcount;
-        }
-    }
+    } while (((epolletenable_ && !pconnsockinfo->isrecvpaused) || pconnsockinfo->readydatalen > 0) && pconnsockinfo->fd != -1);
 
     /**
-     * （4）上回包体数据没有接收完整，现在继续接收包体数据。
+     * （4）所有的包都已取走时将接收缓冲区归还给缓冲池，空闲的连接不占用接收缓冲区。
+     * 只剩半个包时保留缓冲区，等待该包的剩余部分。
+     * 已关闭的连接由 ClearConnSockInfo 释放。
     */
-    else if (pconnsockinfo->recvstatus == PKG_BD_RECVING)
+    if (pconnsockinfo->fd != -1 && pconnsockinfo->recvringbuff.Size() == 0)
     {
-        if (pconnsockinfo->recvdatalen == recvcount)
-        {
-            WaitRequestHandlerBody(pconnsockinfo);
-        }
-        else
-        {
-            pconnsockinfo->recvstatus = PKG_BD_RECVING;
-            pconnsockinfo->precvdatastart += recvcount;
-            pconnsockinfo->recvdatalen -= recvcount;
-        }
+        pconnsockinfo->recvringbuff.Destroy();
     }
-
     return;
 }
 
 ssize_t XMNSocket::RecvData(XMNConnSockInfo *pconnsockinfo)
 {
     ssize_t n = 0;
-    char *pbuff = pconnsockinfo->precvdatastart;
-    const size_t kBuffLen = pconnsockinfo->recvdatalen;
+    struct iovec iov[2];
     /**
-     * （1）接收数据。
+     * 解析之后接收缓冲区中最多剩下一个不完整的包，而缓冲区至少能容纳一个最大的包，所以正常情况下一定有空闲空间。
+     * 缓冲区已满说明解析没有取走完整的包，此时 recv 会返回 0 而被误认为对端关闭，所以单独处理，断开连接。
     */
-    n = recv(pconnsockinfo->fd, pbuff, kBuffLen, 0);
+    const int kIovCnt = pconnsockinfo->recvringbuff.WritableIov(iov);
+    if (kIovCnt == 0)
+    {
+        XMNLogStdErr(0, "XMNSocket::RecvData 中接收缓冲区已满，断开连接。");
+        ActivelyCloseSocket(pconnsockinfo);
+        return -1;
+    }
+    /**
+     * （1）接收数据，空闲空间回绕时分为两段，仍然只需要一次系统调用。
+    */
+    do
+    {
+        n = EventBackend(pconnsockinfo)->Recv(pconnsockinfo, iov, kIovCnt);
+        /**
+         * recv 被信号中断时直接重试，ET 模式下若此时返回，剩余的数据将不会再触发事件。
+        */
+    } while (n < 0 && errno == EINTR);
 
     /**
      * （2）对 recv 的返回值进行判断处理。
@@ -128,10 +107,14 @@ ssize_t XMNSocket::RecvData(XMNConnSockInfo *pconnsockinfo)
          * 客户端已正常关闭，即：完成了 4 次挥手。
          * send()的返回值为 0 时，也是在这里回收连接的。
         */
-        if (close(pconnsockinfo->fd) == -1)
+        if (EventBackend(pconnsockinfo)->Close(pconnsockinfo) == -1)
         {
             XMNLogStdErr(0, "XMNSocket::RecvData 中 close 执行失败。");
         }
+        /**
+         * 标记连接已关闭，防止该 fd 被新连接复用之后，其他线程再次关闭它。
+        */
+        pconnsockinfo->fd = -1;
         //CloseConnection(pconnsockinfo);
         //XMNLogStdErr(0,"connsockinfo put in recylist.");
         /**
@@ -149,15 +132,10 @@ ssize_t XMNSocket::RecvData(XMNConnSockInfo *pconnsockinfo)
         int err = errno;
         if (err == EAGAIN || err == EWOULDBLOCK)
         {
-            XMNLogStdErr(err, "XMNSocket::RecvData() 返回了 EAGAIN 或者 EWOULDBLOCK 错误。");
-            return 0;
-        }
-        /**
-         * recv 函数被中断，不是错误。
-        */
-        else if (err == EINTR)
-        {
-            XMNLogInfo(XMN_LOG_ALERT, err, "XMNSocket::RecvData() 返回了 EINTR 错误。");
+            if (!epolletenable_)
+            {
+                XMNLogStdErr(err, "XMNSocket::RecvData() 返回了 EAGAIN 或者 EWOULDBLOCK 错误。");
+            }
             return 0;
         }
         /**
@@ -177,10 +155,11 @@ ssize_t XMNSocket::RecvData(XMNConnSockInfo *pconnsockinfo)
             XMNLogStdErr(err, "XMNSocket::RecvData() 返回了未知错误。");
         }
 
-        if (close(pconnsockinfo->fd) == -1)
+        if (EventBackend(pconnsockinfo)->Close(pconnsockinfo) == -1)
         {
             XMNLogStdErr(0, "XMNSocket::RecvData 中 close 执行失败。");
         }
+        pconnsockinfo->fd = -1;
         //CloseConnection(pconnsockinfo);
         XMNLogStdErr(0, "pconnsockinfo put in recylist.");
         /**
@@ -190,118 +169,246 @@ ssize_t XMNSocket::RecvData(XMNConnSockInfo *pconnsockinfo)
         return -1;
     }
 
+    pconnsockinfo->recvringbuff.Produce(n);
     return n;
 }
 
-void XMNSocket::WaitRequestHandlerHeader(XMNConnSockInfo *pconnsockinfo)
+void XMNSocket::ParseRecvRingBuffer(XMNConnSockInfo *pconnsockinfo)
 {
-    /**
-     * （1）判断该包是否正常，若不正常则直接将状态机复原为初始状态。
-    */
+    XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
+    XMNRingBuffer &recvringbuff = pconnsockinfo->recvringbuff;
+    char *pmsgs[XMN_RECV_BATCH_MAX_MSGS];
+    size_t msgcount = 0;
+    bool isflood = false;
+    bool isclose = false;
+    XMNPkgHeader pkgheader;
     unsigned short pkglen = 0;
-    XMNPkgHeader *ppkgheader = (XMNPkgHeader *)pconnsockinfo->precvdatastart;
-    pkglen = ntohs(ppkgheader->pkglen);
-    if ((pkglen < kPkgHeaderLen_) || (pkglen > PKG_MAX_LEN))
-    {
-        pconnsockinfo->recvstatus = PKG_HD_INIT;
-        pconnsockinfo->precvdatastart = pconnsockinfo->dataheader;
-        pconnsockinfo->recvdatalen = kPkgHeaderLen_;
-    }
-    else
+    XMNConnColdInfo *pcoldinfo = pconnsockinfo->pcoldinfo;
+
+    while (true)
     {
         /**
-        * （2）为包体分配内存并设置相关变量。
+         * （0）正在接收大包时，缓冲区中的数据都属于该包的包体，按块交给业务逻辑。
         */
-        XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
-        char *pbuffall = (char *)memory.AllocMemory(kMsgHeaderLen_ + pkglen, false);
-        if (pbuffall == nullptr)
+        if (pcoldinfo != nullptr && pcoldinfo->streambodylen > 0)
+        {
+            if (ParseStreamBody(pconnsockinfo, pcoldinfo) != 0)
+            {
+                isclose = true;
+                break;
+            }
+            if (pcoldinfo->streambodylen > 0)
+            {
+                break;
+            }
+            continue;
+        }
+        if (recvringbuff.Size() < kPkgHeaderLen_)
+        {
+            break;
+        }
+
+        /**
+         * （1）判断该包是否正常，若不正常则丢弃该包头。
+         * 包头可能跨越缓冲区的末尾，所以拷贝出来再解析。
+        */
+        recvringbuff.Peek((char *)&pkgheader, kPkgHeaderLen_);
+        pkglen = ntohs(pkgheader.pkglen);
+        if (pkglen == XMN_PKG_EXT_MARK)
         {
             /**
-             * TODO：申请内存失败的情况怎么处理暂时没有想好，先返回。
+             * 扩展包头：等待整个扩展包头到达之后检查包体的长度，超过上限说明 client 异常，断开连接。
+             * 合法的大包只记录解析状态，包体在 （0） 中按块处理。
             */
-            return;
+            if (recvringbuff.Size() < sizeof(XMNPkgHeaderExt))
+            {
+                break;
+            }
+            XMNPkgHeaderExt pkgheaderext;
+            recvringbuff.Read((char *)&pkgheaderext, sizeof(XMNPkgHeaderExt));
+            const uint32_t kBodyLen = ntohl(pkgheaderext.bodylen);
+            if (kBodyLen == 0 || kBodyLen > pkgmaxbodylen_)
+            {
+                XMNLogInfo(XMN_LOG_INFO, 0, "连接发送的大包的包体长度（%d）为 0 或者超过了上限，断开连接。", (int)kBodyLen);
+                isclose = true;
+                break;
+            }
+            if (floodattackmonitorenable_ && TestFlood(pconnsockinfo))
+            {
+                isflood = true;
+                break;
+            }
+            pcoldinfo = pconnsockinfo->GetColdInfo();
+            pcoldinfo->streambodylen = kBodyLen;
+            pcoldinfo->streamoffset = 0;
+            pcoldinfo->streammsgcode = ntohs(pkgheaderext.msgcode);
+            pcoldinfo->streamcrc32 = (int)ntohl(pkgheaderext.crc32);
+            pcoldinfo->streamcrcnow = 0;
+            continue;
+        }
+        if ((pkglen < kPkgHeaderLen_) || (pkglen > PKG_MAX_LEN))
+        {
+            recvringbuff.Consume(kPkgHeaderLen_);
+            continue;
         }
-        pconnsockinfo->precvalldata = pbuffall;
-        pconnsockinfo->isfree = true;
 
         /**
-         * a、处理消息头。
+         * （2）包体尚未接收完整，留待下次接收。
         */
-        XMNMsgHeader *pmsgheader = (XMNMsgHeader *)pbuffall;
-        pmsgheader->pconnsockinfo = pconnsockinfo;
-        pmsgheader->currsequence = pconnsockinfo->currsequence;
+        if (recvringbuff.Size() < pkglen)
+        {
+            break;
+        }
 
         /**
-         * b、处理包头。
+         * （3）为整个消息分配内存，即：消息头 + 包头 + 包体。
         */
-        pbuffall += kMsgHeaderLen_;
-        XMNPkgHeader *ppkgheadertmp = (XMNPkgHeader *)pbuffall;
-        memcpy(ppkgheadertmp, ppkgheader, sizeof(XMNPkgHeader) * 1);
+        char *pbuffall = (char *)memory.AllocMemory(kMsgHeaderLen_ + pkglen, false);
+        if (pbuffall == nullptr)
+        {
+            /**
+             * 完整的包留在缓冲区中时，ET 模式和 io_uring 后端会继续接收直至缓冲区被填满，
+             * 所以不能留待下次处理，断开连接。
+            */
+            XMNLogStdErr(0, "XMNSocket::ParseRecvRingBuffer 中申请内存失败，断开连接。");
+            isclose = true;
+            break;
+        }
+        XMNMsgHeader *pmsgheader = (XMNMsgHeader *)pbuffall;
+        pmsgheader->connhandle = pconnsockinfo->Handle();
+        recvringbuff.Read(pbuffall + kMsgHeaderLen_, pkglen);
 
         /**
-         * 处理 client 向 server 仅仅发送包头的情况。
+         * （4）flood 检测，若是 flood 攻击，则丢弃剩余的数据并断开连接。
         */
-        if (pkglen == kPkgHeaderLen_)
+        if (floodattackmonitorenable_ && TestFlood(pconnsockinfo))
         {
-            WaitRequestHandlerBody(pconnsockinfo);
+            memory.FreeMemory(pbuffall);
+            isflood = true;
+            break;
         }
 
         /**
-         * c、更新状态机。
+         * （5）攒够一批之后再压入消息队列中，减少加锁和唤醒线程的次数。
         */
-        else
+        pmsgs[msgcount++] = pbuffall;
+        if (msgcount == XMN_RECV_BATCH_MAX_MSGS)
         {
-            pconnsockinfo->recvstatus = PKG_BD_INIT;
-            pconnsockinfo->precvdatastart = pbuffall + kPkgHeaderLen_;
-            pconnsockinfo->recvdatalen = pkglen - kPkgHeaderLen_;
+            pconnsockinfo->recvmsgcount += msgcount;
+            g_threadpool.PutInRecvDataQueue_Signal(pmsgs, msgcount);
+            msgcount = 0;
         }
     }
 
-    return;
+    /**
+     * （6）将剩余的包压入消息队列中。
+    */
+    if (msgcount > 0)
+    {
+        /**
+         * TODO：返回值为-1暂时没有想好怎么处理。
+        */
+        pconnsockinfo->recvmsgcount += msgcount;
+        g_threadpool.PutInRecvDataQueue_Signal(pmsgs, msgcount);
+    }
+
+    if (isflood || isclose)
+    {
+        //XMNLogStdErr(0, "该连接存在恶意攻击，已断开连接。");
+        ActivelyCloseSocket(pconnsockinfo);
+        return;
+    }
+
+    /**
+     * （7）该连接或者 worker 进程积压过多时暂停接收，而不是等到积压超过上限时断开连接。
+    */
+    if (backpressureenable_ && !pconnsockinfo->isrecvpaused)
+    {
+        XMNLockMutex sendmutex(&pconnsockinfo->sendmutex_);
+        PauseRecv(pconnsockinfo);
+    }
 }
 
-void XMNSocket::WaitRequestHandlerBody(XMNConnSockInfo *pconnsockinfo)
+int XMNSocket::ParseStreamBody(XMNConnSockInfo *pconnsockinfo, XMNConnColdInfo *pcoldinfo)
 {
-    bool isflood = false;
-    if (floodattackmonitorenable_)
+    XMNRingBuffer &recvringbuff = pconnsockinfo->recvringbuff;
+    XMNMemPool<XMNStreamChunk> &chunkpool = SingletonBase<XMNMemPool<XMNStreamChunk>>::GetInstance();
+    XMNCRC32 &crc32 = SingletonBase<XMNCRC32>::GetInstance();
+
+    while (recvringbuff.Size() > 0 && pcoldinfo->streamoffset < pcoldinfo->streambodylen)
     {
-        isflood = TestFlood(pconnsockinfo);
-        if (isflood)
-        {
-            XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
-            memory.FreeMemory(pconnsockinfo->precvalldata);
-        }
-        else
+        /**
+         * （1）取出本次能取出的最多一块数据，同时更新整个包体的 CRC32 校验值。
+        */
+        size_t datalen = pcoldinfo->streambodylen - pcoldinfo->streamoffset;
+        datalen = std::min(datalen, recvringbuff.Size());
+        datalen = std::min(datalen, (size_t)XMN_STREAM_CHUNK_SIZE);
+
+        XMNStreamChunk *pchunk = (XMNStreamChunk *)chunkpool.Allocate();
+        pchunk->msgheader.connhandle = pconnsockinfo->Handle();
+        pchunk->msgheader.pnext = nullptr;
+        pchunk->msgcode = pcoldinfo->streammsgcode;
+        pchunk->bodylen = pcoldinfo->streambodylen;
+        pchunk->offset = pcoldinfo->streamoffset;
+        pchunk->datalen = datalen;
+        recvringbuff.Read(pchunk->data, datalen);
+        pcoldinfo->streamcrcnow = crc32.UpdateCRC32(pcoldinfo->streamcrcnow, (unsigned char *)pchunk->data, datalen);
+        pcoldinfo->streamoffset += datalen;
+        pchunk->islast = (pcoldinfo->streamoffset == pcoldinfo->streambodylen);
+        pchunk->iscrcok = pchunk->islast && ((int)pcoldinfo->streamcrcnow == pcoldinfo->streamcrc32);
+
+        /**
+         * （2）放入该连接的包体块链表中，链表没有被处理时才向线程池投递处理消息，
+         * 保证各块按顺序处理，同时不会为每一块都唤醒一次线程池。
+        */
+        bool isschedule = false;
         {
+            XMNLockMutex streammutex(&pcoldinfo->streammutex_);
+
             /**
-             * （1）将接收的数据压入消息队列中。
-            */
-            /**
-             * TODO：返回值为-1暂时没有想好怎么处理。
+             * 开启背压时，积压达到 XMN_STREAM_MAX_PENDING_CHUNKS 之后由 ParseRecvRingBuffer 暂停接收，
+             * 暂停之前已经收到的数据仍然放入链表，超过 streammaxpendingchunks_ 说明 client 异常，断开连接。
             */
-            g_threadpool.PutInRecvDataQueue_Signal(pconnsockinfo->precvalldata);
+            if (pcoldinfo->streamchunkcount >= streammaxpendingchunks_)
+            {
+                chunkpool.DeAllocate(pchunk);
+                XMNLogInfo(XMN_LOG_INFO, 0, "连接积压的大包的数据块超过了 %d 个，断开连接。", (int)streammaxpendingchunks_);
+                return -1;
+            }
+            if (pcoldinfo->pstreamtail == nullptr)
+            {
+                pcoldinfo->pstreamhead = (char *)pchunk;
+            }
+            else
+            {
+                ((XMNMsgHeader *)pcoldinfo->pstreamtail)->pnext = (char *)pchunk;
+            }
+            pcoldinfo->pstreamtail = (char *)pchunk;
+            ++pcoldinfo->streamchunkcount;
+            if (!pcoldinfo->isstreamscheduled)
+            {
+                pcoldinfo->isstreamscheduled = true;
+                isschedule = true;
+            }
+        }
+        /**
+         * 投递失败时之后的块不会再投递，已经积压的块无法处理，断开连接，积压的块随冷数据一起释放。
+        */
+        if (isschedule && PutInInnerMsg(pconnsockinfo, XMN_INNER_MSG_STREAM_CHUNKS) != 0)
+        {
+            return -1;
         }
     }
 
     /**
-     * （2）更新状态机至初始状态。
+     * （3）包体接收完毕，之后的数据按普通的包解析。
     */
-    pconnsockinfo->isfree = false;
-    pconnsockinfo->recvstatus = PKG_HD_INIT;
-    pconnsockinfo->precvdatastart = pconnsockinfo->dataheader;
-    pconnsockinfo->recvdatalen = kPkgHeaderLen_;
-    //connsockinfo->precvalldata = nullptr;
-
-    /**
-     * （3）若是 flood 攻击，则断开连接。
-    */
-    if (isflood)
+    if (pcoldinfo->streamoffset == pcoldinfo->streambodylen)
     {
-        //XMNLogStdErr(0, "该连接存在恶意攻击，已断开连接。");
-        ActivelyCloseSocket(pconnsockinfo);
+        pcoldinfo->streambodylen = 0;
+        pcoldinfo->streamoffset = 0;
     }
-
-    return;
+    return 0;
 }
 
 void XMNSocket::ThreadRecvProcFunc(char *pmsgbuf)
@@ -309,31 +416,118 @@ void XMNSocket::ThreadRecvProcFunc(char *pmsgbuf)
     ;
 }
 
-void XMNSocket::WaitWriteRequestHandler(XMNConnSockInfo *pconnsockinfo)
+void XMNSocket::HandleStreamChunk(XMNStreamChunk *pchunk)
 {
-    XMNMemory &memory = SingletonBase<XMNMemory>::GetInstance();
+    ;
+}
+
+int XMNSocket::PutInInnerMsg(XMNConnSockInfo *pconnsockinfo, const uint16_t &kType)
+{
+    char *pmsgbuf = (char *)SingletonBase<XMNMemory>::GetInstance().AllocMemory(kMsgHeaderLen_ + kPkgHeaderLen_, false);
+    if (pmsgbuf == nullptr)
+    {
+        XMNLogStdErr(0, "XMNSocket::PutInInnerMsg 中申请内存失败。");
+        return -1;
+    }
+    ((XMNMsgHeader *)pmsgbuf)->connhandle = pconnsockinfo->Handle();
+    XMNPkgHeader *ppkgheader = (XMNPkgHeader *)(pmsgbuf + kMsgHeaderLen_);
+    ppkgheader->pkglen = 0;
+    ppkgheader->msgcode = htons(kType);
+    ppkgheader->crc32 = 0;
+    ++pconnsockinfo->recvmsgcount;
+    g_threadpool.PutInRecvDataQueue_Signal(pmsgbuf);
+    return 0;
+}
+
+void XMNSocket::ThreadInnerProcFunc(char *pmsgbuf)
+{
+    XMNConnSockInfo *pconnsockinfo = GetConnSockInfo(((XMNMsgHeader *)pmsgbuf)->connhandle);
+    const uint16_t kType = ntohs(((XMNPkgHeader *)(pmsgbuf + kMsgHeaderLen_))->msgcode);
+    SingletonBase<XMNMemory>::GetInstance().FreeMemory(pmsgbuf);
+
     /**
-     * （1）发送消息。
+     * 连接已经关闭时，积压的包体块和流式发送对象在释放冷数据时一起释放。
     */
-    ssize_t sendsize = SendData(pconnsockinfo);
+    if (pconnsockinfo == nullptr || pconnsockinfo->pcoldinfo == nullptr)
+    {
+        return;
+    }
+    if (kType == XMN_INNER_MSG_STREAM_CHUNKS)
+    {
+        ProcessStreamChunks(pconnsockinfo);
+    }
+    else if (kType == XMN_INNER_MSG_WRITABLE)
+    {
+        ProcessWritable(pconnsockinfo);
+    }
+}
+
+void XMNSocket::ProcessStreamChunks(XMNConnSockInfo *pconnsockinfo)
+{
+    XMNMemPool<XMNStreamChunk> &chunkpool = SingletonBase<XMNMemPool<XMNStreamChunk>>::GetInstance();
+    XMNConnColdInfo *pcoldinfo = pconnsockinfo->pcoldinfo;
 
     /**
-     * （2）对发送数据的结果进行处理。
+     * 每次只在锁内取出一块，处理时不持有锁，事件循环可以同时放入新的块。
+     * 链表取空时清除投递标记，之后到达的块由事件循环重新投递。
     */
-    if (sendsize > 0 && sendsize != pconnsockinfo->senddatalen)
+    bool isresume = false;
+    while (true)
     {
+        XMNStreamChunk *pchunk = nullptr;
+        {
+            XMNLockMutex streammutex(&pcoldinfo->streammutex_);
+            pchunk = (XMNStreamChunk *)pcoldinfo->pstreamhead;
+            if (pchunk == nullptr)
+            {
+                pcoldinfo->isstreamscheduled = false;
+                break;
+            }
+            pcoldinfo->pstreamhead = pchunk->msgheader.pnext;
+            if (pcoldinfo->pstreamhead == nullptr)
+            {
+                pcoldinfo->pstreamtail = nullptr;
+            }
+            --pcoldinfo->streamchunkcount;
+            isresume = (pcoldinfo->streamchunkcount <= XMN_STREAM_RESUME_CHUNKS);
+        }
+        HandleStreamChunk(pchunk);
+        chunkpool.DeAllocate(pchunk);
+
         /**
-         * 发送成功，但是没有发全，下次继续发送。
+         * 积压的块降到低水位时检查是否需要恢复接收，不在 streammutex_ 中加锁 sendmutex_ 。
         */
-        pconnsockinfo->psenddata = pconnsockinfo->psenddata + sendsize;
-        pconnsockinfo->senddatalen = pconnsockinfo->senddatalen - sendsize;
-        return;
+        if (isresume && pconnsockinfo->isrecvpaused)
+        {
+            XMNLockMutex sendmutex(&pconnsockinfo->sendmutex_);
+            ResumeRecv(pconnsockinfo);
+        }
     }
-    else if (sendsize > 0 && sendsize == pconnsockinfo->senddatalen)
+}
+
+void XMNSocket::WaitWriteRequestHandler(XMNConnSockInfo *pconnsockinfo)
+{
+    int r = 0;
     {
+        XMNLockMutex sendmutex(&pconnsockinfo->sendmutex_);
         /**
-         * 发送成功且发全。
-         * 在 epoll 红黑树中删掉该 socket 。
+         * （1）发送待发送消息链表中所有的消息。
+         * ET 模式下，EPOLLOUT 只在可写状态变化时通知一次，FlushSendQueue 会一直发送，直至发完或者发送缓冲区已满。
+        */
+        r = FlushSendQueue(pconnsockinfo);
+        if (r == 1)
+        {
+            /**
+             * 发送缓冲区又满了，等待下一次 EPOLLOUT 通知。
+            */
+            return;
+        }
+
+        /**
+         * （2）执行到这里有如下情况。
+         * a、数据完整地发送完毕。
+         * b、对端断开连接或者未知错误。
+         * 在 epoll 红黑树中去掉 EPOLLOUT ，之后的消息再由发送数据线程直接发送。
         */
         if (EpollOperationEvent(pconnsockinfo->fd,
                                 EPOLL_CTL_MOD,
@@ -343,46 +537,16 @@ void XMNSocket::WaitWriteRequestHandler(XMNConnSockInfo *pconnsockinfo)
         {
             XMNLogStdErr(0, "XMNSocket::WaitWriteRequestHandler()中EpollOperationEvent()执行失败。");
         }
-        XMNLogStdErr(0, "XMNSocket::WaitWriteRequestHandler()发送数据完毕。");
-    }
-    else if (sendsize == -1)
-    {
-        /**
-         * 发送缓冲区已满不太可能，因为 epoll 驱动通知系统可以发送，
-         * 结果发送缓冲区已满，不正常。
-        */
-        XMNLogStdErr(0, "XMNSocket::WaitWriteRequestHandler()执行 SendData 时发现发送缓冲区已满的问题。");
-        return;
-    }
-    else if (sendsize == -2)
-    {
-        XMNLogStdErr(0, "XMNSocket::WaitWriteRequestHandler()执行 SendData 时发生了未知错误。");
+        pconnsockinfo->throwepollsendcount = 0;
     }
 
-    /**
-     * （3）执行到这里有如下情况。
-     * a、数据完整地发送完毕。
-     * b、对端断开连接，回收连接。
-     * c、未知错误。
-    */
-    /**
-     * 增加信号量。
-    */
-    if (sem_post(&senddata_queue_sem_) != 0)
-    {
-        XMNLogStdErr(0, "XMNSocket::WaitWriteRequestHandler()执行失败。");
-    }
-    pconnsockinfo->FreeSendDataMem();
-    pconnsockinfo->psendalldataforfree = nullptr;
-    pconnsockinfo->psenddata = nullptr;
-    pconnsockinfo->senddatalen = 0;
-    --pconnsockinfo->throwepollsendcount;
     /**
      * TODO：增加连接池的回收，用于处理未知的错误。
      * time 2020-03-15
     */
-    if (sendsize < 0)
+    if (r < 0)
     {
+        XMNLogStdErr(0, "XMNSocket::WaitWriteRequestHandler()执行 SendData 时发生了错误。");
         ActivelyCloseSocket(pconnsockinfo);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,244 @@
+#include "comm/xmn_socket.h"
+#include "comm/xmn_socket_logic_comm.h"
+#include "xmn_global.h"
+#include "xmn_func.h"
+#include "xmn_macro.h"
+#include "xmn_crc32.h"
+
+#include "sys/socket.h"
+#include "sys/random.h"
+#include "linux/filter.h"
+#include "arpa/inet.h"
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+int XMNSocket::OpenUdpSocket()
+{
+    if (udpport_ == 0)
+    {
+        return 0;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(struct sockaddr_in));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(udpport_);
+
+    /**
+     * （1）按 worker 编号的顺序为每个 worker 进程创建一个 socket ，保证其在 reuseport 组中的下标就是 worker 编号。
+    */
+    int exitcode = 0;
+    for (size_t w = 0; w < worker_process_count_; ++w)
+    {
+        int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (sockfd < 0)
+        {
+            XMNLogInfo(XMN_LOG_EMERG, errno, "OpenUdpSocket create udp socket failed.");
+            exitcode = -1;
+            goto exitlabel;
+        }
+        vudpsockfd_.push_back(sockfd);
+
+        int reuseport = 1;
+        if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, (const void *)&reuseport, sizeof(int)) != 0)
+        {
+            XMNLogInfo(XMN_LOG_EMERG, errno, "OpenUdpSocket setsockopt(SO_REUSEPORT) failed.");
+            exitcode = -2;
+            goto exitlabel;
+        }
+        if (SetNonBlocking(sockfd) != 0)
+        {
+            XMNLogInfo(XMN_LOG_EMERG, errno, "OpenUdpSocket SetNonBlocking failed.");
+            exitcode = -3;
+            goto exitlabel;
+        }
+        if (bind(sockfd, (struct sockaddr *)&addr, sizeof(struct sockaddr_in)) != 0)
+        {
+            XMNLogInfo(XMN_LOG_EMERG, errno, "OpenUdpSocket bind failed.");
+            exitcode = -4;
+            goto exitlabel;
+        }
+    }
+
+    /**
+     * （2）CBPF 程序看到的数据从 UDP 的负载开始：
+     * A = 包体开头的 worker 编号，即：XMNUdpToken::workerindex ；
+     * A = A % worker 进程数量；
+     * return A 。
+     * 数据报太短时程序返回 0 ，由 worker 0 校验之后丢弃。
+     * 只有一个 worker 进程时不需要挂载。
+    */
+    if (worker_process_count_ > 1)
+    {
+        struct sock_filter code[] = {
+            {BPF_LD | BPF_W | BPF_ABS, 0, 0, (uint32_t)sizeof(XMNPkgHeader)},
+            {BPF_ALU | BPF_MOD | BPF_K, 0, 0, (uint32_t)worker_process_count_},
+            {BPF_RET | BPF_A, 0, 0, 0},
+        };
+        struct sock_fprog prog;
+        prog.len = sizeof(code) / sizeof(struct sock_filter);
+        prog.filter = code;
+        if (setsockopt(vudpsockfd_[0], SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, (const void *)&prog, sizeof(prog)) != 0)
+        {
+            XMNLogInfo(XMN_LOG_EMERG, errno, "OpenUdpSocket 挂载 reuseport CBPF 程序失败，UDP 心跳无法送达对应的 worker 进程。");
+            exitcode = -2;
+            goto exitlabel;
+        }
+    }
+    XMNLogInfo(XMN_LOG_INFO, 0, "接收 UDP 心跳的端口 %d 的 socket 创建成功！", udpport_);
+    return 0;
+
+exitlabel:
+    for (const auto &x : vudpsockfd_)
+    {
+        close(x);
+    }
+    vudpsockfd_.clear();
+    return exitcode;
+}
+
+int XMNSocket::IssueUdpToken(XMNConnSockInfo *pconnsockinfo, XMNUdpToken *ptoken)
+{
+    if (udpport_ == 0)
+    {
+        return -1;
+    }
+
+    /**
+     * 随机数不能为 0 ，0 表示没有申请过令牌。getrandom 不可用时（Linux 3.17 以下）退而使用时间。
+    */
+    uint32_t nonce = 0;
+    while (nonce == 0)
+    {
+        if (getrandom(&nonce, sizeof(nonce), 0) != sizeof(nonce))
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            nonce = (uint32_t)ts.tv_nsec ^ ((uint32_t)ts.tv_sec << 16) ^ pconnsockinfo->slotindex;
+        }
+    }
+    pconnsockinfo->udpnonce = nonce;
+
+    const XMNConnHandle kConnHandle = pconnsockinfo->Handle();
+    ptoken->workerindex = htonl((uint32_t)g_xmn_worker_index);
+    ptoken->slotindex = htonl((uint32_t)(kConnHandle >> 32));
+    ptoken->generation = htonl((uint32_t)kConnHandle);
+    ptoken->nonce = htonl(nonce);
+    return 0;
+}
+
+void XMNSocket::UdpRequestHandler(XMNConnSockInfo *pconnsockinfo)
+{
+    UdpBatch *pbatch = pudpbatch_;
+    XMNCRC32 &crc32 = SingletonBase<XMNCRC32>::GetInstance();
+    const size_t kDgramLen = kPkgHeaderLen_ + sizeof(XMNUdpToken);
+    const time_t kCurrentTime = time(nullptr);
+
+    while (true)
+    {
+        /**
+         * （1）通过 recvmmsg 一次读取多个数据报。
+        */
+        for (int i = 0; i < XMN_UDP_BATCH_MAX_MSGS; ++i)
+        {
+            pbatch->recviov[i].iov_base = pbatch->recvbuf[i];
+            pbatch->recviov[i].iov_len = XMN_UDP_DGRAM_MAX_LEN;
+            memset(&pbatch->recvmsgs[i], 0, sizeof(struct mmsghdr));
+            pbatch->recvmsgs[i].msg_hdr.msg_name = &pbatch->addrs[i];
+            pbatch->recvmsgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+            pbatch->recvmsgs[i].msg_hdr.msg_iov = &pbatch->recviov[i];
+            pbatch->recvmsgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int count = recvmmsg(pconnsockinfo->fd, pbatch->recvmsgs, XMN_UDP_BATCH_MAX_MSGS, MSG_DONTWAIT, nullptr);
+        if (count <= 0)
+        {
+            if (count < 0 && errno != EAGAIN && errno != EINTR)
+            {
+                XMNLogInfo(XMN_LOG_ERR, errno, "UdpRequestHandler 中 recvmmsg 执行失败！");
+            }
+            return;
+        }
+
+        /**
+         * （2）校验每个心跳包，按照令牌找到对应的 TCP 连接，更新心跳时间并组合回复。
+         * 令牌中的代数和随机数都匹配时才认为是该连接的心跳，连接关闭或者重新申请令牌之后旧的令牌失效。
+        */
+        int replycount = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            struct mmsghdr *pmsg = &pbatch->recvmsgs[i];
+            XMNPkgHeader *ppkgheader = (XMNPkgHeader *)pbatch->recvbuf[i];
+            XMNUdpToken *ptoken = (XMNUdpToken *)(pbatch->recvbuf[i] + kPkgHeaderLen_);
+            if ((pmsg->msg_hdr.msg_flags & MSG_TRUNC) ||
+                pmsg->msg_len != kDgramLen ||
+                ntohs(ppkgheader->pkglen) != kDgramLen ||
+                ntohs(ppkgheader->msgcode) != CMD_LOGIC_PING ||
+                (int)ntohl(ppkgheader->crc32) != crc32.GetCRC32((unsigned char *)ptoken, sizeof(XMNUdpToken)) ||
+                (int)ntohl(ptoken->workerindex) != g_xmn_worker_index)
+            {
+                ++udpdropcount_;
+                continue;
+            }
+            const XMNConnHandle kConnHandle = ((XMNConnHandle)ntohl(ptoken->slotindex) << 32) | ntohl(ptoken->generation);
+            const uint32_t kNonce = ntohl(ptoken->nonce);
+            XMNConnSockInfo *pconnsockinfo_ping = GetConnSockInfo(kConnHandle);
+            if (pconnsockinfo_ping == nullptr || kNonce == 0 || pconnsockinfo_ping->udpnonce != kNonce)
+            {
+                ++udpdropcount_;
+                continue;
+            }
+            pconnsockinfo_ping->lastpingtime = kCurrentTime;
+            ++udppingcount_;
+
+            /**
+             * 回复与 TCP 心跳相同的无包体的包，发往该数据报的来源地址。
+            */
+            XMNPkgHeader *ppkgheader_send = (XMNPkgHeader *)pbatch->sendbuf[replycount];
+            ppkgheader_send->pkglen = htons(kPkgHeaderLen_);
+            ppkgheader_send->msgcode = htons(CMD_LOGIC_PING);
+            ppkgheader_send->crc32 = 0;
+            pbatch->sendiov[replycount].iov_base = ppkgheader_send;
+            pbatch->sendiov[replycount].iov_len = kPkgHeaderLen_;
+            memset(&pbatch->sendmsgs[replycount], 0, sizeof(struct mmsghdr));
+            pbatch->sendmsgs[replycount].msg_hdr.msg_name = &pbatch->addrs[i];
+            pbatch->sendmsgs[replycount].msg_hdr.msg_namelen = pmsg->msg_hdr.msg_namelen;
+            pbatch->sendmsgs[replycount].msg_hdr.msg_iov = &pbatch->sendiov[replycount];
+            pbatch->sendmsgs[replycount].msg_hdr.msg_iovlen = 1;
+            ++replycount;
+        }
+
+        /**
+         * （3）通过 sendmmsg 一次发送所有的回复，发送缓冲区满时丢弃剩余的回复，client 会重发心跳。
+        */
+        int sentcount = 0;
+        while (sentcount < replycount)
+        {
+            int r = sendmmsg(pconnsockinfo->fd, pbatch->sendmsgs + sentcount, replycount - sentcount, MSG_DONTWAIT);
+            if (r <= 0)
+            {
+                if (r < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (r < 0 && errno != EAGAIN)
+                {
+                    XMNLogInfo(XMN_LOG_ERR, errno, "UdpRequestHandler 中 sendmmsg 执行失败！");
+                }
+                udpdropcount_ += replycount - sentcount;
+                break;
+            }
+            sentcount += r;
+        }
+
+        /**
+         * 没有读满说明已经读完了。
+        */
+        if (count < XMN_UDP_BATCH_MAX_MSGS)
+        {
+            return;
+        }
+    }
+}
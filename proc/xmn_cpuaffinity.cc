@@ -0,0 +1,254 @@
+#include "xmn_cpuaffinity.h"
+#include "xmn_config.h"
+#include "xmn_func.h"
+#include "xmn_macro.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+
+XMNCpuAffinity::XMNCpuAffinity()
+{
+    mode_ = XMN_CPU_AFFINITY_NONE;
+}
+
+int XMNCpuAffinity::ReadConf()
+{
+    XMNConfig &config = SingletonBase<XMNConfig>::GetInstance();
+
+    /**
+     * （1）绑定的方式。
+    */
+    mode_ = std::stoi(config.GetConfigItem("CpuAffinityMode", "0"));
+    if (mode_ != XMN_CPU_AFFINITY_NONE && mode_ != XMN_CPU_AFFINITY_WORKER && mode_ != XMN_CPU_AFFINITY_REACTOR)
+    {
+        return -1;
+    }
+
+    /**
+     * （2）事件循环以及业务逻辑线程可以使用的核，不配置时为空。
+    */
+    if (ParseCpuList(config.GetConfigItem("IoCpuList", ""), viocpus_) != 0)
+    {
+        return -2;
+    }
+    if (ParseCpuList(config.GetConfigItem("LogicCpuList", ""), vlogiccpus_) != 0)
+    {
+        return -3;
+    }
+    return 0;
+}
+
+void XMNCpuAffinity::Plan(const size_t &kWorkerIndex, const size_t &kWorkerCount, const size_t &kLoopCount, const bool &kIsCpuSteering)
+{
+    const int kCpuCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    std::vector<int> viocpus = viocpus_;
+    if (viocpus.empty())
+    {
+        for (int i = 0; i < kCpuCount; ++i)
+        {
+            viocpus.push_back(i);
+        }
+    }
+
+    /**
+     * （1）事件循环所在的核。
+     * reuseport 的 CPU 分配策略要求 worker n 的事件循环位于 CPU n 上，此时忽略 IoCpuList 。
+    */
+    vloopcpu_.clear();
+    for (size_t i = 0; i < kLoopCount; ++i)
+    {
+        if (kIsCpuSteering)
+        {
+            vloopcpu_.push_back((int)(kWorkerIndex % kCpuCount));
+        }
+        else if (mode_ == XMN_CPU_AFFINITY_REACTOR)
+        {
+            vloopcpu_.push_back(viocpus[(kWorkerIndex * kLoopCount + i) % viocpus.size()]);
+        }
+        else
+        {
+            vloopcpu_.push_back(viocpus[kWorkerIndex % viocpus.size()]);
+        }
+    }
+
+    /**
+     * （2）业务逻辑线程和发送数据线程所在的核。
+     * 配置了 LogicCpuList 时，将其按 worker 进程的数量分组，每个 worker 使用其中一组；
+     * 否则与本 worker 的事件循环共用核及其超线程兄弟核。
+    */
+    vlogicplan_.clear();
+    if (!vlogiccpus_.empty())
+    {
+        if (vlogiccpus_.size() >= kWorkerCount)
+        {
+            for (size_t i = kWorkerIndex % kWorkerCount; i < vlogiccpus_.size(); i += kWorkerCount)
+            {
+                vlogicplan_.push_back(vlogiccpus_[i]);
+            }
+        }
+        else
+        {
+            vlogicplan_.push_back(vlogiccpus_[kWorkerIndex % vlogiccpus_.size()]);
+        }
+    }
+    else
+    {
+        for (const auto &x : vloopcpu_)
+        {
+            AddSiblings(x, vlogicplan_);
+        }
+    }
+    std::sort(vlogicplan_.begin(), vlogicplan_.end());
+    vlogicplan_.erase(std::unique(vlogicplan_.begin(), vlogicplan_.end()), vlogicplan_.end());
+}
+
+int XMNCpuAffinity::BindLogicThreads()
+{
+    if (BindCurrentThread(vlogicplan_) != 0)
+    {
+        XMNLogInfo(XMN_LOG_ALERT, errno, "XMNCpuAffinity::BindLogicThreads 中绑定 CPU %s 失败！", CpuListToString(vlogicplan_).c_str());
+        return -1;
+    }
+    return 0;
+}
+
+int XMNCpuAffinity::BindEventLoop(const size_t &kLoopIndex)
+{
+    if (kLoopIndex >= vloopcpu_.size())
+    {
+        return -1;
+    }
+    std::vector<int> vcpus(1, vloopcpu_[kLoopIndex]);
+    if (BindCurrentThread(vcpus) != 0)
+    {
+        XMNLogInfo(XMN_LOG_ALERT, errno, "XMNCpuAffinity::BindEventLoop 中事件循环 %d 绑定 CPU %d 失败！", (int)kLoopIndex, vcpus[0]);
+        return -1;
+    }
+    return 0;
+}
+
+void XMNCpuAffinity::Report(const size_t &kWorkerIndex) const
+{
+    std::string strloop;
+    for (size_t i = 0; i < vloopcpu_.size(); ++i)
+    {
+        strloop += (i > 0 ? "，" : "") + std::to_string(i) + " -> CPU " + std::to_string(vloopcpu_[i]);
+    }
+    XMNLogInfo(XMN_LOG_NOTICE, 0, "编号为 %d 的 worker 进程的 CPU 绑定：事件循环（%s），业务逻辑线程和发送数据线程（CPU %s）。",
+               (int)kWorkerIndex, strloop.c_str(), CpuListToString(vlogicplan_).c_str());
+}
+
+int XMNCpuAffinity::ParseCpuList(const std::string &kstrCpuList, std::vector<int> &vcpus)
+{
+    vcpus.clear();
+    size_t i = 0;
+    const size_t kLen = kstrCpuList.size();
+    while (i < kLen)
+    {
+        /**
+         * 跳过分隔符以及配置文件读取时残留的空白字符。
+        */
+        if (kstrCpuList[i] == ',' || kstrCpuList[i] == ' ' || kstrCpuList[i] == '\0')
+        {
+            ++i;
+            continue;
+        }
+
+        /**
+         * 读取 "a" 或者 "a-b" 。
+        */
+        int first = -1;
+        int last = -1;
+        int *pcurr = &first;
+        while (i < kLen && kstrCpuList[i] != ',' && kstrCpuList[i] != ' ' && kstrCpuList[i] != '\0')
+        {
+            const char c = kstrCpuList[i++];
+            if (c >= '0' && c <= '9')
+            {
+                *pcurr = (*pcurr < 0 ? 0 : *pcurr * 10) + (c - '0');
+                if (*pcurr >= CPU_SETSIZE)
+                {
+                    return -1;
+                }
+            }
+            else if (c == '-' && pcurr == &first && first >= 0)
+            {
+                pcurr = &last;
+            }
+            else
+            {
+                return -1;
+            }
+        }
+        if (first < 0 || (pcurr == &last && last < first))
+        {
+            return -1;
+        }
+        if (pcurr == &first)
+        {
+            last = first;
+        }
+        for (int cpu = first; cpu <= last; ++cpu)
+        {
+            vcpus.push_back(cpu);
+        }
+    }
+    std::sort(vcpus.begin(), vcpus.end());
+    vcpus.erase(std::unique(vcpus.begin(), vcpus.end()), vcpus.end());
+    return 0;
+}
+
+void XMNCpuAffinity::AddSiblings(const int &kCpu, std::vector<int> &vcpus)
+{
+    /**
+     * 读取不到拓扑信息（例如容器中）时，只使用该核本身。
+    */
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", kCpu);
+    std::ifstream fin(path, std::ios::in);
+    std::string strsiblings;
+    std::vector<int> vsiblings;
+    if (getline(fin, strsiblings) && ParseCpuList(strsiblings, vsiblings) == 0 && !vsiblings.empty())
+    {
+        vcpus.insert(vcpus.end(), vsiblings.begin(), vsiblings.end());
+        return;
+    }
+    vcpus.push_back(kCpu);
+}
+
+int XMNCpuAffinity::BindCurrentThread(const std::vector<int> &vcpus)
+{
+    if (vcpus.empty())
+    {
+        return -1;
+    }
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (const auto &x : vcpus)
+    {
+        CPU_SET(x, &cpuset);
+    }
+    int r = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+    if (r != 0)
+    {
+        errno = r;
+        return -1;
+    }
+    return 0;
+}
+
+std::string XMNCpuAffinity::CpuListToString(const std::vector<int> &vcpus)
+{
+    std::string str;
+    for (size_t i = 0; i < vcpus.size(); ++i)
+    {
+        str += (i > 0 ? "," : "") + std::to_string(vcpus[i]);
+    }
+    return str;
+}
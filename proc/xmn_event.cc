@@ -3,12 +3,18 @@
 int XMNProcessEventsTimers()
 {
     /**
-     * （1）处理网络事件。
+     * （1）决定本进程是否参与 accept 新连接。
     */
-    g_socket.EpollProcessEvents(-1);
+    int timer = g_socket.ProcessAcceptBalance();
 
     /**
-     * （2）在终端显示统计信息。
+     * （2）处理网络事件。
+    */
+    g_socket.EpollProcessEvents(timer);
+    g_socket.ReleaseAcceptMutex();
+
+    /**
+     * （3）在终端显示统计信息。
     */
     g_socket.PrintInfo();
     
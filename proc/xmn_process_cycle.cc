@@ -6,12 +6,14 @@
 #include "xmn_func.h"
 #include "xmn_global.h"
 #include "xmn_config.h"
+#include "xmn_cpuaffinity.h"
 
 #include <signal.h>
 #include <iostream>
 #include <errno.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sched.h>
 
 /**
  * master 进程标题。
@@ -105,6 +107,11 @@ void XMNMasterProcessCycle()
     const size_t kWorkerProcessCount = std::stoi(config.GetConfigItem("WorkerProcesses", "4"));
     XMNStartWorkerProcess(kWorkerProcessCount);
 
+    /**
+     * worker 进程独占的监听 socket 已经被各个 worker 进程继承，master 进程不再需要持有。
+    */
+    g_socket.CloseWorkerListenSocket(-1);
+
     /**
      * （4）清空 set 信号集。
     */
@@ -186,6 +193,7 @@ static int XMNWorkerProcessCycle(const size_t &kNum, const std::string &kstrProc
      * （1）worker 进程初始化。
     */
     g_xmn_process_type = XMN_PROCESS_WORKER;
+    g_xmn_worker_index = kNum;
     r = XMNWorkerProcessInit(kNum, kstrProcName);
     if (r != 0)
     {
@@ -225,15 +233,49 @@ static int XMNWorkerProcessInit(const size_t &kNum, const std::string &kstrProcN
         return -1;
     }
     /**
-     * （2）创建线程池。
+     * 开启了 CPU 绑定时，先将 worker 进程绑定到业务逻辑线程和发送数据线程使用的核上，
+     * 之后创建的线程继承该设置，事件循环在 EpollInit 之后再绑定到各自的核上。
+     * 开启了 reuseport 的 CPU 分配策略时，将 worker 进程绑定到编号对应的 CPU 上，
+     * 使得由该 CPU 接收的连接始终由同一个 worker 进程处理。
+     * 必须在创建线程之前绑定，以便之后创建的线程继承该设置。
     */
     XMNConfig &config = SingletonBase<XMNConfig>::GetInstance();
+    XMNCpuAffinity &cpuaffinity = SingletonBase<XMNCpuAffinity>::GetInstance();
+    int r = cpuaffinity.ReadConf();
+    if (r != 0)
+    {
+        XMNLogInfo(XMN_LOG_ALERT, 0, "XMNWorkerProcessInit 中读取 CPU 绑定的配置失败，错误代码为 %d 。", r);
+        return -1;
+    }
+    if (cpuaffinity.IsEnabled())
+    {
+        cpuaffinity.Plan(kNum,
+                         std::stoi(config.GetConfigItem("WorkerProcesses", "1")),
+                         g_socket.ReactorThreadCount() + 1,
+                         g_socket.IsReusePortCpuSteering());
+        cpuaffinity.BindLogicThreads();
+    }
+    else if (g_socket.IsReusePortCpuSteering())
+    {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(kNum % sysconf(_SC_NPROCESSORS_ONLN), &cpuset);
+        if (sched_setaffinity(0, sizeof(cpu_set_t), &cpuset) == -1)
+        {
+            XMNLogInfo(XMN_LOG_ALERT, errno, "XMNWorkerProcessInit 中编号为 %d 的子进程绑定 CPU 失败！", kNum);
+        }
+    }
+
+    /**
+     * （2）创建线程池。
+    */
     const size_t kThreadPoolSize = std::stoi(config.GetConfigItem("ThreadPoolSize", "100"));
+    const size_t kDrrQuantum = std::stoi(config.GetConfigItem("ThreadPoolDrrQuantum", "4096"));
 
     /**
      * TODO：这里需要判断该函数的返回值。
     */
-    if (g_threadpool.Create(kThreadPoolSize))
+    if (g_threadpool.Create(kThreadPoolSize, kDrrQuantum))
     {
         return -2;
     }
@@ -249,13 +291,22 @@ static int XMNWorkerProcessInit(const size_t &kNum, const std::string &kstrProcN
      * （4）初始化 epoll ，并向 epoll 添加监听事件。
      * TODO：这里需要判断该函数的返回值。
     */
-    const int r = g_socket.EpollInit();
+    r = g_socket.EpollInit();
     if (r != 0)
     {
         return -4;
     }
+
+    /**
+     * （5）所有的线程都已经创建，主事件循环绑定到自己的核上，并输出 CPU 的分配情况。
+    */
+    if (cpuaffinity.IsEnabled())
+    {
+        cpuaffinity.BindEventLoop(0);
+        cpuaffinity.Report(kNum);
+    }
     /**
-     * （5）设置进程标题。
+     * （6）设置进程标题。
     */
     XMNSetProcTitle(kstrProcName);
 
@@ -304,6 +304,12 @@ void XMNProcessGetStatus()
             }
         }
         one = 1;
+
+        /**
+         * 退出的 worker 进程可能正持有 accept 互斥量，例如崩溃或者被 kill 时，需要强制释放。
+        */
+        g_socket.ForceReleaseAcceptMutex(pid);
+
         /**
          * 取得子进程因信号而中止的信号。
         */